@@ -3,7 +3,7 @@ require("./tools/premake5/premake-ps4")
 -- premake5.lua
 workspace "HelloWorld"
 	configurations { "Debug", "Release" }
-	platforms { "x64", "Orbis" }
+	platforms { "x64", "Orbis", "Linux" }
 	
 project "HelloWorld"
 	kind "ConsoleApp" 	-- can also be "WindowedApp"
@@ -14,7 +14,7 @@ project "HelloWorld"
 	targetdir "build/%{cfg.platform}/bin/%{cfg.buildcfg}"
 	objdir "build/%{cfg.platform}/bin/%{cfg.buildcfg}/obj"
 
-	files { "**.h", "**.cpp" }
+	files { "src/**.h", "src/**.cpp" }
 	-- Clean Function --
 	newaction {
 		trigger     = "clean",
@@ -28,13 +28,52 @@ project "HelloWorld"
 		end
 	}
 
+	newoption {
+		trigger     = "config",
+		value       = "CONFIG",
+		description = "configuration the test and bench actions run, Debug or Release",
+		default     = "Release"
+	}
+
+	-- runs the executables built from the matching files in tests/, fails if any of them does
+	function runTestExecutables(pattern)
+		local failed = 0
+		for _, source in ipairs(os.matchfiles(pattern)) do
+			local name = path.getbasename(source)
+			print("== " .. name)
+			if not os.execute("build/Linux/bin/" .. _OPTIONS["config"] .. "/" .. name) then
+				failed = failed + 1
+			end
+		end
+		if failed > 0 then
+			error(failed .. " executable(s) failed")
+		end
+	end
+
+	newaction {
+		trigger     = "test",
+		description = "run the Linux tests (build the Linux platform first)",
+		execute     = function ()
+			runTestExecutables("tests/*Test.cpp")
+		end
+	}
+
+	newaction {
+		trigger     = "bench",
+		description = "run the Linux benchmarks (build the Linux platform first)",
+		execute     = function ()
+			runTestExecutables("tests/*Bench.cpp")
+		end
+	}
+
 	filter { "platforms:x64" }
 		defines "PLATFORM_WINDOWS"
 		system "Windows"
 		architecture "x86_64"
 		links {
 			"Xinput.lib",
-			"Xinput9_1_0.lib"
+			"Xinput9_1_0.lib",
+			"Winmm.lib"
 		}
 		buildoptions { "-Wno-address-of-temporary" }
 		toolset ("clang")
@@ -48,10 +87,53 @@ project "HelloWorld"
 			"SceSaveData_stub_weak"
 		}
 	
+	-- headless build for CI / profiling: POSIX threads, clock and file saves, virtual gamepad
+	filter { "platforms:Linux" }
+		defines "PLATFORM_LINUX"
+		system "Linux"
+		architecture "x86_64"
+		links { "pthread" }
+		buildoptions { "-pthread" }
+	
 	filter "configurations:Debug"
 		defines { "DEBUG" }
 		symbols "On"
 		
 	filter "configurations:Release"
 		defines { "NDEBUG", "RELEASE" }
-		optimize "On"
\ No newline at end of file
+		optimize "On"
+
+filter {}
+
+-- Linux-only tests (tests/*Test.cpp) and benchmarks (tests/*Bench.cpp). Every file is a console app of its own, a
+-- single translation unit like the game, since the headers define their globals
+for _, source in ipairs(os.matchfiles("tests/*.cpp")) do
+	project(path.getbasename(source))
+		kind "ConsoleApp"
+		language "C++"
+		cppdialect "C++14"
+		fatalwarnings { "warnings" }
+		removeplatforms { "x64", "Orbis" }
+
+		targetdir "build/%{cfg.platform}/bin/%{cfg.buildcfg}"
+		objdir "build/%{cfg.platform}/bin/%{cfg.buildcfg}/obj/%{prj.name}"
+
+		files { source, "tests/*.h" }
+		includedirs { "src", "tests" }
+
+		defines "PLATFORM_LINUX"
+		system "Linux"
+		architecture "x86_64"
+		links { "pthread" }
+		buildoptions { "-pthread" }
+
+		filter "configurations:Debug"
+			defines { "DEBUG" }
+			symbols "On"
+
+		filter "configurations:Release"
+			defines { "NDEBUG", "RELEASE" }
+			optimize "On"
+
+		filter {}
+end
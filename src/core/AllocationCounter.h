@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Counts every allocation that goes through the global operator new, on all threads.
+ *
+ * The game reads the counter around its frames to verify that nothing allocates once it's warmed up. The
+ * replaced operators forward to malloc / free and add two relaxed atomic increments per allocation.
+ *
+ * Replacing the global operators has to happen in exactly one translation unit, so include this header from
+ * main.cpp only. Defining RELEASE (or ALLOCATION_COUNTER_ENABLED 0) keeps the standard operators and the
+ * counters always read zero.
+ */
+
+#ifndef ALLOCATION_COUNTER_ENABLED
+	#if defined( RELEASE )
+		#define ALLOCATION_COUNTER_ENABLED 0
+	#else
+		#define ALLOCATION_COUNTER_ENABLED 1
+	#endif
+#endif
+
+#if defined( __GNUC__ )
+	#define ALLOCATION_COUNTER_NOINLINE __attribute__( ( noinline ) )
+#else
+	#define ALLOCATION_COUNTER_NOINLINE
+#endif
+
+class AllocationCounter
+{
+public:
+	/*
+	 * Allocations since startup
+	 */
+	static uint64_t GetCount()
+	{
+#if ALLOCATION_COUNTER_ENABLED
+		return Count.load( std::memory_order_relaxed );
+#else
+		return 0u;
+#endif
+	}
+
+	/*
+	 * Bytes requested by these allocations, frees aren't subtracted
+	 */
+	static uint64_t GetBytes()
+	{
+#if ALLOCATION_COUNTER_ENABLED
+		return Bytes.load( std::memory_order_relaxed );
+#else
+		return 0u;
+#endif
+	}
+
+#if ALLOCATION_COUNTER_ENABLED
+	static void* Allocate( size_t size )
+	{
+		Count.fetch_add( 1u, std::memory_order_relaxed );
+		Bytes.fetch_add( size, std::memory_order_relaxed );
+		// operator new has to hand out a unique pointer for zero bytes as well
+		return malloc( size != 0u ? size : 1u );
+	}
+
+	/*
+	 * Kept out of line, GCC would otherwise see the inlined free pair up with operator new and warn
+	 */
+	ALLOCATION_COUNTER_NOINLINE static void Release( void* memory ) noexcept
+	{
+		free( memory );
+	}
+
+private:
+	static std::atomic< uint64_t > Count;
+	static std::atomic< uint64_t > Bytes;
+#endif
+};
+
+#if ALLOCATION_COUNTER_ENABLED
+
+std::atomic< uint64_t > AllocationCounter::Count { 0u };
+std::atomic< uint64_t > AllocationCounter::Bytes { 0u };
+
+void* operator new( size_t size )
+{
+	void* memory = AllocationCounter::Allocate( size );
+	if ( memory == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[]( size_t size )
+{
+	return operator new( size );
+}
+
+void* operator new( size_t size, const std::nothrow_t& ) noexcept
+{
+	return AllocationCounter::Allocate( size );
+}
+
+void* operator new[]( size_t size, const std::nothrow_t& ) noexcept
+{
+	return AllocationCounter::Allocate( size );
+}
+
+void operator delete( void* memory ) noexcept
+{
+	AllocationCounter::Release( memory );
+}
+
+void operator delete[]( void* memory ) noexcept
+{
+	AllocationCounter::Release( memory );
+}
+
+void operator delete( void* memory, size_t ) noexcept
+{
+	AllocationCounter::Release( memory );
+}
+
+void operator delete[]( void* memory, size_t ) noexcept
+{
+	AllocationCounter::Release( memory );
+}
+
+void operator delete( void* memory, const std::nothrow_t& ) noexcept
+{
+	AllocationCounter::Release( memory );
+}
+
+void operator delete[]( void* memory, const std::nothrow_t& ) noexcept
+{
+	AllocationCounter::Release( memory );
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include "ClockPS4.h"
 #elif PLATFORM_WINDOWS
 #include "ClockWin.h"
+#elif PLATFORM_LINUX
+#include "ClockLinux.h"
 #else
 #pragma error "Unsupported platform"
 #endif
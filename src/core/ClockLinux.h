@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+#include <time.h>
+
+#include "ClockTypes.h"
+
+/*
+ * Monotonic clock that keeps everything in integer counter cycles / nanoseconds. Reads don't take any lock and
+ * only touch the (read-only after Init) frequency, so they are cheap enough to call per event.
+ */
+class ClockLinux
+{
+public:
+	
+	typedef uint64_t Cycles;
+
+	static void Init()
+	{
+		// CLOCK_MONOTONIC already counts in nanoseconds
+		Frequency = 1000000000u;
+	}
+
+	static Cycles QueryCycles()
+	{
+		timespec now;
+		clock_gettime( CLOCK_MONOTONIC, &now );
+		return static_cast< Cycles >( now.tv_sec ) * 1000000000u + static_cast< Cycles >( now.tv_nsec );
+	}
+
+	static TimePoint Now()
+	{
+		return TimePoint::FromNanoseconds( CyclesToNanoseconds( QueryCycles(), Frequency ) );
+	}
+
+	static Duration ToDuration( Cycles cycles )
+	{
+		return Duration::FromNanoseconds( CyclesToNanoseconds( cycles, Frequency ) );
+	}
+
+	ClockLinux()
+		: StartCycles( 0u )
+	{
+		Start();
+	}
+	
+	void Start()
+	{
+		StartCycles = QueryCycles();
+		IsRunning = true;
+	}
+
+	void Stop()
+	{
+		StartCycles = 0u;
+		IsRunning = false;
+	}
+
+	Cycles QueryPassedCycles() const
+	{
+		if ( !IsRunning )
+		{
+			return 0;
+		}
+		
+		return ( QueryCycles() - StartCycles );
+	}
+
+	Duration Elapsed() const
+	{
+		return ToDuration( QueryPassedCycles() );
+	}
+
+	// @note - float conversions are for printing only, use Elapsed() for anything that accumulates
+	float ToMilliseconds() const
+	{
+		return Elapsed().ToMillisecondsF();
+	}
+
+	float ToSecond() const
+	{
+		return Elapsed().ToSecondsF();
+	}
+
+private:
+	bool IsRunning { false };
+	Cycles StartCycles { 0u };
+	static Cycles Frequency;
+};
+
+ClockLinux::Cycles ClockLinux::Frequency = 1000000000u;
+
+typedef ClockLinux Clock;
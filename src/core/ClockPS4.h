@@ -4,6 +4,12 @@
 
 #include "kernel.h"
 
+#include "ClockTypes.h"
+
+/*
+ * Monotonic clock that keeps everything in integer counter cycles / nanoseconds. Reads don't take any lock and
+ * only touch the (read-only after Init) frequency, so they are cheap enough to call per event.
+ */
 class ClockPS4
 {
 public:
@@ -12,8 +18,22 @@ public:
 
 	static void Init()
 	{
-		const uint64_t Frequency = sceKernelGetProcessTimeCounterFrequency();
-		OneOverFrequency = 1.0f / static_cast< float >( Frequency );
+		Frequency = sceKernelGetProcessTimeCounterFrequency();
+	}
+
+	static Cycles QueryCycles()
+	{
+		return sceKernelGetProcessTimeCounter();
+	}
+
+	static TimePoint Now()
+	{
+		return TimePoint::FromNanoseconds( CyclesToNanoseconds( QueryCycles(), Frequency ) );
+	}
+
+	static Duration ToDuration( Cycles cycles )
+	{
+		return Duration::FromNanoseconds( CyclesToNanoseconds( cycles, Frequency ) );
 	}
 
 	ClockPS4()
@@ -24,7 +44,7 @@ public:
 	
 	void Start()
 	{
-		StartCycles = sceKernelGetProcessTimeCounter();
+		StartCycles = QueryCycles();
 		IsRunning = true;
 	}
 
@@ -36,32 +56,36 @@ public:
 
 	Cycles QueryPassedCycles() const
 	{
-		if (!IsRunning)
+		if ( !IsRunning )
 		{
 			return 0;
 		}
 		
-		Cycles PassedCycles = 0u;
-		PassedCycles = sceKernelGetProcessTimeCounter();
-		return ( PassedCycles - StartCycles );
+		return ( QueryCycles() - StartCycles );
+	}
+
+	Duration Elapsed() const
+	{
+		return ToDuration( QueryPassedCycles() );
 	}
 
+	// @note - float conversions are for printing only, use Elapsed() for anything that accumulates
 	float ToMilliseconds() const
 	{
-		return ( static_cast< float >( QueryPassedCycles() ) * OneOverFrequency ) * 1000.0f;
+		return Elapsed().ToMillisecondsF();
 	}
 
 	float ToSecond() const
 	{
-		return static_cast< float >( QueryPassedCycles() ) * OneOverFrequency;
+		return Elapsed().ToSecondsF();
 	}
 
 private:
 	bool IsRunning { false };
 	Cycles StartCycles { 0u };
-	static float OneOverFrequency;
+	static Cycles Frequency;
 };
 
-float ClockPS4::OneOverFrequency = 1.0f;
+ClockPS4::Cycles ClockPS4::Frequency = 1u;
 
 typedef ClockPS4 Clock;
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Span of time with nanosecond resolution. Stored as a signed 64 bit integer, which covers ~292 years, so
+ * adding up frame times never loses precision no matter how long the session runs.
+ */
+class Duration
+{
+public:
+	constexpr Duration() = default;
+
+	static constexpr Duration FromNanoseconds( int64_t nanoseconds ) { return Duration( nanoseconds ); }
+	static constexpr Duration FromMicroseconds( int64_t microseconds ) { return Duration( microseconds * 1000 ); }
+	static constexpr Duration FromMilliseconds( int64_t milliseconds ) { return Duration( milliseconds * 1000000 ); }
+	static constexpr Duration FromSeconds( int64_t seconds ) { return Duration( seconds * 1000000000 ); }
+
+	constexpr int64_t ToNanoseconds() const { return Nanoseconds; }
+	constexpr int64_t ToMicroseconds() const { return Nanoseconds / 1000; }
+	constexpr int64_t ToMilliseconds() const { return Nanoseconds / 1000000; }
+
+	// floating point views are only meant for printing / statistics, never for accumulation
+	constexpr float ToMillisecondsF() const { return static_cast< float >( static_cast< double >( Nanoseconds ) / 1000000.0 ); }
+	constexpr float ToSecondsF() const { return static_cast< float >( static_cast< double >( Nanoseconds ) / 1000000000.0 ); }
+
+	constexpr Duration operator+( Duration other ) const { return Duration( Nanoseconds + other.Nanoseconds ); }
+	constexpr Duration operator-( Duration other ) const { return Duration( Nanoseconds - other.Nanoseconds ); }
+	constexpr Duration operator-() const { return Duration( -Nanoseconds ); }
+	constexpr Duration operator*( int64_t factor ) const { return Duration( Nanoseconds * factor ); }
+	constexpr Duration operator/( int64_t divisor ) const { return Duration( Nanoseconds / divisor ); }
+	Duration& operator+=( Duration other ) { Nanoseconds += other.Nanoseconds; return *this; }
+	Duration& operator-=( Duration other ) { Nanoseconds -= other.Nanoseconds; return *this; }
+
+	constexpr bool operator==( Duration other ) const { return Nanoseconds == other.Nanoseconds; }
+	constexpr bool operator!=( Duration other ) const { return Nanoseconds != other.Nanoseconds; }
+	constexpr bool operator<( Duration other ) const { return Nanoseconds < other.Nanoseconds; }
+	constexpr bool operator<=( Duration other ) const { return Nanoseconds <= other.Nanoseconds; }
+	constexpr bool operator>( Duration other ) const { return Nanoseconds > other.Nanoseconds; }
+	constexpr bool operator>=( Duration other ) const { return Nanoseconds >= other.Nanoseconds; }
+
+private:
+	constexpr explicit Duration( int64_t nanoseconds ) : Nanoseconds( nanoseconds ) {}
+
+	int64_t Nanoseconds { 0 };
+};
+
+/*
+ * Point on the monotonic clock, in nanoseconds since an unspecified (per boot) epoch
+ */
+class TimePoint
+{
+public:
+	constexpr TimePoint() = default;
+
+	static constexpr TimePoint FromNanoseconds( int64_t nanoseconds ) { return TimePoint( nanoseconds ); }
+
+	constexpr int64_t ToNanoseconds() const { return Nanoseconds; }
+
+	constexpr TimePoint operator+( Duration duration ) const { return TimePoint( Nanoseconds + duration.ToNanoseconds() ); }
+	constexpr TimePoint operator-( Duration duration ) const { return TimePoint( Nanoseconds - duration.ToNanoseconds() ); }
+	constexpr Duration operator-( TimePoint other ) const { return Duration::FromNanoseconds( Nanoseconds - other.Nanoseconds ); }
+	TimePoint& operator+=( Duration duration ) { Nanoseconds += duration.ToNanoseconds(); return *this; }
+
+	constexpr bool operator==( TimePoint other ) const { return Nanoseconds == other.Nanoseconds; }
+	constexpr bool operator!=( TimePoint other ) const { return Nanoseconds != other.Nanoseconds; }
+	constexpr bool operator<( TimePoint other ) const { return Nanoseconds < other.Nanoseconds; }
+	constexpr bool operator<=( TimePoint other ) const { return Nanoseconds <= other.Nanoseconds; }
+	constexpr bool operator>( TimePoint other ) const { return Nanoseconds > other.Nanoseconds; }
+	constexpr bool operator>=( TimePoint other ) const { return Nanoseconds >= other.Nanoseconds; }
+
+private:
+	constexpr explicit TimePoint( int64_t nanoseconds ) : Nanoseconds( nanoseconds ) {}
+
+	int64_t Nanoseconds { 0 };
+};
+
+/*
+ * Converts a counter value to nanoseconds without overflowing for any realistic uptime: the whole seconds and
+ * the remainder are scaled separately, so the intermediate product stays below frequency * 10^9
+ */
+constexpr int64_t CyclesToNanoseconds( uint64_t cycles, uint64_t frequency )
+{
+	return static_cast< int64_t >( ( cycles / frequency ) * 1000000000u + ( ( cycles % frequency ) * 1000000000u ) / frequency );
+}
+
+/*
+ * Duration of the n-th of `ticksPerSecond` evenly spaced ticks, computed from the tick index so a
+ * schedule like 60 Hz (16.666... ms) never drifts
+ */
+constexpr Duration TickOffset( uint64_t tickIndex, uint32_t ticksPerSecond )
+{
+	return Duration::FromNanoseconds( static_cast< int64_t >( ( tickIndex / ticksPerSecond ) * 1000000000u
+		+ ( ( tickIndex % ticksPerSecond ) * 1000000000u ) / ticksPerSecond ) );
+}
@@ -6,17 +6,40 @@
 #include "Windows.h"
 #undef WIN_LEAN_AND_MEAN
 
+#include "ClockTypes.h"
+
+/*
+ * Monotonic clock that keeps everything in integer counter cycles / nanoseconds. Reads don't take any lock and
+ * only touch the (read-only after Init) frequency, so they are cheap enough to call per event.
+ */
 class ClockWin
 {
 public:
 	
 	typedef uint64_t Cycles;
 
-	static void Init(void)
+	static void Init()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency( &frequency );
+		Frequency = static_cast< Cycles >( frequency.QuadPart );
+	}
+
+	static Cycles QueryCycles()
+	{
+		LARGE_INTEGER cycles;
+		QueryPerformanceCounter( &cycles );
+		return static_cast< Cycles >( cycles.QuadPart );
+	}
+
+	static TimePoint Now()
 	{
-		LARGE_INTEGER Frequency;
-		QueryPerformanceFrequency( &Frequency );
-		OneOverFrequency = 1.0f / static_cast< float >( Frequency.QuadPart );
+		return TimePoint::FromNanoseconds( CyclesToNanoseconds( QueryCycles(), Frequency ) );
+	}
+
+	static Duration ToDuration( Cycles cycles )
+	{
+		return Duration::FromNanoseconds( CyclesToNanoseconds( cycles, Frequency ) );
 	}
 
 	ClockWin()
@@ -27,7 +50,7 @@ public:
 	
 	void Start()
 	{
-		QueryPerformanceCounter( reinterpret_cast< LARGE_INTEGER* >( &StartCycles ) );
+		StartCycles = QueryCycles();
 		IsRunning = true;
 	}
 
@@ -44,27 +67,31 @@ public:
 			return 0;
 		}
 		
-		Cycles PassedCycles = 0u;
-		QueryPerformanceCounter( reinterpret_cast< LARGE_INTEGER* >( &PassedCycles ) );
-		return ( PassedCycles - StartCycles );
+		return ( QueryCycles() - StartCycles );
+	}
+
+	Duration Elapsed() const
+	{
+		return ToDuration( QueryPassedCycles() );
 	}
 
+	// @note - float conversions are for printing only, use Elapsed() for anything that accumulates
 	float ToMilliseconds() const
 	{
-		return ( static_cast< float >( QueryPassedCycles() ) * OneOverFrequency ) * 1000.0f;
+		return Elapsed().ToMillisecondsF();
 	}
 
 	float ToSecond() const
 	{
-		return static_cast< float >( QueryPassedCycles() ) * OneOverFrequency;
+		return Elapsed().ToSecondsF();
 	}
 
 private:
 	bool IsRunning { false };
 	Cycles StartCycles { 0u };
-	static float OneOverFrequency;
+	static Cycles Frequency;
 };
 
-float ClockWin::OneOverFrequency = 1.0f;
+ClockWin::Cycles ClockWin::Frequency = 1u;
 
 typedef ClockWin Clock;
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// targets that always have SSE4.2 (PS4 Jaguar) use it unconditionally, other x64 builds ask cpuid at runtime
+#if defined(__SSE4_2__)
+	#define CRC32C_HARDWARE 1
+	#define CRC32C_TARGET_SSE42
+	#include <nmmintrin.h>
+#elif defined(__x86_64__) || defined(_M_X64)
+	#define CRC32C_HARDWARE 1
+	#define CRC32C_RUNTIME_DISPATCH 1
+	#include <nmmintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+	// only this function may use the instruction, the rest of the build keeps running on any x64 CPU
+	#if defined(__GNUC__) || defined(__clang__)
+		#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+	#else
+		#define CRC32C_TARGET_SSE42
+	#endif
+#endif
+
+/*
+ * CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the CPU supports it and a slicing-by-8 table
+ * implementation otherwise. Both produce identical checksums. PC builds don't require SSE4.2, the instruction is
+ * picked by a cpuid check on the first checksum.
+ */
+namespace Crc32c
+{
+	constexpr uint32_t POLYNOMIAL = 0x82F63B78u;
+
+	struct Tables
+	{
+		uint32_t entries[8][256];
+
+		Tables()
+		{
+			for (uint32_t i = 0u; i < 256u; ++i) {
+				uint32_t crc = i;
+				for (uint32_t bit = 0u; bit < 8u; ++bit) {
+					crc = (crc & 1u) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+				}
+				entries[0][i] = crc;
+			}
+
+			for (uint32_t i = 0u; i < 256u; ++i) {
+				for (uint32_t slice = 1u; slice < 8u; ++slice) {
+					entries[slice][i] = (entries[slice - 1u][i] >> 8) ^ entries[0][entries[slice - 1u][i] & 0xFFu];
+				}
+			}
+		}
+	};
+
+	uint32_t UpdateSoftware(uint32_t crc, const uint8_t* data, size_t length) {
+		static const Tables tables;
+		const uint32_t (&t)[8][256] = tables.entries;
+
+		while (length >= 8u) {
+			uint32_t low;
+			uint32_t high;
+			memcpy(&low, data, sizeof(low));
+			memcpy(&high, data + 4, sizeof(high));
+			low ^= crc;
+
+			crc = t[7][low & 0xFFu] ^ t[6][(low >> 8) & 0xFFu] ^ t[5][(low >> 16) & 0xFFu] ^ t[4][low >> 24]
+				^ t[3][high & 0xFFu] ^ t[2][(high >> 8) & 0xFFu] ^ t[1][(high >> 16) & 0xFFu] ^ t[0][high >> 24];
+
+			data += 8;
+			length -= 8u;
+		}
+
+		while (length-- > 0u) {
+			crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFFu];
+		}
+		return crc;
+	}
+
+#if CRC32C_HARDWARE
+	CRC32C_TARGET_SSE42 uint32_t UpdateHardware(uint32_t crc, const uint8_t* data, size_t length) {
+		uint64_t crc64 = crc;
+		while (length >= 8u) {
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			crc64 = _mm_crc32_u64(crc64, value);
+			data += 8;
+			length -= 8u;
+		}
+
+		crc = static_cast<uint32_t>(crc64);
+		while (length-- > 0u) {
+			crc = _mm_crc32_u8(crc, *data++);
+		}
+		return crc;
+	}
+#endif
+
+	/*
+	 * True when UpdateHardware may run on this CPU
+	 */
+	bool HasHardwareSupport() {
+#if CRC32C_RUNTIME_DISPATCH && defined(_MSC_VER)
+		static const bool hasSse42 = [] {
+			int info[4] = {};
+			__cpuid(info, 1);
+			return (info[2] & (1 << 20)) != 0;
+		}();
+		return hasSse42;
+#elif CRC32C_RUNTIME_DISPATCH
+		static const bool hasSse42 = [] {
+			unsigned int eax = 0u;
+			unsigned int ebx = 0u;
+			unsigned int ecx = 0u;
+			unsigned int edx = 0u;
+			return __get_cpuid(1u, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_SSE4_2) != 0u;
+		}();
+		return hasSse42;
+#elif CRC32C_HARDWARE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/*
+	 * Continues a running checksum, start with Compute or with an initial value of 0
+	 */
+	uint32_t Update(uint32_t crc, const void* data, size_t length) {
+		crc = ~crc;
+#if CRC32C_RUNTIME_DISPATCH
+		crc = HasHardwareSupport() ? UpdateHardware(crc, static_cast<const uint8_t*>(data), length)
+			: UpdateSoftware(crc, static_cast<const uint8_t*>(data), length);
+#elif CRC32C_HARDWARE
+		crc = UpdateHardware(crc, static_cast<const uint8_t*>(data), length);
+#else
+		crc = UpdateSoftware(crc, static_cast<const uint8_t*>(data), length);
+#endif
+		return ~crc;
+	}
+
+	uint32_t Compute(const void* data, size_t length) {
+		return Update(0u, data, length);
+	}
+}
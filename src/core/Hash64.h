@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * 64 bit non-cryptographic hash (xxHash64). Used to detect changed data, where the 32 bit CRC's collision rate is
+ * too high to trust a match.
+ */
+namespace Hash64
+{
+	constexpr uint64_t PRIME1 = 11400714785074694791ull;
+	constexpr uint64_t PRIME2 = 14029467366897019727ull;
+	constexpr uint64_t PRIME3 = 1609587929392839161ull;
+	constexpr uint64_t PRIME4 = 9650029242287828579ull;
+	constexpr uint64_t PRIME5 = 2870177450012600261ull;
+
+	inline uint64_t RotateLeft(uint64_t value, uint32_t bits) {
+		return (value << bits) | (value >> (64u - bits));
+	}
+
+	inline uint64_t Read64(const uint8_t* data) {
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Read32(const uint8_t* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+		accumulator += input * PRIME2;
+		accumulator = RotateLeft(accumulator, 31u);
+		return accumulator * PRIME1;
+	}
+
+	inline uint64_t MergeRound(uint64_t hash, uint64_t accumulator) {
+		hash ^= Round(0u, accumulator);
+		return hash * PRIME1 + PRIME4;
+	}
+
+	uint64_t Compute(const void* input, size_t length, uint64_t seed = 0u) {
+		const uint8_t* data = static_cast<const uint8_t*>(input);
+		const uint8_t* end = data + length;
+		uint64_t hash;
+
+		if (length >= 32u) {
+			// four independent lanes keep the multipliers busy
+			uint64_t v1 = seed + PRIME1 + PRIME2;
+			uint64_t v2 = seed + PRIME2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - PRIME1;
+
+			const uint8_t* limit = end - 32;
+			do {
+				v1 = Round(v1, Read64(data));
+				v2 = Round(v2, Read64(data + 8));
+				v3 = Round(v3, Read64(data + 16));
+				v4 = Round(v4, Read64(data + 24));
+				data += 32;
+			} while (data <= limit);
+
+			hash = RotateLeft(v1, 1u) + RotateLeft(v2, 7u) + RotateLeft(v3, 12u) + RotateLeft(v4, 18u);
+			hash = MergeRound(hash, v1);
+			hash = MergeRound(hash, v2);
+			hash = MergeRound(hash, v3);
+			hash = MergeRound(hash, v4);
+		}
+		else {
+			hash = seed + PRIME5;
+		}
+
+		hash += static_cast<uint64_t>(length);
+
+		while (data + 8 <= end) {
+			hash ^= Round(0u, Read64(data));
+			hash = RotateLeft(hash, 27u) * PRIME1 + PRIME4;
+			data += 8;
+		}
+
+		if (data + 4 <= end) {
+			hash ^= static_cast<uint64_t>(Read32(data)) * PRIME1;
+			hash = RotateLeft(hash, 23u) * PRIME2 + PRIME3;
+			data += 4;
+		}
+
+		while (data < end) {
+			hash ^= (*data) * PRIME5;
+			hash = RotateLeft(hash, 11u) * PRIME1;
+			++data;
+		}
+
+		hash ^= hash >> 33;
+		hash *= PRIME2;
+		hash ^= hash >> 29;
+		hash *= PRIME3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+}
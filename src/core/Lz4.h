@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+#endif
+
+/*
+ * LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), greedy single-pass
+ * compressor and a bounds-checked decompressor that is safe to run on untrusted (corrupted) input.
+ *
+ * A block is a list of sequences: token (literal length | match length - 4), literals, 16 bit match offset.
+ * The last sequence only has literals, the last 5 bytes are always literals.
+ */
+namespace Lz4
+{
+	constexpr uint32_t MIN_MATCH = 4u;
+	constexpr size_t LAST_LITERALS = 5u;
+	// a match has to start at least this far from the end of the input
+	constexpr size_t MATCH_FIND_LIMIT = 12u;
+	constexpr size_t MAX_OFFSET = 65535u;
+	constexpr uint32_t HASH_BITS = 14u;
+	// literal runs grow the step after every 64 misses, so incompressible data is skipped quickly
+	constexpr uint32_t SKIP_TRIGGER = 6u;
+
+	/*
+	 * Worst case size of the compressed data
+	 */
+	constexpr size_t CompressBound(size_t length) {
+		return length + length / 255u + 16u;
+	}
+
+	inline uint32_t Read32(const uint8_t* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Read64(const uint8_t* data) {
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Hash(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32u - HASH_BITS);
+	}
+
+	inline uint32_t CountTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+	}
+
+	// number of equal bytes at `a` and `b`, not looking at `limit` and beyond (`a` < `limit`)
+	inline size_t CountMatch(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+		const uint8_t* start = a;
+		while (a + 8 <= limit) {
+			const uint64_t difference = Read64(a) ^ Read64(b);
+			if (difference != 0u) {
+				// little endian: the lowest set bit is the first differing byte
+				return static_cast<size_t>(a - start) + CountTrailingZeros(difference) / 8u;
+			}
+			a += 8;
+			b += 8;
+		}
+		while (a < limit && *a == *b) {
+			++a;
+			++b;
+		}
+		return static_cast<size_t>(a - start);
+	}
+
+	inline uint8_t* WriteLength(uint8_t* output, size_t length) {
+		while (length >= 255u) {
+			*output++ = 255u;
+			length -= 255u;
+		}
+		*output++ = static_cast<uint8_t>(length);
+		return output;
+	}
+
+	/*
+	 * Returns the compressed size, or 0 if it doesn't fit into `capacity` (CompressBound always fits)
+	 */
+	size_t Compress(const uint8_t* input, size_t length, uint8_t* output, size_t capacity) {
+		uint32_t table[1u << HASH_BITS];
+		memset(table, 0, sizeof(table));
+
+		const uint8_t* anchor = input;
+		const uint8_t* const inputEnd = input + length;
+		uint8_t* op = output;
+		uint8_t* const outputEnd = output + capacity;
+
+		if (length > MATCH_FIND_LIMIT) {
+			const uint8_t* const matchFindLimit = inputEnd - MATCH_FIND_LIMIT;
+			const uint8_t* const matchLimit = inputEnd - LAST_LITERALS;
+			const uint8_t* ip = input + 1;
+			table[Hash(Read32(input))] = 0u;
+
+			while (ip < matchFindLimit) {
+				const uint32_t hash = Hash(Read32(ip));
+				const uint8_t* match = input + table[hash];
+				table[hash] = static_cast<uint32_t>(ip - input);
+
+				if (static_cast<size_t>(ip - match) > MAX_OFFSET || match >= ip || Read32(match) != Read32(ip)) {
+					ip += 1u + (static_cast<size_t>(ip - anchor) >> SKIP_TRIGGER);
+					continue;
+				}
+
+				// extend the match backwards into the pending literals
+				while (ip > anchor && match > input && ip[-1] == match[-1]) {
+					--ip;
+					--match;
+				}
+
+				const size_t literals = static_cast<size_t>(ip - anchor);
+				const size_t matchLength = MIN_MATCH + CountMatch(ip + MIN_MATCH, match + MIN_MATCH, matchLimit);
+
+				// token + literal length + literals + offset + match length
+				if (static_cast<size_t>(outputEnd - op) < 1u + literals / 255u + 1u + literals + 2u + matchLength / 255u + 1u) {
+					return 0u;
+				}
+
+				uint8_t* token = op++;
+				*token = static_cast<uint8_t>((literals >= 15u ? 15u : literals) << 4);
+				if (literals >= 15u) {
+					op = WriteLength(op, literals - 15u);
+				}
+				if (literals <= 16u && inputEnd - anchor >= 16 && outputEnd - op >= 16) {
+					memcpy(op, anchor, 16u);
+				}
+				else {
+					memcpy(op, anchor, literals);
+				}
+				op += literals;
+
+				const size_t offset = static_cast<size_t>(ip - match);
+				*op++ = static_cast<uint8_t>(offset & 0xFFu);
+				*op++ = static_cast<uint8_t>(offset >> 8);
+
+				const size_t extraLength = matchLength - MIN_MATCH;
+				*token |= static_cast<uint8_t>(extraLength >= 15u ? 15u : extraLength);
+				if (extraLength >= 15u) {
+					op = WriteLength(op, extraLength - 15u);
+				}
+
+				ip += matchLength;
+				anchor = ip;
+
+				if (ip < matchFindLimit) {
+					table[Hash(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - input);
+				}
+			}
+		}
+
+		// the rest goes out as literals
+		const size_t literals = static_cast<size_t>(inputEnd - anchor);
+		if (static_cast<size_t>(outputEnd - op) < 1u + literals / 255u + 1u + literals) {
+			return 0u;
+		}
+
+		*op++ = static_cast<uint8_t>((literals >= 15u ? 15u : literals) << 4);
+		if (literals >= 15u) {
+			op = WriteLength(op, literals - 15u);
+		}
+		memcpy(op, anchor, literals);
+		op += literals;
+
+		return static_cast<size_t>(op - output);
+	}
+
+	/*
+	 * Decompresses exactly `length` bytes, returns false if the input is malformed or doesn't produce them
+	 */
+	bool Decompress(const uint8_t* input, size_t inputLength, uint8_t* output, size_t length) {
+		const uint8_t* ip = input;
+		const uint8_t* const inputEnd = input + inputLength;
+		uint8_t* op = output;
+		uint8_t* const outputEnd = output + length;
+
+		while (ip < inputEnd) {
+			const uint32_t token = *ip++;
+
+			size_t literals = token >> 4;
+			if (literals == 15u) {
+				uint8_t extra;
+				do {
+					if (ip >= inputEnd) {
+						return false;
+					}
+					extra = *ip++;
+					literals += extra;
+				} while (extra == 255u);
+			}
+
+			if (literals > static_cast<size_t>(inputEnd - ip) || literals > static_cast<size_t>(outputEnd - op)) {
+				return false;
+			}
+			if (literals <= 16u && inputEnd - ip >= 16 && outputEnd - op >= 16) {
+				// short runs are the common case, a fixed size copy avoids the library call
+				memcpy(op, ip, 16u);
+			}
+			else {
+				memcpy(op, ip, literals);
+			}
+			ip += literals;
+			op += literals;
+
+			// the last sequence has no match
+			if (ip == inputEnd) {
+				break;
+			}
+
+			if (inputEnd - ip < 2) {
+				return false;
+			}
+			const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+			ip += 2;
+			if (offset == 0u || offset > static_cast<size_t>(op - output)) {
+				return false;
+			}
+
+			size_t matchLength = token & 15u;
+			if (matchLength == 15u) {
+				uint8_t extra;
+				do {
+					if (ip >= inputEnd) {
+						return false;
+					}
+					extra = *ip++;
+					matchLength += extra;
+				} while (extra == 255u);
+			}
+			matchLength += MIN_MATCH;
+
+			if (matchLength > static_cast<size_t>(outputEnd - op)) {
+				return false;
+			}
+
+			const uint8_t* match = op - offset;
+			if (offset >= 16u && matchLength <= 16u && outputEnd - op >= 16) {
+				memcpy(op, match, 16u);
+				op += matchLength;
+			}
+			else if (offset >= matchLength) {
+				memcpy(op, match, matchLength);
+				op += matchLength;
+			}
+			else if (offset >= 8u) {
+				// overlapping, but every 8 byte step only reads bytes that were already written
+				uint8_t* const end = op + matchLength;
+				while (end - op >= 8) {
+					memcpy(op, match, 8u);
+					op += 8;
+					match += 8;
+				}
+				while (op < end) {
+					*op++ = *match++;
+				}
+			}
+			else {
+				// short repeating pattern
+				for (size_t i = 0u; i < matchLength; ++i) {
+					*op++ = *match++;
+				}
+			}
+		}
+
+		return op == outputEnd;
+	}
+}
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "Clock.h"
+#include "../threading/Sys_Threading.h"
+
+/*
+ * Frame profiler: PROFILE_SCOPE( "Name" ) times the rest of the enclosing scope.
+ *
+ * Every thread records its zones into its own ring buffer (allocated on the thread's first zone), so recording
+ * is two timestamp reads, three relaxed stores and one release store - no lock, no shared cache line. The game
+ * thread folds the zones of all threads into per-zone statistics once per frame (PROFILE_END_FRAME) and can
+ * export what is still in the rings as a Chrome trace / Perfetto JSON file.
+ *
+ * Zone names have to be string literals (or otherwise outlive the profiler), zones are aggregated by pointer.
+ *
+ * Timestamps come from the TSC where there is one (x64, PS4) and from Clock::QueryCycles elsewhere. TSC ticks
+ * are converted with a rate measured against Clock over the whole session, so no calibration pause is needed.
+ *
+ * tests/ProfilerBench.cpp measures the cost of a zone. On a 2 GHz Xeon (KVM guest) a zone costs 45-49 ns: the
+ * two rdtsc take 41-48 ns (about 40 cycles each) and the recording 2-3 ns. That misses the 20 ns budget, and
+ * the rest of the zone can't make up for it: the timestamps are the cost. rdtscp is slower (53-66 ns a pair),
+ * and so is Clock. Run the bench on the target hardware before relying on the budget.
+ *
+ * Defining RELEASE (or PROFILER_ENABLED 0) compiles all of it out: the macros expand to nothing and the
+ * Profiler functions become empty inline stubs without any storage.
+ */
+
+#ifndef PROFILER_ENABLED
+	#if defined( RELEASE )
+		#define PROFILER_ENABLED 0
+	#else
+		#define PROFILER_ENABLED 1
+	#endif
+#endif
+
+#if PROFILER_ENABLED && ( defined( __x86_64__ ) || defined( _M_X64 ) )
+	#if defined( _WIN32 )
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+	#define PROFILER_USE_TSC 1
+#endif
+
+struct ProfileZoneStats
+{
+	const char* name = nullptr;
+	uint64_t calls = 0u;
+	float totalMs = 0.0f;
+	float maxMs = 0.0f;
+	// time spent in the zone during the last finished frame, summed over all threads
+	float lastFrameMs = 0.0f;
+};
+
+#if PROFILER_ENABLED
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+#define PROFILE_SCOPE( name ) const ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( name )
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+
+class Profiler
+{
+public:
+	static constexpr uint32_t MAX_THREADS = 32u;
+	// per thread, the oldest zones are overwritten (and skipped by readers) once a ring is full
+	static constexpr uint32_t ZONES_PER_THREAD = 16384u;
+	static constexpr uint32_t MAX_ZONE_NAMES = 64u;
+	static_assert( ( ZONES_PER_THREAD & ( ZONES_PER_THREAD - 1u ) ) == 0u, "zone ring has to be a power of two" );
+
+	static uint64_t QueryTicks()
+	{
+#if PROFILER_USE_TSC
+		return __rdtsc();
+#else
+		return static_cast< uint64_t >( Clock::QueryCycles() );
+#endif
+	}
+
+	/*
+	 * Call once after Clock::Init, before the first zone
+	 */
+	static void Init()
+	{
+		StartTicks = QueryTicks();
+		StartTime = Clock::Now();
+	}
+
+	static void Record( const char* name, uint64_t begin, uint64_t end )
+	{
+		ThreadBuffer* buffer = CurrentBuffer != nullptr ? CurrentBuffer : RegisterThread();
+		if ( buffer == nullptr )
+		{
+			return;
+		}
+
+		const uint32_t head = buffer->Head.load( std::memory_order_relaxed );
+		Zone& zone = buffer->Zones[ head & ( ZONES_PER_THREAD - 1u ) ];
+		zone.Name.store( name, std::memory_order_relaxed );
+		zone.Begin.store( begin, std::memory_order_relaxed );
+		zone.End.store( end, std::memory_order_relaxed );
+		buffer->Head.store( head + 1u, std::memory_order_release );
+	}
+
+	/*
+	 * Game thread - folds the zones all threads recorded since the last call into the statistics
+	 */
+	static void EndFrame()
+	{
+		const double ticksPerMillisecond = TicksPerMillisecond();
+		for ( uint32_t i = 0u; i < MAX_ZONE_NAMES; ++i )
+		{
+			Stats[ i ].lastFrameMs = 0.0f;
+		}
+
+		const uint32_t bufferCount = BufferCount.load( std::memory_order_acquire );
+		for ( uint32_t i = 0u; i < bufferCount && i < MAX_THREADS; ++i )
+		{
+			ThreadBuffer* buffer = Buffers[ i ].load( std::memory_order_acquire );
+			if ( buffer == nullptr )
+			{
+				continue;
+			}
+
+			buffer->AggregatedUntil = ReadZones( *buffer, buffer->AggregatedUntil, [ ticksPerMillisecond ]( const char* name, uint64_t begin, uint64_t end )
+			{
+				Accumulate( name, static_cast< float >( static_cast< double >( end - begin ) / ticksPerMillisecond ) );
+			} );
+		}
+	}
+
+	/*
+	 * Game thread - copies the statistics of up to `capacity` zones, returns how many there are
+	 */
+	static uint32_t GetZoneStats( ProfileZoneStats* stats, uint32_t capacity )
+	{
+		uint32_t count = 0u;
+		for ( ; count < StatsCount && count < capacity; ++count )
+		{
+			stats[ count ] = Stats[ count ];
+		}
+		return count;
+	}
+
+	/*
+	 * Writes every zone still held by the rings as Chrome trace events ("X" events plus thread names), open it
+	 * in chrome://tracing or ui.perfetto.dev. Zones recorded while the file is written are skipped or cut off
+	 */
+	static bool WriteChromeTrace( const char* path )
+	{
+		FILE* file = fopen( path, "w" );
+		if ( file == nullptr )
+		{
+			return false;
+		}
+
+		const double ticksPerMicrosecond = TicksPerMillisecond() / 1000.0;
+		bool isFirstEvent = true;
+		fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+		const uint32_t bufferCount = BufferCount.load( std::memory_order_acquire );
+		for ( uint32_t i = 0u; i < bufferCount && i < MAX_THREADS; ++i )
+		{
+			ThreadBuffer* buffer = Buffers[ i ].load( std::memory_order_acquire );
+			if ( buffer == nullptr )
+			{
+				continue;
+			}
+
+			fprintf( file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", isFirstEvent ? "" : ",", i );
+			WriteJsonString( file, buffer->Name );
+			fprintf( file, "\"}}" );
+			isFirstEvent = false;
+
+			const uint32_t head = buffer->Head.load( std::memory_order_acquire );
+			const uint32_t oldest = head > ZONES_PER_THREAD ? head - ZONES_PER_THREAD : 0u;
+			ReadZones( *buffer, oldest, [ file, i, ticksPerMicrosecond ]( const char* name, uint64_t begin, uint64_t end )
+			{
+				fprintf( file, ",\n{\"name\":\"" );
+				WriteJsonString( file, name );
+				fprintf( file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", i,
+					static_cast< double >( begin - StartTicks ) / ticksPerMicrosecond, static_cast< double >( end - begin ) / ticksPerMicrosecond );
+			} );
+		}
+
+		fprintf( file, "\n]}\n" );
+		return fclose( file ) == 0;
+	}
+
+private:
+	struct Zone
+	{
+		std::atomic< const char* > Name { nullptr };
+		std::atomic< uint64_t > Begin { 0u };
+		std::atomic< uint64_t > End { 0u };
+	};
+
+	struct ThreadBuffer
+	{
+		std::atomic< uint32_t > Head { 0u };
+		// game thread, first zone EndFrame hasn't seen yet
+		uint32_t AggregatedUntil { 0u };
+		char Name[ ThreadRegistry::MAX_THREAD_NAME_LENGTH ] = {};
+		Zone Zones[ ZONES_PER_THREAD ];
+	};
+
+	static ThreadBuffer* RegisterThread()
+	{
+		const uint32_t index = BufferCount.load( std::memory_order_relaxed );
+		if ( index >= MAX_THREADS )
+		{
+			return nullptr;
+		}
+
+		uint32_t claimed = index;
+		while ( claimed < MAX_THREADS && !BufferCount.compare_exchange_weak( claimed, claimed + 1u, std::memory_order_acq_rel ) )
+		{
+		}
+		if ( claimed >= MAX_THREADS )
+		{
+			return nullptr;
+		}
+
+		// owned by the profiler until the process exits, the last zones of a finished thread can still be exported
+		ThreadBuffer* buffer = new ThreadBuffer();
+		ThreadRegistry::CopyName( buffer->Name, Sys_GetThreadName( Sys_GetCurrentThreadID() ) );
+		Buffers[ claimed ].store( buffer, std::memory_order_release );
+		CurrentBuffer = buffer;
+		return buffer;
+	}
+
+	/*
+	 * Calls `visit( name, begin, end )` for every zone from `first` on that wasn't overwritten while it was read,
+	 * returns the index to continue from
+	 */
+	template < typename Visitor >
+	static uint32_t ReadZones( const ThreadBuffer& buffer, uint32_t first, Visitor&& visit )
+	{
+		const uint32_t head = buffer.Head.load( std::memory_order_acquire );
+		if ( head - first > ZONES_PER_THREAD )
+		{
+			first = head - ZONES_PER_THREAD;
+		}
+
+		for ( uint32_t index = first; index != head; ++index )
+		{
+			const Zone& zone = buffer.Zones[ index & ( ZONES_PER_THREAD - 1u ) ];
+			const char* name = zone.Name.load( std::memory_order_relaxed );
+			const uint64_t begin = zone.Begin.load( std::memory_order_relaxed );
+			const uint64_t end = zone.End.load( std::memory_order_relaxed );
+
+			// the writer may have lapped us while we read, the slot is only trustworthy if it is still in the ring
+			std::atomic_thread_fence( std::memory_order_acquire );
+			if ( buffer.Head.load( std::memory_order_relaxed ) - index > ZONES_PER_THREAD - 1u )
+			{
+				continue;
+			}
+			visit( name, begin, end );
+		}
+		return head;
+	}
+
+	static void Accumulate( const char* name, float milliseconds )
+	{
+		uint32_t index = 0u;
+		while ( index < StatsCount && Stats[ index ].name != name )
+		{
+			++index;
+		}
+		if ( index == StatsCount )
+		{
+			if ( StatsCount == MAX_ZONE_NAMES )
+			{
+				return;
+			}
+			Stats[ StatsCount++ ].name = name;
+		}
+
+		ProfileZoneStats& stats = Stats[ index ];
+		++stats.calls;
+		stats.totalMs += milliseconds;
+		stats.lastFrameMs += milliseconds;
+		if ( milliseconds > stats.maxMs )
+		{
+			stats.maxMs = milliseconds;
+		}
+	}
+
+	static double TicksPerMillisecond()
+	{
+#if PROFILER_USE_TSC
+		// the longer the session, the more exact the rate
+		const double elapsedMs = static_cast< double >( ( Clock::Now() - StartTime ).ToNanoseconds() ) / 1000000.0;
+		const uint64_t elapsedTicks = QueryTicks() - StartTicks;
+		return elapsedMs > 0.0 && elapsedTicks > 0u ? static_cast< double >( elapsedTicks ) / elapsedMs : 1.0;
+#else
+		const double nanosecondsPerTick = static_cast< double >( Clock::ToDuration( 1000000u ).ToNanoseconds() ) / 1000000.0;
+		return 1000000.0 / nanosecondsPerTick;
+#endif
+	}
+
+	static void WriteJsonString( FILE* file, const char* text )
+	{
+		for ( ; text != nullptr && *text != '\0'; ++text )
+		{
+			if ( *text == '"' || *text == '\\' )
+			{
+				fputc( '\\', file );
+			}
+			if ( static_cast< unsigned char >( *text ) >= 0x20u )
+			{
+				fputc( *text, file );
+			}
+		}
+	}
+
+	static uint64_t StartTicks;
+	static TimePoint StartTime;
+
+	static std::atomic< ThreadBuffer* > Buffers[ MAX_THREADS ];
+	static std::atomic< uint32_t > BufferCount;
+	static thread_local ThreadBuffer* CurrentBuffer;
+
+	// game thread
+	static ProfileZoneStats Stats[ MAX_ZONE_NAMES ];
+	static uint32_t StatsCount;
+};
+
+uint64_t Profiler::StartTicks = 0u;
+TimePoint Profiler::StartTime;
+std::atomic< Profiler::ThreadBuffer* > Profiler::Buffers[ Profiler::MAX_THREADS ] = {};
+std::atomic< uint32_t > Profiler::BufferCount { 0u };
+thread_local Profiler::ThreadBuffer* Profiler::CurrentBuffer = nullptr;
+ProfileZoneStats Profiler::Stats[ Profiler::MAX_ZONE_NAMES ];
+uint32_t Profiler::StatsCount = 0u;
+
+/*
+ * Times its own lifetime
+ */
+class ProfileScope
+{
+public:
+	explicit ProfileScope( const char* name )
+		: Name( name )
+		, Begin( Profiler::QueryTicks() )
+	{
+	}
+
+	~ProfileScope()
+	{
+		Profiler::Record( Name, Begin, Profiler::QueryTicks() );
+	}
+
+	ProfileScope( const ProfileScope& ) = delete;
+	ProfileScope& operator=( const ProfileScope& ) = delete;
+
+private:
+	const char* Name;
+	uint64_t Begin;
+};
+
+#else
+
+#define PROFILE_SCOPE( name ) do {} while ( false )
+#define PROFILE_END_FRAME() do {} while ( false )
+
+class Profiler
+{
+public:
+	static void Init() {}
+	static uint32_t GetZoneStats( ProfileZoneStats*, uint32_t ) { return 0u; }
+	static bool WriteChromeTrace( const char* ) { return false; }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Clock.h"
+#include "../threading/Sys_Threading.h"
+
+/*
+ * How much later than requested the OS wakes a sleeping thread up, so deadline waits know how early they have to
+ * stop sleeping and start spinning
+ */
+class SleepOvershoot
+{
+public:
+	static constexpr uint32_t CALIBRATION_SLEEPS = 8u;
+
+	/*
+	 * Measures the overshoot of a few short sleeps
+	 */
+	void Calibrate()
+	{
+		const Duration requested = Duration::FromMilliseconds( 1 );
+		Duration overshoot;
+
+		for ( uint32_t i = 0u; i < CALIBRATION_SLEEPS; ++i )
+		{
+			const TimePoint start = Clock::Now();
+			Sys_Sleep( static_cast< uint32_t >( requested.ToMicroseconds() ) );
+			overshoot = std::max( overshoot, ( Clock::Now() - start ) - requested );
+		}
+
+		Overshoot = overshoot;
+	}
+
+	void Track( Duration overshoot )
+	{
+		// react to worse wake-ups immediately, relax slowly (1/16 per sleep) once the system calms down again
+		if ( overshoot > Overshoot )
+		{
+			Overshoot = overshoot;
+		}
+		else
+		{
+			Overshoot -= ( Overshoot - overshoot ) / 16;
+		}
+	}
+
+	Duration Get() const
+	{
+		return Overshoot;
+	}
+
+private:
+	Duration Overshoot;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Bounded wait-free single-producer / single-consumer ring buffer.
+ *
+ * TryPush may only be called from one thread and TryPop from one (other) thread. Neither side ever blocks or
+ * takes a lock: the producer owns the head index, the consumer owns the tail index and each side keeps a cached
+ * copy of the other index so the shared cache line is only touched when the cached value says "full" / "empty".
+ */
+template < typename T, uint32_t Capacity >
+class SpscQueue
+{
+	static_assert( ( Capacity & ( Capacity - 1u ) ) == 0u, "SpscQueue capacity has to be a power of two" );
+
+public:
+	static constexpr size_t CACHE_LINE_SIZE = 64u;
+
+	bool TryPush( const T& item )
+	{
+		const uint32_t head = Head.load( std::memory_order_relaxed );
+		if ( head - CachedTail == Capacity )
+		{
+			CachedTail = Tail.load( std::memory_order_acquire );
+			if ( head - CachedTail == Capacity )
+			{
+				return false;
+			}
+		}
+
+		Items[ head & ( Capacity - 1u ) ] = item;
+		Head.store( head + 1u, std::memory_order_release );
+		return true;
+	}
+
+	bool TryPop( T& item )
+	{
+		const uint32_t tail = Tail.load( std::memory_order_relaxed );
+		if ( tail == CachedHead )
+		{
+			CachedHead = Head.load( std::memory_order_acquire );
+			if ( tail == CachedHead )
+			{
+				return false;
+			}
+		}
+
+		item = Items[ tail & ( Capacity - 1u ) ];
+		Tail.store( tail + 1u, std::memory_order_release );
+		return true;
+	}
+
+	// approximate when called while the other side is active
+	uint32_t Size() const
+	{
+		return Head.load( std::memory_order_acquire ) - Tail.load( std::memory_order_acquire );
+	}
+
+private:
+	// producer side
+	alignas( CACHE_LINE_SIZE ) std::atomic< uint32_t > Head { 0u };
+	uint32_t CachedTail { 0u };
+
+	// consumer side
+	alignas( CACHE_LINE_SIZE ) std::atomic< uint32_t > Tail { 0u };
+	uint32_t CachedHead { 0u };
+
+	alignas( CACHE_LINE_SIZE ) T Items[ Capacity ];
+};
@@ -0,0 +1,555 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "Clock.h"
+#include "Profiler.h"
+#include "SleepOvershoot.h"
+#include "../threading/Sys_Threading.h"
+#include "../threading/Sys_JobSystem.h"
+
+enum class TickMode : uint8_t
+{
+	// ticks on a fixed grid, ticks that can't start on time are dropped (polling)
+	FIXED_RATE,
+	// fixed time step, late steps are caught up - at most `maxCatchUpSteps` behind, older ones are dropped (simulation)
+	FIXED_STEP,
+	// ticks again as soon as the previous tick finished (unpaced loops)
+	CONTINUOUS,
+	// ticks once after one or more Request calls (I/O)
+	ON_DEMAND,
+};
+
+struct TickInfo
+{
+	// FIXED_RATE / FIXED_STEP: position on the grid (dropped ticks leave gaps), otherwise a running count
+	uint64_t index = 0u;
+	// FIXED_RATE / FIXED_STEP: the period, otherwise the time since the previous tick started
+	Duration deltaTime;
+	// when the tick was due
+	TimePoint scheduledTime;
+};
+
+typedef void ( *TickFunction )( const TickInfo& tick, void* userData );
+
+struct TickSubsystemDesc
+{
+	// string literal, shows up in the stats and as profiler zone
+	const char* name = nullptr;
+	TickFunction function = nullptr;
+	void* userData = nullptr;
+	TickMode mode = TickMode::FIXED_RATE;
+	// FIXED_RATE / FIXED_STEP only
+	uint32_t ticksPerSecond = 0u;
+	// subsystems that are due at the same time are dispatched in order of priority, highest first
+	uint32_t priority = 0u;
+	// FIXED_STEP only, spiral of death protection
+	uint32_t maxCatchUpSteps = 4u;
+	// ticks on the scheduler thread itself instead of a job system worker, so it gets that thread's priority and
+	// core (polling). Nothing else is dispatched while it runs, keep such ticks short
+	bool runOnSchedulerThread = false;
+};
+
+struct TickSubsystemStats
+{
+	const char* name = nullptr;
+	uint64_t ticks = 0u;
+	// FIXED_RATE / FIXED_STEP: ticks that took longer than the period
+	uint64_t overruns = 0u;
+	// FIXED_RATE: ticks that couldn't start on time, FIXED_STEP: steps dropped by the catch-up limit
+	uint64_t skippedTicks = 0u;
+	float avgTickMs = 0.0f;
+	float maxTickMs = 0.0f;
+	// from the scheduled time until a worker started the tick (the deadline error of FIXED_RATE / FIXED_STEP),
+	// percentiles over the last LATENCY_SAMPLE_COUNT ticks
+	float avgLatencyMs = 0.0f;
+	float p50LatencyMs = 0.0f;
+	float p99LatencyMs = 0.0f;
+	float maxLatencyMs = 0.0f;
+};
+
+struct TickSchedulerStats
+{
+	// how much later than requested the OS usually wakes the scheduler thread up
+	float sleepOvershootMs = 0.0f;
+	// share of the scheduler thread's waiting time that was spent spinning instead of sleeping
+	float spinRatio = 0.0f;
+};
+
+/*
+ * Drives the game's subsystems at their own rates from a single scheduler thread.
+ *
+ * Subsystems register a tick function with a mode and a rate. The scheduler thread sleeps through most of the time
+ * until the next tick is due (and spins for the last bit, as long as the sleep overshoot it measured) and hands due ticks to the job system, so the ticks run on the
+ * workers and no subsystem needs a thread of its own. Short ticks that need the scheduler thread's priority and
+ * core run on it directly (runOnSchedulerThread). A subsystem never ticks twice at the same time: a fixed rate
+ * tick that is due while the previous one still runs is dropped, a fixed step waits and is caught up afterwards.
+ *
+ * Run is called by the main thread (worker 0 of the job system), which executes ticks until Stop is called.
+ */
+class TickScheduler
+{
+public:
+	static constexpr uint32_t MAX_SUBSYSTEMS = 16u;
+	static constexpr uint32_t INVALID_SUBSYSTEM = ~0u;
+	// how long the thread in Run sleeps at most when there is no work, before it re-checks for Stop
+	static constexpr uint32_t IDLE_WAIT_MICROSECONDS = 1000u;
+	// how long the scheduler thread spins at most before a deadline, at normal and at real-time priority
+	static constexpr uint32_t MAX_SPIN_MICROSECONDS = 500u;
+	static constexpr uint32_t MAX_REALTIME_SPIN_MICROSECONDS = 20u;
+	// latencies per subsystem the percentiles are taken from
+	static constexpr uint32_t LATENCY_SAMPLE_COUNT = 512u;
+
+	TickScheduler() = default;
+	TickScheduler( const TickScheduler& ) = delete;
+	TickScheduler& operator=( const TickScheduler& ) = delete;
+
+	/*
+	 * Adds a subsystem, call before Run. Returns its id or INVALID_SUBSYSTEM when the description is incomplete
+	 * or all MAX_SUBSYSTEMS are in use
+	 */
+	uint32_t Register( const TickSubsystemDesc& desc )
+	{
+		const bool needsRate = desc.mode == TickMode::FIXED_RATE || desc.mode == TickMode::FIXED_STEP;
+		if ( SubsystemCount >= MAX_SUBSYSTEMS || desc.function == nullptr || ( needsRate && desc.ticksPerSecond == 0u ) )
+		{
+			return INVALID_SUBSYSTEM;
+		}
+
+		const uint32_t id = SubsystemCount++;
+		Subsystem& subsystem = Subsystems[ id ];
+		subsystem.Desc = desc;
+		subsystem.Desc.name = desc.name != nullptr ? desc.name : "Unnamed";
+		subsystem.Desc.maxCatchUpSteps = desc.maxCatchUpSteps > 0u ? desc.maxCatchUpSteps : 1u;
+		subsystem.Owner = this;
+
+		// dispatch order: highest priority first, the job system hands out jobs from outside of the pool in order
+		DispatchOrder[ id ] = id;
+		for ( uint32_t i = id; i > 0u && Subsystems[ DispatchOrder[ i - 1u ] ].Desc.priority < desc.priority; --i )
+		{
+			DispatchOrder[ i ] = DispatchOrder[ i - 1u ];
+			DispatchOrder[ i - 1u ] = id;
+		}
+		return id;
+	}
+
+	/*
+	 * Any thread - an ON_DEMAND subsystem ticks once soon after, requests that arrive before it ticked are merged
+	 */
+	void Request( uint32_t id )
+	{
+		if ( id >= SubsystemCount )
+		{
+			return;
+		}
+
+		Subsystems[ id ].Requests.fetch_add( 1u, std::memory_order_release );
+		Wake();
+	}
+
+	/*
+	 * Starts the scheduler thread and executes jobs on the calling thread until Stop is called. Returns once all
+	 * ticks finished, requests that were made before Stop are served first
+	 */
+	void Run( threadPriority_t priority = threadPriority_t::HIGH, uint64_t affinityMask = 0u )
+	{
+		IsRunning.store( true );
+		IsRealtime = priority == threadPriority_t::HIGH || priority == threadPriority_t::TIME_CRITICAL;
+
+		threadCreateParam_t params;
+		params.function = DispatchMain;
+		params.params = this;
+		params.name = "TickScheduler";
+		params.priority = priority;
+		params.affinityMask = affinityMask;
+		const threadHandle_t thread = Sys_CreateThread( params );
+		if ( thread == INVALID_THREAD_HANDLE )
+		{
+			IsRunning.store( false );
+			return;
+		}
+
+		while ( IsRunning.load( std::memory_order_acquire ) )
+		{
+			Sys_ExecuteJob( IDLE_WAIT_MICROSECONDS );
+		}
+
+		Sys_WaitForThread( thread );
+		Sys_DestroyThread( thread );
+
+		while ( HasTicksInFlight() )
+		{
+			Sys_ExecuteJob( IDLE_WAIT_MICROSECONDS );
+		}
+
+		// the scheduler thread is gone, tick the outstanding requests right here
+		for ( uint32_t id = 0u; id < SubsystemCount; ++id )
+		{
+			Subsystem& subsystem = Subsystems[ id ];
+			if ( subsystem.Desc.mode == TickMode::ON_DEMAND && subsystem.Requests.exchange( 0u, std::memory_order_acquire ) > 0u )
+			{
+				const TimePoint now = Clock::Now();
+				PrepareTick( subsystem, subsystem.NextIndex++, now, now - subsystem.LastScheduled );
+				subsystem.InFlight.store( true, std::memory_order_relaxed );
+				TickJob( &subsystem );
+			}
+		}
+	}
+
+	/*
+	 * Any thread, usually called from within a tick - Run returns once the running ticks finished
+	 */
+	void Stop()
+	{
+		IsRunning.store( false, std::memory_order_release );
+		Wake();
+	}
+
+	uint32_t GetStats( TickSubsystemStats* stats, uint32_t capacity ) const
+	{
+		const uint32_t count = SubsystemCount < capacity ? SubsystemCount : capacity;
+		for ( uint32_t id = 0u; id < count; ++id )
+		{
+			const Subsystem& subsystem = Subsystems[ id ];
+			const uint64_t ticks = subsystem.Ticks.load( std::memory_order_relaxed );
+
+			TickSubsystemStats& entry = stats[ id ];
+			entry = TickSubsystemStats();
+			entry.name = subsystem.Desc.name;
+			entry.ticks = ticks;
+			entry.overruns = subsystem.Overruns.load( std::memory_order_relaxed );
+			entry.skippedTicks = subsystem.SkippedTicks.load( std::memory_order_relaxed );
+			entry.maxTickMs = ToMilliseconds( subsystem.MaxTickNanoseconds.load( std::memory_order_relaxed ) );
+			entry.maxLatencyMs = ToMilliseconds( subsystem.MaxLatencyNanoseconds.load( std::memory_order_relaxed ) );
+			if ( ticks == 0u )
+			{
+				continue;
+			}
+
+			entry.avgTickMs = ToMilliseconds( subsystem.TotalTickNanoseconds.load( std::memory_order_relaxed ) / ticks );
+			entry.avgLatencyMs = ToMilliseconds( subsystem.TotalLatencyNanoseconds.load( std::memory_order_relaxed ) / ticks );
+
+			// a tick that runs right now may replace a sample while it is copied, that only shifts the percentiles by one sample
+			const uint32_t sampleCount = ticks < LATENCY_SAMPLE_COUNT ? static_cast< uint32_t >( ticks ) : LATENCY_SAMPLE_COUNT;
+			uint64_t sorted[ LATENCY_SAMPLE_COUNT ];
+			for ( uint32_t i = 0u; i < sampleCount; ++i )
+			{
+				sorted[ i ] = subsystem.LatencySamples[ i ].load( std::memory_order_relaxed );
+			}
+			std::sort( sorted, sorted + sampleCount );
+			entry.p50LatencyMs = ToMilliseconds( sorted[ ( sampleCount - 1u ) / 2u ] );
+			entry.p99LatencyMs = ToMilliseconds( sorted[ ( ( sampleCount - 1u ) * 99u ) / 100u ] );
+		}
+		return count;
+	}
+
+	TickSchedulerStats GetSchedulerStats() const
+	{
+		TickSchedulerStats stats;
+		stats.sleepOvershootMs = ToMilliseconds( OvershootNanoseconds.load( std::memory_order_relaxed ) );
+		const uint64_t waited = WaitNanoseconds.load( std::memory_order_relaxed );
+		stats.spinRatio = waited > 0u ? static_cast< float >( static_cast< double >( SpinNanoseconds.load( std::memory_order_relaxed ) ) / static_cast< double >( waited ) ) : 0.0f;
+		return stats;
+	}
+
+private:
+	struct Subsystem
+	{
+		TickSubsystemDesc Desc;
+		TickScheduler* Owner { nullptr };
+
+		// scheduler thread
+		TimePoint ScheduleStart;
+		uint64_t NextIndex { 0u };
+		TimePoint LastScheduled;
+
+		// written by the scheduler thread before the tick is dispatched, read by the tick
+		TickInfo Tick;
+		std::atomic< bool > InFlight { false };
+		std::atomic< uint32_t > Requests { 0u };
+
+		std::atomic< uint64_t > Ticks { 0u };
+		std::atomic< uint64_t > Overruns { 0u };
+		std::atomic< uint64_t > SkippedTicks { 0u };
+		std::atomic< uint64_t > TotalTickNanoseconds { 0u };
+		std::atomic< uint64_t > MaxTickNanoseconds { 0u };
+		std::atomic< uint64_t > TotalLatencyNanoseconds { 0u };
+		std::atomic< uint64_t > MaxLatencyNanoseconds { 0u };
+		// ring indexed by the tick count, only the subsystem's own ticks write it
+		std::atomic< uint64_t > LatencySamples[ LATENCY_SAMPLE_COUNT ] = {};
+	};
+
+	static void DispatchMain( void* params )
+	{
+		static_cast< TickScheduler* >( params )->DispatchLoop();
+	}
+
+	static void TickJob( void* params )
+	{
+		Subsystem& subsystem = *static_cast< Subsystem* >( params );
+		const TickInfo& tick = subsystem.Tick;
+
+		const TimePoint start = Clock::Now();
+		{
+			PROFILE_SCOPE( subsystem.Desc.name );
+			subsystem.Desc.function( tick, subsystem.Desc.userData );
+		}
+		const TimePoint end = Clock::Now();
+
+		const Duration duration = end - start;
+		const bool isPeriodic = subsystem.Desc.mode == TickMode::FIXED_RATE || subsystem.Desc.mode == TickMode::FIXED_STEP;
+		if ( isPeriodic && duration > tick.deltaTime )
+		{
+			subsystem.Overruns.fetch_add( 1u, std::memory_order_relaxed );
+		}
+		AddSample( subsystem.TotalTickNanoseconds, subsystem.MaxTickNanoseconds, duration );
+		const uint64_t latency = AddSample( subsystem.TotalLatencyNanoseconds, subsystem.MaxLatencyNanoseconds, start - tick.scheduledTime );
+		const uint64_t tickCount = subsystem.Ticks.load( std::memory_order_relaxed );
+		subsystem.LatencySamples[ tickCount % LATENCY_SAMPLE_COUNT ].store( latency, std::memory_order_relaxed );
+		subsystem.Ticks.store( tickCount + 1u, std::memory_order_relaxed );
+
+		subsystem.InFlight.store( false, std::memory_order_release );
+		if ( subsystem.Desc.mode != TickMode::FIXED_RATE )
+		{
+			// continuous and on demand subsystems, and fixed steps that fell behind, are due again right away
+			subsystem.Owner->Wake();
+		}
+	}
+
+	/*
+	 * Returns the sample in nanoseconds, negative ones count as zero
+	 */
+	static uint64_t AddSample( std::atomic< uint64_t >& total, std::atomic< uint64_t >& maximum, Duration sample )
+	{
+		const uint64_t nanoseconds = sample > Duration() ? static_cast< uint64_t >( sample.ToNanoseconds() ) : 0u;
+		total.fetch_add( nanoseconds, std::memory_order_relaxed );
+		if ( nanoseconds > maximum.load( std::memory_order_relaxed ) )
+		{
+			// only the subsystem's own (never overlapping) ticks write here
+			maximum.store( nanoseconds, std::memory_order_relaxed );
+		}
+		return nanoseconds;
+	}
+
+	static float ToMilliseconds( uint64_t nanoseconds )
+	{
+		return static_cast< float >( static_cast< double >( nanoseconds ) / 1000000.0 );
+	}
+
+	void DispatchLoop()
+	{
+		Overshoot.Calibrate();
+		OvershootNanoseconds.store( static_cast< uint64_t >( std::max( Overshoot.Get(), Duration() ).ToNanoseconds() ), std::memory_order_relaxed );
+
+		const TimePoint start = Clock::Now();
+		for ( uint32_t id = 0u; id < SubsystemCount; ++id )
+		{
+			Subsystems[ id ].ScheduleStart = start;
+			Subsystems[ id ].LastScheduled = start;
+		}
+
+		while ( IsRunning.load( std::memory_order_acquire ) )
+		{
+			// finished ticks, requests and Stop wake us up before
+			const TimePoint now = Clock::Now();
+			TimePoint nextDeadline = now + Duration::FromSeconds( 1 );
+
+			for ( uint32_t i = 0u; i < SubsystemCount; ++i )
+			{
+				const TimePoint deadline = Dispatch( Subsystems[ DispatchOrder[ i ] ], now );
+				if ( deadline < nextDeadline )
+				{
+					nextDeadline = deadline;
+				}
+			}
+
+			WaitUntil( nextDeadline );
+		}
+	}
+
+	/*
+	 * Dispatches the subsystem's tick if it is due, returns when it wants to be looked at again at the latest
+	 * (finishing ticks wake the scheduler up earlier)
+	 */
+	TimePoint Dispatch( Subsystem& subsystem, TimePoint now )
+	{
+		const TimePoint never = now + Duration::FromSeconds( 1 );
+		const bool isIdle = !subsystem.InFlight.load( std::memory_order_acquire );
+
+		switch ( subsystem.Desc.mode )
+		{
+		case TickMode::FIXED_RATE:
+		case TickMode::FIXED_STEP:
+		{
+			const uint32_t rate = subsystem.Desc.ticksPerSecond;
+			if ( now < subsystem.ScheduleStart + TickOffset( subsystem.NextIndex, rate ) )
+			{
+				return subsystem.ScheduleStart + TickOffset( subsystem.NextIndex, rate );
+			}
+
+			const uint64_t latestIndex = static_cast< uint64_t >( ( now - subsystem.ScheduleStart ).ToNanoseconds() ) * rate / 1000000000u;
+			if ( subsystem.Desc.mode == TickMode::FIXED_RATE )
+			{
+				// ticks that were missed (late wake-up) or whose slot is still occupied are gone, only the latest one runs
+				const uint64_t missed = latestIndex - subsystem.NextIndex + ( isIdle ? 0u : 1u );
+				subsystem.SkippedTicks.fetch_add( missed, std::memory_order_relaxed );
+				if ( isIdle )
+				{
+					Launch( subsystem, latestIndex, subsystem.ScheduleStart + TickOffset( latestIndex, rate ), TickOffset( 1u, rate ) );
+				}
+				subsystem.NextIndex = latestIndex + 1u;
+			}
+			else if ( isIdle )
+			{
+				const uint64_t backlog = latestIndex - subsystem.NextIndex + 1u;
+				if ( backlog > subsystem.Desc.maxCatchUpSteps )
+				{
+					// catching up on everything would only make the next frame later still, the simulation slows down instead
+					subsystem.SkippedTicks.fetch_add( backlog - subsystem.Desc.maxCatchUpSteps, std::memory_order_relaxed );
+					subsystem.NextIndex = latestIndex + 1u - subsystem.Desc.maxCatchUpSteps;
+				}
+				const uint64_t index = subsystem.NextIndex++;
+				Launch( subsystem, index, subsystem.ScheduleStart + TickOffset( index, rate ), TickOffset( 1u, rate ) );
+			}
+			else
+			{
+				// the step is caught up once the running one finished
+				return never;
+			}
+			return subsystem.ScheduleStart + TickOffset( subsystem.NextIndex, rate );
+		}
+		case TickMode::CONTINUOUS:
+			if ( isIdle )
+			{
+				Launch( subsystem, subsystem.NextIndex++, now, now - subsystem.LastScheduled );
+			}
+			return never;
+		case TickMode::ON_DEMAND:
+			if ( isIdle && subsystem.Requests.exchange( 0u, std::memory_order_acquire ) > 0u )
+			{
+				Launch( subsystem, subsystem.NextIndex++, now, now - subsystem.LastScheduled );
+			}
+			return never;
+		default:
+			return never;
+		}
+	}
+
+	void PrepareTick( Subsystem& subsystem, uint64_t index, TimePoint scheduledTime, Duration deltaTime )
+	{
+		subsystem.Tick.index = index;
+		subsystem.Tick.scheduledTime = scheduledTime;
+		subsystem.Tick.deltaTime = deltaTime;
+		subsystem.LastScheduled = scheduledTime;
+	}
+
+	void Launch( Subsystem& subsystem, uint64_t index, TimePoint scheduledTime, Duration deltaTime )
+	{
+		PrepareTick( subsystem, index, scheduledTime, deltaTime );
+		subsystem.InFlight.store( true, std::memory_order_relaxed );
+		if ( subsystem.Desc.runOnSchedulerThread )
+		{
+			TickJob( &subsystem );
+		}
+		else
+		{
+			Sys_RunJob( Sys_CreateJob( TickJob, &subsystem ) );
+		}
+	}
+
+	bool HasTicksInFlight() const
+	{
+		for ( uint32_t id = 0u; id < SubsystemCount; ++id )
+		{
+			if ( Subsystems[ id ].InFlight.load( std::memory_order_acquire ) )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Wake()
+	{
+		{
+			std::lock_guard< std::mutex > lock( WakeMutex );
+			WakeRequested = true;
+		}
+		WakeCondition.notify_one();
+	}
+
+	/*
+	 * Sleeps through most of the time until `deadline` and spins for the rest, returns early when woken up
+	 */
+	void WaitUntil( TimePoint deadline )
+	{
+		const Duration spinMargin = Duration::FromMicroseconds( 250 );
+		// on small machines this thread shares a core with the workers: after a few late wake-ups an uncapped spin would
+		// run through entire 1 ms periods and starve them, so the spinning is capped and late wake-ups cost precision
+		// instead. A real-time thread preempts the workers and the OS wakes it without timer slack, it barely needs to
+		// spin - and spinning at real-time priority before every 1 ms poll would take a good part of a core
+		const Duration maxSpin = Duration::FromMicroseconds( IsRealtime ? MAX_REALTIME_SPIN_MICROSECONDS : MAX_SPIN_MICROSECONDS );
+		const TimePoint waitStart = Clock::Now();
+		TimePoint now = waitStart;
+
+		while ( true )
+		{
+			const Duration spin = Overshoot.Get() + spinMargin < maxSpin ? Overshoot.Get() + spinMargin : maxSpin;
+			if ( deadline - now <= spin )
+			{
+				break;
+			}
+			const Duration requested = deadline - now - spin;
+
+			std::unique_lock< std::mutex > lock( WakeMutex );
+			if ( WakeCondition.wait_for( lock, std::chrono::microseconds( requested.ToMicroseconds() ), [ this ] { return WakeRequested; } ) )
+			{
+				WakeRequested = false;
+				lock.unlock();
+				TrackWait( Clock::Now() - waitStart, Duration() );
+				return;
+			}
+			lock.unlock();
+
+			const TimePoint sleptUntil = Clock::Now();
+			Overshoot.Track( ( sleptUntil - now ) - requested );
+			OvershootNanoseconds.store( static_cast< uint64_t >( std::max( Overshoot.Get(), Duration() ).ToNanoseconds() ), std::memory_order_relaxed );
+			now = sleptUntil;
+		}
+
+		const TimePoint spinStart = now;
+		while ( now < deadline )
+		{
+			now = Clock::Now();
+		}
+		TrackWait( now - waitStart, now - spinStart );
+	}
+
+	void TrackWait( Duration waited, Duration spun )
+	{
+		WaitNanoseconds.fetch_add( static_cast< uint64_t >( waited.ToNanoseconds() ), std::memory_order_relaxed );
+		SpinNanoseconds.fetch_add( static_cast< uint64_t >( spun.ToNanoseconds() ), std::memory_order_relaxed );
+	}
+
+	Subsystem Subsystems[ MAX_SUBSYSTEMS ];
+	uint32_t DispatchOrder[ MAX_SUBSYSTEMS ] = {};
+	uint32_t SubsystemCount { 0u };
+
+	std::atomic< bool > IsRunning { false };
+	// scheduler thread runs at HIGH or TIME_CRITICAL priority, set by Run
+	bool IsRealtime { false };
+	std::mutex WakeMutex;
+	std::condition_variable WakeCondition;
+	bool WakeRequested { false };
+	SleepOvershoot Overshoot;
+
+	// written by the scheduler thread, read by GetSchedulerStats
+	std::atomic< uint64_t > OvershootNanoseconds { 0u };
+	std::atomic< uint64_t > WaitNanoseconds { 0u };
+	std::atomic< uint64_t > SpinNanoseconds { 0u };
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Wait-free single-writer / single-reader "latest value" channel.
+ *
+ * The writer fills its back buffer and publishes it by swapping it with the middle buffer, the reader swaps the
+ * middle buffer with its front buffer whenever a new one was published. Neither side ever waits or sees a half
+ * written value, and unlike a queue the reader only ever gets the newest state (older ones are overwritten).
+ */
+template < typename T >
+class TripleBuffer
+{
+public:
+	static constexpr size_t CACHE_LINE_SIZE = 64u;
+
+	// writer side - fill this, then Publish
+	T& GetWriteBuffer()
+	{
+		return Buffers[ BackIndex ];
+	}
+
+	void Publish()
+	{
+		const uint32_t previous = Middle.exchange( BackIndex | NEW_DATA_FLAG, std::memory_order_acq_rel );
+		BackIndex = previous & INDEX_MASK;
+	}
+
+	// reader side - returns true if a newer value was published since the last call
+	bool Acquire()
+	{
+		if ( ( Middle.load( std::memory_order_relaxed ) & NEW_DATA_FLAG ) == 0u )
+		{
+			return false;
+		}
+
+		const uint32_t previous = Middle.exchange( FrontIndex, std::memory_order_acq_rel );
+		FrontIndex = previous & INDEX_MASK;
+		return true;
+	}
+
+	const T& GetReadBuffer() const
+	{
+		return Buffers[ FrontIndex ];
+	}
+
+private:
+	static constexpr uint32_t INDEX_MASK = 3u;
+	static constexpr uint32_t NEW_DATA_FLAG = 4u;
+
+	// index of the buffer in the middle, plus NEW_DATA_FLAG if the reader hasn't picked it up yet
+	alignas( CACHE_LINE_SIZE ) std::atomic< uint32_t > Middle { 1u };
+	// writer side
+	alignas( CACHE_LINE_SIZE ) uint32_t BackIndex { 0u };
+	// reader side
+	alignas( CACHE_LINE_SIZE ) uint32_t FrontIndex { 2u };
+
+	T Buffers[ 3 ];
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../core/ClockTypes.h"
+#include "../core/TripleBuffer.h"
+
+#include "GamepadInputTypes.h"
+
+/*
+ * Action mapping: named game actions ("Save", "Quit", ...) bound to button chords, holds or sequences.
+ *
+ * Bindings are plain literal types, so a game's default bindings are a constexpr table that is checked with a
+ * static_assert (ValidateBindings) and needs no setup at runtime. The map is evaluated by the producer of the
+ * button events once per poll: every action becomes one bit of a dense per-pad mask that travels through the
+ * event queue next to the buttons, so per-frame action queries are single bit tests (see InputFrame).
+ */
+namespace Input
+{
+	constexpr uint32_t MAX_ACTION_BINDINGS = 32u;
+	constexpr uint32_t MAX_SEQUENCE_LENGTH = 4u;
+
+	enum class BindingType : uint8_t
+	{
+		CHORD,		// active while all buttons are down
+		HOLD,		// active once all buttons were down for `duration`
+		SEQUENCE,	// active for one poll when the buttons were pressed in order, each within `duration` of the last
+	};
+
+	struct ActionBinding
+	{
+		const char* name = nullptr;
+		uint32_t action = 0u;
+		BindingType type = BindingType::CHORD;
+		// CHORD / HOLD - ButtonBit mask
+		int buttons = 0;
+		// HOLD - hold time, SEQUENCE - max. time between two steps
+		Duration duration;
+		// SEQUENCE - GamepadButtons values in order
+		uint8_t sequence[MAX_SEQUENCE_LENGTH] = {};
+		uint8_t sequenceLength = 0u;
+	};
+
+	constexpr ActionBinding ChordBinding(const char* name, uint32_t action, int buttons) {
+		ActionBinding binding;
+		binding.name = name;
+		binding.action = action;
+		binding.type = BindingType::CHORD;
+		binding.buttons = buttons;
+		return binding;
+	}
+
+	constexpr ActionBinding HoldBinding(const char* name, uint32_t action, int buttons, Duration duration) {
+		ActionBinding binding;
+		binding.name = name;
+		binding.action = action;
+		binding.type = BindingType::HOLD;
+		binding.buttons = buttons;
+		binding.duration = duration;
+		return binding;
+	}
+
+	constexpr ActionBinding SequenceBinding(const char* name, uint32_t action, Duration stepTime, GamepadButtons first, GamepadButtons second) {
+		ActionBinding binding;
+		binding.name = name;
+		binding.action = action;
+		binding.type = BindingType::SEQUENCE;
+		binding.duration = stepTime;
+		binding.sequence[0] = static_cast<uint8_t>(first);
+		binding.sequence[1] = static_cast<uint8_t>(second);
+		binding.sequenceLength = 2u;
+		return binding;
+	}
+
+	constexpr ActionBinding SequenceBinding(const char* name, uint32_t action, Duration stepTime, GamepadButtons first, GamepadButtons second,
+		GamepadButtons third) {
+		ActionBinding binding = SequenceBinding(name, action, stepTime, first, second);
+		binding.sequence[2] = static_cast<uint8_t>(third);
+		binding.sequenceLength = 3u;
+		return binding;
+	}
+
+	constexpr bool IsValidBinding(const ActionBinding& binding) {
+		if (binding.action >= MAX_ACTIONS) {
+			return false;
+		}
+		switch (binding.type) {
+		case BindingType::CHORD:
+			return binding.buttons != 0;
+		case BindingType::HOLD:
+			return binding.buttons != 0 && binding.duration > Duration();
+		case BindingType::SEQUENCE:
+			if (binding.sequenceLength < 2u || binding.sequenceLength > MAX_SEQUENCE_LENGTH || binding.duration <= Duration()) {
+				return false;
+			}
+			for (uint32_t i = 0u; i < binding.sequenceLength; ++i) {
+				if (binding.sequence[i] >= GAMEPAD_BUTTON_COUNT) {
+					return false;
+				}
+			}
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	template <uint32_t Count>
+	constexpr bool ValidateBindings(const ActionBinding (&bindings)[Count]) {
+		if (Count > MAX_ACTION_BINDINGS) {
+			return false;
+		}
+		for (uint32_t i = 0u; i < Count; ++i) {
+			if (!IsValidBinding(bindings[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	struct ActionBindingTable
+	{
+		ActionBinding bindings[MAX_ACTION_BINDINGS];
+		uint32_t count = 0u;
+	};
+
+	/*
+	 * Bindings are owned by the game thread (SetBindings / Rebind) and handed to the evaluating thread through a
+	 * triple buffer, so rebinding at runtime never blocks a poll
+	 */
+	class ActionMap
+	{
+	public:
+		/*
+		 * Game thread - replaces all bindings, invalid ones are skipped
+		 */
+		template <uint32_t Count>
+		void SetBindings(const ActionBinding (&bindings)[Count]) {
+			SetBindings(bindings, Count);
+		}
+
+		void SetBindings(const ActionBinding* bindings, uint32_t count) {
+			m_Bindings.count = 0u;
+			for (uint32_t i = 0u; i < count && m_Bindings.count < MAX_ACTION_BINDINGS; ++i) {
+				if (IsValidBinding(bindings[i])) {
+					m_Bindings.bindings[m_Bindings.count++] = bindings[i];
+				}
+			}
+			PublishBindings();
+		}
+
+		/*
+		 * Game thread - replaces every binding of `binding.action` with `binding`
+		 */
+		bool Rebind(const ActionBinding& binding) {
+			if (!IsValidBinding(binding)) {
+				return false;
+			}
+
+			uint32_t kept = 0u;
+			for (uint32_t i = 0u; i < m_Bindings.count; ++i) {
+				if (m_Bindings.bindings[i].action != binding.action) {
+					m_Bindings.bindings[kept++] = m_Bindings.bindings[i];
+				}
+			}
+			if (kept >= MAX_ACTION_BINDINGS) {
+				return false;
+			}
+			m_Bindings.bindings[kept++] = binding;
+			m_Bindings.count = kept;
+
+			PublishBindings();
+			return true;
+		}
+
+		// game thread
+		const ActionBindingTable& GetBindings() const {
+			return m_Bindings;
+		}
+
+		/*
+		 * Producer thread - turns this poll's neutral button masks into action masks
+		 */
+		void Evaluate(const int (&states)[MAX_GAMEPADS], TimePoint timestamp, int (&actions)[MAX_GAMEPADS]) {
+			if (m_Pending.Acquire()) {
+				m_Active = m_Pending.GetReadBuffer();
+				ResetProgress();
+			}
+
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				const int state = states[pad];
+				const int downs = state & ~m_PreviousStates[pad];
+				m_PreviousStates[pad] = state;
+
+				int active = 0;
+				for (uint32_t i = 0u; i < m_Active.count; ++i) {
+					if (EvaluateBinding(m_Active.bindings[i], m_Progress[pad][i], state, downs, timestamp)) {
+						active |= ActionBit(m_Active.bindings[i].action);
+					}
+				}
+				actions[pad] = active;
+			}
+		}
+
+	private:
+		struct BindingProgress
+		{
+			TimePoint since;
+			uint32_t step = 0u;
+		};
+
+		static bool EvaluateBinding(const ActionBinding& binding, BindingProgress& progress, int state, int downs, TimePoint timestamp) {
+			switch (binding.type) {
+			case BindingType::CHORD:
+				return (state & binding.buttons) == binding.buttons;
+			case BindingType::HOLD:
+				if ((state & binding.buttons) != binding.buttons) {
+					progress.step = 0u;
+					return false;
+				}
+				if (progress.step == 0u) {
+					progress.step = 1u;
+					progress.since = timestamp;
+				}
+				return timestamp - progress.since >= binding.duration;
+			case BindingType::SEQUENCE:
+				if (progress.step > 0u && timestamp - progress.since > binding.duration) {
+					progress.step = 0u;
+				}
+				if (downs == 0) {
+					return false;
+				}
+				if ((downs & ButtonBit(static_cast<GamepadButtons>(binding.sequence[progress.step]))) != 0) {
+					++progress.step;
+				}
+				else {
+					// a wrong button restarts the sequence, it may be the start of a new attempt
+					progress.step = (downs & ButtonBit(static_cast<GamepadButtons>(binding.sequence[0]))) != 0 ? 1u : 0u;
+				}
+				progress.since = timestamp;
+				if (progress.step == binding.sequenceLength) {
+					progress.step = 0u;
+					return true;
+				}
+				return false;
+			default:
+				return false;
+			}
+		}
+
+		void PublishBindings() {
+			m_Pending.GetWriteBuffer() = m_Bindings;
+			m_Pending.Publish();
+		}
+
+		void ResetProgress() {
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				for (uint32_t i = 0u; i < MAX_ACTION_BINDINGS; ++i) {
+					m_Progress[pad][i] = BindingProgress();
+				}
+			}
+		}
+
+		// game thread
+		ActionBindingTable m_Bindings;
+		TripleBuffer<ActionBindingTable> m_Pending;
+
+		// producer thread
+		ActionBindingTable m_Active;
+		BindingProgress m_Progress[MAX_GAMEPADS][MAX_ACTION_BINDINGS];
+		int m_PreviousStates[MAX_GAMEPADS] = {};
+	};
+}
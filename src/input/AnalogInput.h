@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <xmmintrin.h>
+	#define INPUT_ANALOG_SSE 1
+#endif
+
+#include "../core/ClockTypes.h"
+#include "../core/TripleBuffer.h"
+
+#include "GamepadInputTypes.h"
+#include "InputEventQueue.h"
+
+namespace Input
+{
+	// two sticks and two triggers per pad, stick / trigger i belongs to pad i / 2 (even = left, odd = right)
+	constexpr uint32_t ANALOG_STICK_COUNT = MAX_GAMEPADS * 2u;
+	constexpr uint32_t ANALOG_TRIGGER_COUNT = MAX_GAMEPADS * 2u;
+	static_assert(ANALOG_STICK_COUNT % 4u == 0u && ANALOG_TRIGGER_COUNT % 4u == 0u, "analog batches are processed 4 wide");
+
+	struct AnalogSettings
+	{
+		// radial deadzone as a fraction of the full deflection (XInput's recommended left stick value)
+		float stickDeadzone = 0.24f;
+		// deflections beyond 1 - this count as full, worn sticks often don't reach the edge of the gate
+		float stickOuterDeadzone = 0.02f;
+		float triggerDeadzone = 0.12f;
+		// blend between a linear (0) and a cubic (1) response, higher values give more precision near the center
+		float responseCurve = 0.5f;
+		// time constant of the exponential smoothing, zero turns it off
+		Duration smoothingTime = Duration::FromMilliseconds(8);
+	};
+
+	// normalized values of one poll as read from the devices
+	struct AnalogSample
+	{
+		float stickX[ANALOG_STICK_COUNT] = {};
+		float stickY[ANALOG_STICK_COUNT] = {};
+		float triggers[ANALOG_TRIGGER_COUNT] = {};
+	};
+
+	// processed axes of all pads
+	struct AnalogState
+	{
+		float axes[MAX_GAMEPADS][GAMEPAD_AXIS_COUNT] = {};
+		TimePoint timestamp;
+	};
+
+	// XInput sticks
+	inline float NormalizeSigned16(int16_t value) {
+		return value < 0 ? static_cast<float>(value) / 32768.0f : static_cast<float>(value) / 32767.0f;
+	}
+
+	// ScePad sticks, 0..255 with the center at 128 (y points down)
+	inline float NormalizeCentered8(uint8_t value) {
+		return value < 128u ? (static_cast<float>(value) - 128.0f) / 128.0f : (static_cast<float>(value) - 128.0f) / 127.0f;
+	}
+
+	// triggers on both platforms
+	inline float NormalizeUnsigned8(uint8_t value) {
+		return static_cast<float>(value) / 255.0f;
+	}
+
+	inline float Clamp01(float value) {
+		const float low = value > 0.0f ? value : 0.0f;
+		return low < 1.0f ? low : 1.0f;
+	}
+
+	/*
+	 * Processes the analog axes of all pads once per poll and hands them to the game thread.
+	 *
+	 * Deadzones, response curve and smoothing run in one batch over contiguous per-stick / per-trigger arrays,
+	 * four lanes at a time with SSE (PC, PS4, Linux x64) and a scalar loop elsewhere. The result is published through a
+	 * triple buffer: the game thread picks up the newest state in BeginFrame without ever waiting for the input
+	 * thread, queries within a frame all see that state.
+	 */
+	class AnalogInput
+	{
+	public:
+		AnalogInput() {
+			UpdateSmoothingFactor();
+		}
+
+		/*
+		 * Set both before the input thread starts
+		 */
+		void SetSettings(const AnalogSettings& settings) {
+			m_Settings = settings;
+			UpdateSmoothingFactor();
+		}
+
+		void SetPollRate(uint32_t pollRate) {
+			m_PollRate = pollRate;
+			UpdateSmoothingFactor();
+		}
+
+		const AnalogSettings& GetSettings() const {
+			return m_Settings;
+		}
+
+		/*
+		 * Input thread - processes one poll and publishes it
+		 */
+		void Publish(const AnalogSample& sample, TimePoint timestamp) {
+			float stickX[ANALOG_STICK_COUNT];
+			float stickY[ANALOG_STICK_COUNT];
+			float triggers[ANALOG_TRIGGER_COUNT];
+			ProcessSticks(sample, stickX, stickY);
+			ProcessTriggers(sample, triggers);
+
+			Smooth(m_StickX, stickX, ANALOG_STICK_COUNT);
+			Smooth(m_StickY, stickY, ANALOG_STICK_COUNT);
+			Smooth(m_Triggers, triggers, ANALOG_TRIGGER_COUNT);
+
+			AnalogState& state = m_States.GetWriteBuffer();
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				float* axes = state.axes[pad];
+				axes[static_cast<int>(GamepadAxis::LEFT_STICK_X)] = m_StickX[pad * 2u];
+				axes[static_cast<int>(GamepadAxis::LEFT_STICK_Y)] = m_StickY[pad * 2u];
+				axes[static_cast<int>(GamepadAxis::RIGHT_STICK_X)] = m_StickX[pad * 2u + 1u];
+				axes[static_cast<int>(GamepadAxis::RIGHT_STICK_Y)] = m_StickY[pad * 2u + 1u];
+				axes[static_cast<int>(GamepadAxis::LEFT_TRIGGER)] = m_Triggers[pad * 2u];
+				axes[static_cast<int>(GamepadAxis::RIGHT_TRIGGER)] = m_Triggers[pad * 2u + 1u];
+			}
+			state.timestamp = timestamp;
+			m_States.Publish();
+		}
+
+		/*
+		 * Game thread - picks up the newest state, call once per frame before any query
+		 */
+		void BeginFrame() {
+			m_States.Acquire();
+		}
+
+		float GetAxis(uint32_t pad, GamepadAxis axis) const {
+			return m_States.GetReadBuffer().axes[pad][static_cast<int>(axis)];
+		}
+
+		void GetAxes(uint32_t pad, float (&axes)[GAMEPAD_AXIS_COUNT]) const {
+			const AnalogState& state = m_States.GetReadBuffer();
+			for (uint32_t i = 0u; i < GAMEPAD_AXIS_COUNT; ++i) {
+				axes[i] = state.axes[pad][i];
+			}
+		}
+
+		// poll time of the state the game thread currently sees
+		TimePoint GetTimestamp() const {
+			return m_States.GetReadBuffer().timestamp;
+		}
+
+	private:
+		void UpdateSmoothingFactor() {
+			const double seconds = static_cast<double>(m_Settings.smoothingTime.ToNanoseconds()) / 1000000000.0;
+			m_SmoothingFactor = seconds > 0.0 && m_PollRate > 0u ? static_cast<float>(1.0 - std::exp(-1.0 / (seconds * m_PollRate))) : 1.0f;
+		}
+
+		// radial deadzone: the direction is kept, only the magnitude is remapped
+		void ProcessSticks(const AnalogSample& sample, float* outX, float* outY) const {
+			const float inner = m_Settings.stickDeadzone;
+			const float inverseRange = 1.0f / std::fmax(1.0f - inner - m_Settings.stickOuterDeadzone, 0.001f);
+			const float curve = m_Settings.responseCurve;
+
+#if INPUT_ANALOG_SSE
+			const __m128 innerLanes = _mm_set1_ps(inner);
+			const __m128 inverseRangeLanes = _mm_set1_ps(inverseRange);
+			const __m128 curveLanes = _mm_set1_ps(curve);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 epsilon = _mm_set1_ps(0.000001f);
+
+			for (uint32_t i = 0u; i < ANALOG_STICK_COUNT; i += 4u) {
+				const __m128 x = _mm_loadu_ps(sample.stickX + i);
+				const __m128 y = _mm_loadu_ps(sample.stickY + i);
+				const __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+
+				const __m128 scaled = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(magnitude, innerLanes), inverseRangeLanes), zero), one);
+				const __m128 cubed = _mm_mul_ps(_mm_mul_ps(scaled, scaled), scaled);
+				const __m128 curved = _mm_add_ps(scaled, _mm_mul_ps(_mm_sub_ps(cubed, scaled), curveLanes));
+				const __m128 factor = _mm_div_ps(curved, _mm_max_ps(magnitude, epsilon));
+
+				_mm_storeu_ps(outX + i, _mm_mul_ps(x, factor));
+				_mm_storeu_ps(outY + i, _mm_mul_ps(y, factor));
+			}
+#else
+			for (uint32_t i = 0u; i < ANALOG_STICK_COUNT; ++i) {
+				const float x = sample.stickX[i];
+				const float y = sample.stickY[i];
+				const float magnitude = std::sqrt(x * x + y * y);
+
+				const float scaled = Clamp01((magnitude - inner) * inverseRange);
+				const float curved = scaled + (scaled * scaled * scaled - scaled) * curve;
+				const float factor = curved / (magnitude > 0.000001f ? magnitude : 0.000001f);
+
+				outX[i] = x * factor;
+				outY[i] = y * factor;
+			}
+#endif
+		}
+
+		void ProcessTriggers(const AnalogSample& sample, float* out) const {
+			const float deadzone = m_Settings.triggerDeadzone;
+			const float inverseRange = 1.0f / std::fmax(1.0f - deadzone, 0.001f);
+			const float curve = m_Settings.responseCurve;
+
+#if INPUT_ANALOG_SSE
+			const __m128 deadzoneLanes = _mm_set1_ps(deadzone);
+			const __m128 inverseRangeLanes = _mm_set1_ps(inverseRange);
+			const __m128 curveLanes = _mm_set1_ps(curve);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			for (uint32_t i = 0u; i < ANALOG_TRIGGER_COUNT; i += 4u) {
+				const __m128 value = _mm_loadu_ps(sample.triggers + i);
+				const __m128 scaled = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(value, deadzoneLanes), inverseRangeLanes), zero), one);
+				const __m128 cubed = _mm_mul_ps(_mm_mul_ps(scaled, scaled), scaled);
+				_mm_storeu_ps(out + i, _mm_add_ps(scaled, _mm_mul_ps(_mm_sub_ps(cubed, scaled), curveLanes)));
+			}
+#else
+			for (uint32_t i = 0u; i < ANALOG_TRIGGER_COUNT; ++i) {
+				const float scaled = Clamp01((sample.triggers[i] - deadzone) * inverseRange);
+				out[i] = scaled + (scaled * scaled * scaled - scaled) * curve;
+			}
+#endif
+		}
+
+		void Smooth(float* values, const float* targets, uint32_t count) const {
+			const float factor = m_SmoothingFactor;
+			for (uint32_t i = 0u; i < count; ++i) {
+				const float value = values[i] + (targets[i] - values[i]) * factor;
+				// settle exactly on zero once the stick / trigger was let go
+				values[i] = targets[i] == 0.0f && std::fabs(value) < 0.001f ? 0.0f : value;
+			}
+		}
+
+		AnalogSettings m_Settings;
+		uint32_t m_PollRate = DEFAULT_POLL_RATE;
+		float m_SmoothingFactor = 1.0f;
+
+		// input thread only, smoothed values of the last poll
+		float m_StickX[ANALOG_STICK_COUNT] = {};
+		float m_StickY[ANALOG_STICK_COUNT] = {};
+		float m_Triggers[ANALOG_TRIGGER_COUNT] = {};
+
+		TripleBuffer<AnalogState> m_States;
+	};
+}
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Input
 {
+	// XInput and ScePad both handle up to four controllers
+	constexpr uint32_t MAX_GAMEPADS = 4u;
+
 	enum class GamepadButtons
 	{
 		FACE_BUTTON_TOP,
@@ -18,6 +23,74 @@ namespace Input
 		SHOULDER_RIGHT,
 	};
 
+	constexpr uint32_t GAMEPAD_BUTTON_COUNT = 10u;
+
+	// sticks are -1..1 (up and right are positive), triggers 0..1
+	enum class GamepadAxis
+	{
+		LEFT_STICK_X,
+		LEFT_STICK_Y,
+		RIGHT_STICK_X,
+		RIGHT_STICK_Y,
+
+		LEFT_TRIGGER,
+		RIGHT_TRIGGER,
+	};
+
+	constexpr uint32_t GAMEPAD_AXIS_COUNT = 6u;
+
+	// bit of `button` in the platform neutral masks (InputFrame, input logs)
+	constexpr int ButtonBit(GamepadButtons button) {
+		return 1 << static_cast<int>(button);
+	}
+
+	// game actions (see ActionMap.h) are indices into 32 bit masks
+	constexpr uint32_t MAX_ACTIONS = 32u;
+
+	constexpr int ActionBit(uint32_t action) {
+		return static_cast<int>(1u << action);
+	}
+
+	/*
+	 * Remaps a native button mask (XInput / ScePad bits) to the neutral GamepadButtons bit order, `platformButtons`
+	 * holds the native bit of every GamepadButtons value
+	 */
+	inline int ToNeutralButtons(int native, const int* platformButtons) {
+		int neutral = 0;
+		for (uint32_t i = 0u; i < GAMEPAD_BUTTON_COUNT; ++i) {
+			if ((native & platformButtons[i]) != 0) {
+				neutral |= 1 << i;
+			}
+		}
+		return neutral;
+	}
+
+	/*
+	 * Per-frame snapshot of one pad, one bit per GamepadButtons value (see ButtonBit) and per action (see ActionBit)
+	 * plus the processed axes. Reading it never consumes anything, every system sees the same edges
+	 */
+	struct InputFrame
+	{
+		int pressed = 0;	// went down since the previous frame
+		int held = 0;		// down in the previous and in this frame
+		int released = 0;	// went up since the previous frame
+		float axes[GAMEPAD_AXIS_COUNT] = {};
+		int actions = 0;			// active at the end of the frame
+		int actionsTriggered = 0;	// became active since the previous frame
+		int actionsEnded = 0;		// stopped being active since the previous frame
+		// presses per button since the previous frame, a double tap within one frame counts 2 (saturates at 255)
+		uint8_t pressCounts[GAMEPAD_BUTTON_COUNT] = {};
+
+		bool IsPressed(GamepadButtons button) const { return (pressed & ButtonBit(button)) != 0; }
+		bool IsHeld(GamepadButtons button) const { return (held & ButtonBit(button)) != 0; }
+		bool IsReleased(GamepadButtons button) const { return (released & ButtonBit(button)) != 0; }
+		uint32_t GetPressCount(GamepadButtons button) const { return pressCounts[static_cast<int>(button)]; }
+		float GetAxis(GamepadAxis axis) const { return axes[static_cast<int>(axis)]; }
+		bool IsActionActive(uint32_t action) const { return (actions & ActionBit(action)) != 0; }
+		bool WasActionTriggered(uint32_t action) const { return (actionsTriggered & ActionBit(action)) != 0; }
+		bool WasActionEnded(uint32_t action) const { return (actionsEnded & ActionBit(action)) != 0; }
+	};
+
 	enum class InputAction
 	{
 		BUTTON_HOLD,
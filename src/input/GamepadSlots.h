@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "../core/ClockTypes.h"
+
+#include "GamepadInputTypes.h"
+
+namespace Input
+{
+	// every empty slot is asked for a new pad this often (XInputGetState on a disconnected port is expensive)
+	constexpr Duration HOTPLUG_PROBE_INTERVAL = Duration::FromMilliseconds(1000);
+	constexpr uint32_t ALL_GAMEPADS_MASK = (1u << MAX_GAMEPADS) - 1u;
+
+	/*
+	 * Connection state of the gamepad slots and the hot-plug throttle.
+	 *
+	 * Connected slots are read every poll. Empty slots are probed round-robin, one slot every
+	 * HOTPLUG_PROBE_INTERVAL / MAX_GAMEPADS, so a single poll never pays for more than one failed read and every
+	 * slot is still checked once per interval. The input thread owns the schedule, the connected mask can be
+	 * read from any thread.
+	 */
+	class GamepadSlots
+	{
+	public:
+		/*
+		 * Input thread - mask of the slots to read this poll, report each result with SetConnected
+		 */
+		uint32_t BeginPoll(TimePoint now) {
+			uint32_t pollMask = GetConnectedMask();
+
+			if (!m_IsStarted) {
+				// the very first poll looks at every slot
+				m_IsStarted = true;
+				m_NextProbe = now + HOTPLUG_PROBE_INTERVAL / MAX_GAMEPADS;
+				return ALL_GAMEPADS_MASK;
+			}
+
+			if (now >= m_NextProbe) {
+				m_NextProbe = now + HOTPLUG_PROBE_INTERVAL / MAX_GAMEPADS;
+
+				const uint32_t bit = 1u << m_ProbeCursor;
+				m_ProbeCursor = (m_ProbeCursor + 1u) % MAX_GAMEPADS;
+				pollMask |= bit;
+			}
+			return pollMask;
+		}
+
+		/*
+		 * Input thread - result of reading `pad`
+		 */
+		void SetConnected(uint32_t pad, bool connected) {
+			const uint32_t bit = 1u << pad;
+			if (connected) {
+				m_ConnectedMask.fetch_or(bit, std::memory_order_release);
+			}
+			else {
+				m_ConnectedMask.fetch_and(~bit, std::memory_order_release);
+			}
+		}
+
+		bool IsConnected(uint32_t pad) const {
+			return pad < MAX_GAMEPADS && (GetConnectedMask() & (1u << pad)) != 0u;
+		}
+
+		uint32_t GetConnectedMask() const {
+			return m_ConnectedMask.load(std::memory_order_acquire);
+		}
+
+	private:
+		std::atomic<uint32_t> m_ConnectedMask { 0u };
+
+		// input thread only
+		TimePoint m_NextProbe;
+		uint32_t m_ProbeCursor = 0u;
+		bool m_IsStarted = false;
+	};
+}
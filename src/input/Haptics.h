@@ -0,0 +1,253 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "../core/ClockTypes.h"
+#include "../core/SpscQueue.h"
+
+#include "GamepadInputTypes.h"
+
+namespace Input
+{
+	// motor speeds use XInput's range on every platform, ScePad's 8 bit motors get the high byte
+	constexpr uint32_t MAX_MOTOR_SPEED = 65535u;
+	// commands one frame can hand to the input thread, at most two per pad are needed
+	constexpr uint32_t HAPTICS_COMMAND_CAPACITY = 64u;
+
+	struct MotorSpeeds
+	{
+		uint16_t large = 0u;
+		uint16_t small = 0u;
+
+		bool operator==(const MotorSpeeds& other) const { return large == other.large && small == other.small; }
+		bool operator!=(const MotorSpeeds& other) const { return !(*this == other); }
+	};
+
+	/*
+	 * Timed vibration: ramps up to `peak` over `attack`, holds it for `sustain` and fades out over `release`.
+	 * Plays on top of the pad's constant level, the stronger of both wins per motor
+	 */
+	struct VibrationEnvelope
+	{
+		MotorSpeeds peak;
+		Duration attack;
+		Duration sustain;
+		Duration release;
+	};
+
+	constexpr VibrationEnvelope VibrationPulse(uint16_t large, uint16_t small, Duration duration) {
+		VibrationEnvelope envelope;
+		envelope.peak.large = large;
+		envelope.peak.small = small;
+		envelope.sustain = duration;
+		return envelope;
+	}
+
+	struct HapticsStats
+	{
+		uint64_t requested = 0u;	// SetVibration / PlayEnvelope calls
+		uint64_t submitted = 0u;	// commands that reached the input thread after deduplication
+		uint64_t issued = 0u;		// driver calls (XInputSetState / scePadSetVibration)
+		uint64_t dropped = 0u;		// commands that didn't fit into the queue, levels are retried next frame
+	};
+
+	/*
+	 * Vibration command buffer.
+	 *
+	 * The game thread records requests into a per-frame buffer (the last request per pad wins) and Submit hands
+	 * what actually changed to the input thread through a wait-free queue: a level that equals the one already
+	 * submitted is dropped, so calling SetVibration(pad, 0, 0) every frame costs nothing. The input thread
+	 * evaluates the envelopes on every poll and calls the driver at most once per pad and poll, and only when the
+	 * resulting motor speeds differ from what the device already runs at.
+	 */
+	class Haptics
+	{
+	public:
+		/*
+		 * Game thread - constant vibration of `pad` until the next change
+		 */
+		void SetVibration(uint32_t pad, uint32_t large, uint32_t small) {
+			++m_Requested;
+			if (pad >= MAX_GAMEPADS) {
+				return;
+			}
+
+			FrameRequest& request = m_Frame[pad];
+			request.level.large = static_cast<uint16_t>(large < MAX_MOTOR_SPEED ? large : MAX_MOTOR_SPEED);
+			request.level.small = static_cast<uint16_t>(small < MAX_MOTOR_SPEED ? small : MAX_MOTOR_SPEED);
+			request.hasLevel = true;
+		}
+
+		/*
+		 * Game thread - starts `envelope` on `pad`, replacing the one that is playing
+		 */
+		void PlayEnvelope(uint32_t pad, const VibrationEnvelope& envelope) {
+			++m_Requested;
+			if (pad >= MAX_GAMEPADS) {
+				return;
+			}
+
+			m_Frame[pad].envelope = envelope;
+			m_Frame[pad].hasEnvelope = true;
+		}
+
+		/*
+		 * Game thread - hands this frame's requests to the input thread, call once per frame
+		 */
+		void Submit() {
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				FrameRequest& request = m_Frame[pad];
+
+				if (request.hasLevel && request.level != m_SubmittedLevels[pad]) {
+					Command command;
+					command.type = CommandType::SET_LEVEL;
+					command.pad = static_cast<uint8_t>(pad);
+					command.level = request.level;
+					if (Push(command)) {
+						m_SubmittedLevels[pad] = request.level;
+					}
+				}
+
+				if (request.hasEnvelope) {
+					Command command;
+					command.type = CommandType::PLAY_ENVELOPE;
+					command.pad = static_cast<uint8_t>(pad);
+					command.envelope = request.envelope;
+					Push(command);
+				}
+
+				request = FrameRequest();
+			}
+		}
+
+		/*
+		 * Input thread - applies the submitted commands and evaluates the envelopes at `now`. `issue(pad, speeds)`
+		 * is called for every pad whose motor speeds changed, it returns false if the pad couldn't be written
+		 * (e.g. not connected), the change is retried with the next flush then
+		 */
+		template <typename IssueFunction>
+		void Flush(TimePoint now, IssueFunction&& issue) {
+			Command command;
+			while (m_Commands.TryPop(command)) {
+				PadState& state = m_Pads[command.pad];
+				if (command.type == CommandType::SET_LEVEL) {
+					state.level = command.level;
+				}
+				else {
+					state.envelope = command.envelope;
+					state.envelopeStart = now;
+					state.hasEnvelope = true;
+				}
+			}
+
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				PadState& state = m_Pads[pad];
+				MotorSpeeds speeds = state.level;
+				if (state.hasEnvelope) {
+					const float scale = EvaluateEnvelope(state.envelope, now - state.envelopeStart);
+					if (scale < 0.0f) {
+						state.hasEnvelope = false;
+					}
+					else {
+						speeds.large = Max(speeds.large, Scale(state.envelope.peak.large, scale));
+						speeds.small = Max(speeds.small, Scale(state.envelope.peak.small, scale));
+					}
+				}
+
+				if (speeds != state.issued && issue(pad, speeds)) {
+					state.issued = speeds;
+					m_Issued.fetch_add(1u, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// game thread
+		HapticsStats GetStats() const {
+			HapticsStats stats;
+			stats.requested = m_Requested;
+			stats.submitted = m_Submitted;
+			stats.dropped = m_Dropped;
+			stats.issued = m_Issued.load(std::memory_order_relaxed);
+			return stats;
+		}
+
+	private:
+		enum class CommandType : uint8_t
+		{
+			SET_LEVEL,
+			PLAY_ENVELOPE,
+		};
+
+		struct Command
+		{
+			CommandType type = CommandType::SET_LEVEL;
+			uint8_t pad = 0u;
+			MotorSpeeds level;
+			VibrationEnvelope envelope;
+		};
+
+		struct FrameRequest
+		{
+			MotorSpeeds level;
+			VibrationEnvelope envelope;
+			bool hasLevel = false;
+			bool hasEnvelope = false;
+		};
+
+		struct PadState
+		{
+			MotorSpeeds level;
+			MotorSpeeds issued;
+			VibrationEnvelope envelope;
+			TimePoint envelopeStart;
+			bool hasEnvelope = false;
+		};
+
+		// 0..1 at `elapsed`, negative once the envelope finished
+		static float EvaluateEnvelope(const VibrationEnvelope& envelope, Duration elapsed) {
+			if (elapsed < envelope.attack) {
+				return static_cast<float>(elapsed.ToNanoseconds()) / static_cast<float>(envelope.attack.ToNanoseconds());
+			}
+			elapsed = elapsed - envelope.attack;
+			if (elapsed < envelope.sustain) {
+				return 1.0f;
+			}
+			elapsed = elapsed - envelope.sustain;
+			if (elapsed < envelope.release) {
+				return 1.0f - static_cast<float>(elapsed.ToNanoseconds()) / static_cast<float>(envelope.release.ToNanoseconds());
+			}
+			return -1.0f;
+		}
+
+		static uint16_t Scale(uint16_t speed, float scale) {
+			return static_cast<uint16_t>(static_cast<float>(speed) * scale + 0.5f);
+		}
+
+		static uint16_t Max(uint16_t a, uint16_t b) {
+			return a > b ? a : b;
+		}
+
+		bool Push(const Command& command) {
+			if (!m_Commands.TryPush(command)) {
+				++m_Dropped;
+				return false;
+			}
+			++m_Submitted;
+			return true;
+		}
+
+		// game thread only
+		FrameRequest m_Frame[MAX_GAMEPADS];
+		MotorSpeeds m_SubmittedLevels[MAX_GAMEPADS];
+		uint64_t m_Requested = 0u;
+		uint64_t m_Submitted = 0u;
+		uint64_t m_Dropped = 0u;
+
+		SpscQueue<Command, HAPTICS_COMMAND_CAPACITY> m_Commands;
+
+		// input thread only
+		PadState m_Pads[MAX_GAMEPADS];
+		std::atomic<uint64_t> m_Issued { 0u };
+	};
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "../core/Clock.h"
+#include "../core/SpscQueue.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+#endif
+
+#include "ActionMap.h"
+#include "GamepadInputTypes.h"
+#include "InputLatency.h"
+
+namespace Input
+{
+	// polls per second of the input thread, the rate trades input latency against CPU time
+	constexpr uint32_t DEFAULT_POLL_RATE = 250u;
+	constexpr uint32_t MIN_POLL_RATE = 30u;
+	constexpr uint32_t MAX_POLL_RATE = 1000u;
+	inline uint32_t ClampPollRate(uint32_t pollRate) {
+		return pollRate < MIN_POLL_RATE ? MIN_POLL_RATE : (pollRate > MAX_POLL_RATE ? MAX_POLL_RATE : pollRate);
+	}
+
+	inline uint32_t LowestBitIndex(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+	}
+
+	// @note - One entry per poll that changed something on any pad. Masks are in the neutral GamepadButtons bit
+	// order (remapped once per poll), stored as structure-of-arrays (one int per pad) so all pads are handled
+	// with a few vector ops.
+	struct ButtonEdgeEvent
+	{
+		TimePoint timestamp;
+		int states[MAX_GAMEPADS] = {};
+		int downs[MAX_GAMEPADS] = {};
+		int ups[MAX_GAMEPADS] = {};
+		int actions[MAX_GAMEPADS] = {};
+		int actionStarts[MAX_GAMEPADS] = {};
+		int actionEnds[MAX_GAMEPADS] = {};
+		// presses per button, more than one when polls were merged into this event
+		uint8_t pressCounts[MAX_GAMEPADS][GAMEPAD_BUTTON_COUNT] = {};
+	};
+
+	/*
+	 * Hands button edges from the input thread (producer, Publish) to the game thread (consumer, BeginFrame).
+	 *
+	 * The input thread pushes one timestamped event per poll that changed any button into a wait-free SPSC
+	 * ring. The game thread drains the ring once per frame into a snapshot, so every query within a frame sees
+	 * the same consistent state and neither thread ever touches the other one's data.
+	 *
+	 * All pads share the ring. Their masks live in contiguous arrays (current, previous, downs, ups), the loops
+	 * over MAX_GAMEPADS have a fixed trip count and compile to SIMD.
+	 *
+	 * The producer also evaluates the action map on every poll. Actions travel as one more set of masks, they get
+	 * the same edge handling as the buttons.
+	 *
+	 * When the ring is full, the edges of the following polls merge into one event. The masks can only say that a
+	 * button went down, so every event also counts the presses per button: a double tap during a stall still
+	 * arrives as two presses (InputFrame::pressCounts). Releases and actions are not counted.
+	 *
+	 * The snapshot keeps the poll timestamp of every button's last press and release. BeginFrame records how long
+	 * every press, release and action start of the frame took from its poll to the frame into a latency
+	 * histogram, no matter whether the game reads it through the snapshot, an action or a query.
+	 */
+	class ButtonEventQueue
+	{
+	public:
+		static constexpr uint32_t CAPACITY = 256u;
+
+		/*
+		 * Producer side - called by the input thread after every poll with the neutral button mask of every
+		 * pad (0 for empty slots)
+		 */
+		void Publish(const int (&states)[MAX_GAMEPADS], TimePoint timestamp) {
+			int actions[MAX_GAMEPADS];
+			m_ActionMap.Evaluate(states, timestamp, actions);
+
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				CountPresses(m_PendingPressCounts[pad], states[pad] & ~m_PolledStates[pad]);
+			}
+
+			// edges that didn't fit into the ring last time are merged into this event, never dropped
+			int pending = AccumulateEdges(states, m_PolledStates, m_PendingDowns, m_PendingUps);
+			pending |= AccumulateEdges(actions, m_PolledActions, m_PendingActionStarts, m_PendingActionEnds);
+			if (pending == 0) {
+				return;
+			}
+
+			ButtonEdgeEvent event;
+			event.timestamp = timestamp;
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				event.states[pad] = states[pad];
+				event.downs[pad] = m_PendingDowns[pad];
+				event.ups[pad] = m_PendingUps[pad];
+				event.actions[pad] = actions[pad];
+				event.actionStarts[pad] = m_PendingActionStarts[pad];
+				event.actionEnds[pad] = m_PendingActionEnds[pad];
+				for (uint32_t button = 0u; button < GAMEPAD_BUTTON_COUNT; ++button) {
+					event.pressCounts[pad][button] = m_PendingPressCounts[pad][button];
+				}
+			}
+
+			if (m_Events.TryPush(event)) {
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					m_PendingDowns[pad] = 0;
+					m_PendingUps[pad] = 0;
+					m_PendingActionStarts[pad] = 0;
+					m_PendingActionEnds[pad] = 0;
+					for (uint32_t button = 0u; button < GAMEPAD_BUTTON_COUNT; ++button) {
+						m_PendingPressCounts[pad][button] = 0u;
+					}
+				}
+			}
+			else {
+				m_OverflowCount.fetch_add(1u, std::memory_order_relaxed);
+			}
+		}
+
+		/*
+		 * Consumer side - called by the game thread once per frame, before any query
+		 */
+		void BeginFrame() {
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				m_PreviousStates[pad] = m_States[pad];
+				m_FrameDowns[pad] = 0;
+				m_FrameUps[pad] = 0;
+				m_FrameActionStarts[pad] = 0;
+				m_FrameActionEnds[pad] = 0;
+				for (uint32_t button = 0u; button < GAMEPAD_BUTTON_COUNT; ++button) {
+					m_FramePressCounts[pad][button] = 0u;
+				}
+			}
+
+			const TimePoint now = Clock::Now();
+			ButtonEdgeEvent event;
+			while (m_Events.TryPop(event)) {
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					// the first edge of a frame is the one the game reacts to, that's the one latency is measured from
+					const int firstDowns = event.downs[pad] & ~m_FrameDowns[pad];
+					const int firstUps = event.ups[pad] & ~m_FrameUps[pad];
+					const int firstActionStarts = event.actionStarts[pad] & ~m_FrameActionStarts[pad];
+					StoreEdgeTimes(m_DownTimes[pad], firstDowns, event.timestamp);
+					StoreEdgeTimes(m_UpTimes[pad], firstUps, event.timestamp);
+					RecordLatency(firstDowns, now - event.timestamp);
+					RecordLatency(firstUps, now - event.timestamp);
+					RecordLatency(firstActionStarts, now - event.timestamp);
+					AddPressCounts(m_FramePressCounts[pad], event.pressCounts[pad], event.downs[pad]);
+				}
+
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					m_FrameDowns[pad] |= event.downs[pad];
+					m_FrameUps[pad] |= event.ups[pad];
+					m_States[pad] = event.states[pad];
+					m_FrameActionStarts[pad] |= event.actionStarts[pad];
+					m_FrameActionEnds[pad] |= event.actionEnds[pad];
+					m_Actions[pad] = event.actions[pad];
+				}
+			}
+
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				m_ButtonDowns[pad] = m_FrameDowns[pad];
+				m_ButtonUps[pad] = m_FrameUps[pad];
+			}
+		}
+
+		/*
+		 * Pressed / held / released of this frame, independent of what was consumed by queries
+		 */
+		InputFrame GetFrame(uint32_t pad) const {
+			InputFrame frame;
+			frame.pressed = m_FrameDowns[pad];
+			frame.held = m_States[pad] & m_PreviousStates[pad];
+			frame.released = m_FrameUps[pad];
+			frame.actions = m_Actions[pad];
+			frame.actionsTriggered = m_FrameActionStarts[pad];
+			frame.actionsEnded = m_FrameActionEnds[pad];
+			for (uint32_t button = 0u; button < GAMEPAD_BUTTON_COUNT; ++button) {
+				frame.pressCounts[button] = m_FramePressCounts[pad][button];
+			}
+			return frame;
+		}
+
+		int GetActions(uint32_t pad) const { return m_Actions[pad]; }
+		int GetActionsTriggered(uint32_t pad) const { return m_FrameActionStarts[pad]; }
+
+		// bindings are set on the game thread, the producer picks them up with its next poll
+		ActionMap& GetActionMap() { return m_ActionMap; }
+
+		int GetButtonDowns(uint32_t pad) const { return m_ButtonDowns[pad]; }
+		int GetButtonUps(uint32_t pad) const { return m_ButtonUps[pad]; }
+		int GetStates(uint32_t pad) const { return m_States[pad]; }
+		int GetPreviousStates(uint32_t pad) const { return m_PreviousStates[pad]; }
+
+		// poll time of the button's last press / release (`button` is a single ButtonBit)
+		TimePoint GetDownTime(uint32_t pad, int button) const { return m_DownTimes[pad][LowestBitIndex(static_cast<uint32_t>(button))]; }
+		TimePoint GetUpTime(uint32_t pad, int button) const { return m_UpTimes[pad][LowestBitIndex(static_cast<uint32_t>(button))]; }
+
+		// frame snapshot is owned by the consumer, so consuming an edge is a plain write
+		void ConsumeDowns(uint32_t pad, int buttons) {
+			m_ButtonDowns[pad] &= ~buttons;
+		}
+
+		void ConsumeUps(uint32_t pad, int buttons) {
+			m_ButtonUps[pad] &= ~buttons;
+		}
+
+		InputLatencyStats GetLatencyStats() const { return m_Latency.GetStats(); }
+		void ResetLatencyStats() { m_Latency.Reset(); }
+
+		// number of polls that found the ring full (their edges were merged into a later event)
+		uint32_t GetOverflowCount() const { return m_OverflowCount.load(std::memory_order_relaxed); }
+
+	private:
+		static int AccumulateEdges(const int (&states)[MAX_GAMEPADS], int (&polled)[MAX_GAMEPADS], int (&downs)[MAX_GAMEPADS], int (&ups)[MAX_GAMEPADS]) {
+			int pending = 0;
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				const int changes = polled[pad] ^ states[pad];
+				polled[pad] = states[pad];
+
+				downs[pad] |= changes & states[pad];
+				ups[pad] |= changes & ~states[pad];
+				pending |= downs[pad] | ups[pad];
+			}
+			return pending;
+		}
+
+		static void CountPresses(uint8_t (&counts)[GAMEPAD_BUTTON_COUNT], int downs) {
+			uint32_t mask = static_cast<uint32_t>(downs);
+			while (mask != 0u) {
+				uint8_t& count = counts[LowestBitIndex(mask)];
+				count = count < UINT8_MAX ? static_cast<uint8_t>(count + 1u) : count;
+				mask &= mask - 1u;
+			}
+		}
+
+		// only the buttons in `downs` can have presses, the others are skipped
+		static void AddPressCounts(uint8_t (&counts)[GAMEPAD_BUTTON_COUNT], const uint8_t (&presses)[GAMEPAD_BUTTON_COUNT], int downs) {
+			uint32_t mask = static_cast<uint32_t>(downs);
+			while (mask != 0u) {
+				const uint32_t button = LowestBitIndex(mask);
+				const uint32_t count = counts[button] + static_cast<uint32_t>(presses[button]);
+				counts[button] = static_cast<uint8_t>(count < UINT8_MAX ? count : UINT8_MAX);
+				mask &= mask - 1u;
+			}
+		}
+
+		static void StoreEdgeTimes(TimePoint* times, int buttons, TimePoint timestamp) {
+			uint32_t mask = static_cast<uint32_t>(buttons);
+			while (mask != 0u) {
+				times[LowestBitIndex(mask)] = timestamp;
+				mask &= mask - 1u;
+			}
+		}
+
+		// one sample per edge, all edges of an event share its poll
+		void RecordLatency(int edges, Duration latency) {
+			for (uint32_t mask = static_cast<uint32_t>(edges); mask != 0u; mask &= mask - 1u) {
+				m_Latency.Record(latency);
+			}
+		}
+
+		SpscQueue<ButtonEdgeEvent, CAPACITY> m_Events;
+
+		// input thread only
+		int m_PolledStates[MAX_GAMEPADS] = {};
+		int m_PendingDowns[MAX_GAMEPADS] = {};
+		int m_PendingUps[MAX_GAMEPADS] = {};
+		int m_PolledActions[MAX_GAMEPADS] = {};
+		int m_PendingActionStarts[MAX_GAMEPADS] = {};
+		int m_PendingActionEnds[MAX_GAMEPADS] = {};
+		uint8_t m_PendingPressCounts[MAX_GAMEPADS][GAMEPAD_BUTTON_COUNT] = {};
+		ActionMap m_ActionMap;
+		std::atomic<uint32_t> m_OverflowCount { 0u };
+
+		// game thread only
+		int m_States[MAX_GAMEPADS] = {};
+		int m_PreviousStates[MAX_GAMEPADS] = {};
+		// all edges of the frame (snapshots) and what is left of them after consuming queries
+		int m_FrameDowns[MAX_GAMEPADS] = {};
+		int m_FrameUps[MAX_GAMEPADS] = {};
+		int m_ButtonDowns[MAX_GAMEPADS] = {};
+		int m_ButtonUps[MAX_GAMEPADS] = {};
+		int m_Actions[MAX_GAMEPADS] = {};
+		int m_FrameActionStarts[MAX_GAMEPADS] = {};
+		int m_FrameActionEnds[MAX_GAMEPADS] = {};
+		uint8_t m_FramePressCounts[MAX_GAMEPADS][GAMEPAD_BUTTON_COUNT] = {};
+		TimePoint m_DownTimes[MAX_GAMEPADS][GAMEPAD_BUTTON_COUNT];
+		TimePoint m_UpTimes[MAX_GAMEPADS][GAMEPAD_BUTTON_COUNT];
+		LatencyHistogram m_Latency;
+	};
+}
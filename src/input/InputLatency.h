@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../core/ClockTypes.h"
+
+namespace Input
+{
+	struct InputLatencyStats
+	{
+		uint32_t samples = 0u;
+		// time from the poll that saw an edge to the frame that delivered it (BeginFrame)
+		float meanMs = 0.0f;
+		float p50Ms = 0.0f;
+		float p90Ms = 0.0f;
+		float p99Ms = 0.0f;
+		float maxMs = 0.0f;
+	};
+
+	/*
+	 * Log-linear latency histogram in microseconds: exact below 16us, then 8 buckets per power of two (at most
+	 * 12.5% relative error) up to ~16 seconds. Recording is a handful of integer ops and no allocation, so it
+	 * can stay on in shipping builds.
+	 */
+	class LatencyHistogram
+	{
+	public:
+		static constexpr uint32_t LINEAR_BUCKETS = 16u;
+		static constexpr uint32_t SUB_BUCKETS = 8u;
+		static constexpr uint32_t MAX_EXPONENT = 24u;
+		static constexpr uint32_t BUCKET_COUNT = LINEAR_BUCKETS + (MAX_EXPONENT - 4u) * SUB_BUCKETS;
+
+		void Record(Duration latency) {
+			const int64_t nanoseconds = latency.ToNanoseconds() > 0 ? latency.ToNanoseconds() : 0;
+
+			++m_Buckets[BucketIndex(static_cast<uint64_t>(nanoseconds) / 1000u)];
+			++m_Samples;
+			m_TotalNanoseconds += nanoseconds;
+			if (nanoseconds > m_MaxNanoseconds) {
+				m_MaxNanoseconds = nanoseconds;
+			}
+		}
+
+		void Reset() {
+			for (uint32_t i = 0u; i < BUCKET_COUNT; ++i) {
+				m_Buckets[i] = 0u;
+			}
+			m_Samples = 0u;
+			m_TotalNanoseconds = 0;
+			m_MaxNanoseconds = 0;
+		}
+
+		InputLatencyStats GetStats() const {
+			InputLatencyStats stats;
+			stats.samples = m_Samples;
+			if (m_Samples == 0u) {
+				return stats;
+			}
+
+			stats.meanMs = static_cast<float>(static_cast<double>(m_TotalNanoseconds) / m_Samples / 1000000.0);
+			stats.p50Ms = Percentile(0.50f);
+			stats.p90Ms = Percentile(0.90f);
+			stats.p99Ms = Percentile(0.99f);
+			stats.maxMs = static_cast<float>(static_cast<double>(m_MaxNanoseconds) / 1000000.0);
+			return stats;
+		}
+
+	private:
+		static uint32_t BucketIndex(uint64_t microseconds) {
+			if (microseconds < LINEAR_BUCKETS) {
+				return static_cast<uint32_t>(microseconds);
+			}
+
+			uint32_t exponent = 4u;
+			while (exponent + 1u < MAX_EXPONENT && (microseconds >> (exponent + 1u)) != 0u) {
+				++exponent;
+			}
+			if ((microseconds >> (exponent + 1u)) != 0u) {
+				return BUCKET_COUNT - 1u;
+			}
+
+			const uint32_t subBucket = static_cast<uint32_t>(microseconds >> (exponent - 3u)) & (SUB_BUCKETS - 1u);
+			return LINEAR_BUCKETS + (exponent - 4u) * SUB_BUCKETS + subBucket;
+		}
+
+		// middle of the bucket in milliseconds
+		static float BucketValueMs(uint32_t index) {
+			if (index < LINEAR_BUCKETS) {
+				return static_cast<float>(index) / 1000.0f;
+			}
+
+			const uint32_t exponent = 4u + (index - LINEAR_BUCKETS) / SUB_BUCKETS;
+			const uint32_t subBucket = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+			const double width = static_cast<double>(1u << (exponent - 3u));
+			const double lower = static_cast<double>(1u << exponent) + subBucket * width;
+			return static_cast<float>((lower + width * 0.5) / 1000.0);
+		}
+
+		float Percentile(float percentile) const {
+			const uint64_t rank = static_cast<uint64_t>(percentile * (m_Samples - 1u));
+			uint64_t seen = 0u;
+			for (uint32_t i = 0u; i < BUCKET_COUNT; ++i) {
+				seen += m_Buckets[i];
+				if (seen > rank) {
+					const float value = BucketValueMs(i);
+					const float maxMs = static_cast<float>(static_cast<double>(m_MaxNanoseconds) / 1000000.0);
+					return value < maxMs ? value : maxMs;
+				}
+			}
+			return 0.0f;
+		}
+
+		uint32_t m_Buckets[BUCKET_COUNT] = {};
+		uint32_t m_Samples = 0u;
+		int64_t m_TotalNanoseconds = 0;
+		int64_t m_MaxNanoseconds = 0;
+	};
+}
@@ -0,0 +1,447 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdio.h>
+#include <vector>
+
+#include "../core/Clock.h"
+
+#include "AnalogInput.h"
+#include "GamepadInputTypes.h"
+#include "InputEventQueue.h"
+
+/*
+ * Input recording and replay for reproducible runs.
+ *
+ * The recorder logs every poll of the input thread for all pads: the button masks and the raw analog sample
+ * (sticks and triggers before deadzones and smoothing, quantized to 16 bits). Button masks are in the neutral
+ * bit order (bit i is GamepadButtons i), so a log recorded on one platform replays on every other. The binary
+ * log only stores the polls that changed something, with the tick (poll index) as a varint delta and a mask
+ * of what changed, followed by the new button masks and then the new axes of the changed pads in pad order:
+ *
+ *   [InputLogHeader][varint tick delta, uint8_t changes, uint16_t buttons..., int16_t axes[6]...]...
+ *   [varint tick delta, INPUT_LOG_END]
+ *
+ * Bit p of `changes` is set if the buttons of pad p changed, bit 4 + p if its axes did (left stick x / y,
+ * right stick x / y, left / right trigger). The replay is therefore exact for every pad and axis, only the
+ * analog values carry the quantization error of the recording.
+ *
+ * The replayer feeds the log back in place of the device. At ORIGINAL speed the input thread publishes one
+ * logged tick per poll. At MAXIMUM speed the game thread publishes the ticks that belong to each frame from
+ * BeginFrame, so every frame sees exactly the same input no matter how fast the loop runs.
+ */
+namespace Input
+{
+	constexpr uint32_t INPUT_LOG_MAGIC = 0x4C494D4Du; // "MMIL"
+	constexpr uint16_t INPUT_LOG_VERSION = 2u;
+	// changes value of the record that marks the end of the log (its tick is the number of logged polls)
+	constexpr uint8_t INPUT_LOG_END = 0u;
+	// quantized axes per pad and record
+	constexpr uint32_t INPUT_LOG_AXES = 6u;
+	static_assert(MAX_GAMEPADS <= 4u, "the changes mask of a record holds 4 pads");
+
+	// values of one pad as stored in the log
+	struct InputLogPad
+	{
+		uint16_t buttons = 0u;
+		int16_t axes[INPUT_LOG_AXES] = {};
+	};
+
+	// -1..1 (sticks) and 0..1 (triggers) to 16 bits and back
+	inline int16_t QuantizeAxis(float value) {
+		const float clamped = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+	}
+
+	inline float DequantizeAxis(int16_t value) {
+		return static_cast<float>(value) / 32767.0f;
+	}
+
+	inline InputLogPad ToLogPad(int buttons, const AnalogSample& analog, uint32_t pad) {
+		InputLogPad logPad;
+		logPad.buttons = static_cast<uint16_t>(buttons);
+		logPad.axes[0] = QuantizeAxis(analog.stickX[pad * 2u]);
+		logPad.axes[1] = QuantizeAxis(analog.stickY[pad * 2u]);
+		logPad.axes[2] = QuantizeAxis(analog.stickX[pad * 2u + 1u]);
+		logPad.axes[3] = QuantizeAxis(analog.stickY[pad * 2u + 1u]);
+		logPad.axes[4] = QuantizeAxis(analog.triggers[pad * 2u]);
+		logPad.axes[5] = QuantizeAxis(analog.triggers[pad * 2u + 1u]);
+		return logPad;
+	}
+
+	inline void FromLogPad(const InputLogPad& logPad, uint32_t pad, int& buttons, AnalogSample& analog) {
+		buttons = logPad.buttons;
+		analog.stickX[pad * 2u] = DequantizeAxis(logPad.axes[0]);
+		analog.stickY[pad * 2u] = DequantizeAxis(logPad.axes[1]);
+		analog.stickX[pad * 2u + 1u] = DequantizeAxis(logPad.axes[2]);
+		analog.stickY[pad * 2u + 1u] = DequantizeAxis(logPad.axes[3]);
+		analog.triggers[pad * 2u] = DequantizeAxis(logPad.axes[4]);
+		analog.triggers[pad * 2u + 1u] = DequantizeAxis(logPad.axes[5]);
+	}
+
+	struct InputLogHeader
+	{
+		uint32_t magic = INPUT_LOG_MAGIC;
+		uint16_t version = INPUT_LOG_VERSION;
+		uint16_t buttonCount = GAMEPAD_BUTTON_COUNT;
+		// polls per second while recording
+		uint32_t pollRate = 0u;
+		uint32_t reserved = 0u;
+	};
+
+	enum class ReplaySpeed
+	{
+		ORIGINAL,	// one logged poll per poll of the input thread
+		MAXIMUM,	// driven by the game loop, as fast as it runs
+	};
+
+	/*
+	 * Start before the input thread runs, Stop after it finished
+	 */
+	class InputRecorder
+	{
+	public:
+		~InputRecorder() {
+			Stop();
+		}
+
+		bool Start(const char* path, uint32_t pollRate) {
+			Stop();
+
+			m_File = fopen(path, "wb");
+			if (m_File == nullptr) {
+				return false;
+			}
+
+			InputLogHeader header;
+			header.pollRate = pollRate;
+			fwrite(&header, sizeof(header), 1u, m_File);
+
+			m_Tick = 0u;
+			m_LastRecordTick = 0u;
+			// the replay starts from released buttons and centered axes, the first poll is compared against that
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				m_LastPads[pad] = InputLogPad();
+			}
+			return true;
+		}
+
+		void Stop() {
+			if (m_File == nullptr) {
+				return;
+			}
+
+			WriteEnd(m_Tick);
+			fclose(m_File);
+			m_File = nullptr;
+		}
+
+		bool IsRecording() const {
+			return m_File != nullptr;
+		}
+
+		/*
+		 * Input thread - once per poll with the neutral button masks and the raw analog sample of all pads
+		 */
+		void Record(const int (&states)[MAX_GAMEPADS], const AnalogSample& analog) {
+			if (m_File == nullptr) {
+				return;
+			}
+
+			InputLogPad pads[MAX_GAMEPADS];
+			uint8_t changes = 0u;
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				pads[pad] = ToLogPad(states[pad], analog, pad);
+				if (pads[pad].buttons != m_LastPads[pad].buttons) {
+					changes |= static_cast<uint8_t>(1u << pad);
+				}
+				if (memcmp(pads[pad].axes, m_LastPads[pad].axes, sizeof(pads[pad].axes)) != 0) {
+					changes |= static_cast<uint8_t>(0x10u << pad);
+				}
+			}
+
+			if (changes != 0u) {
+				WriteRecord(m_Tick, changes, pads);
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					m_LastPads[pad] = pads[pad];
+				}
+			}
+			++m_Tick;
+		}
+
+	private:
+		static constexpr size_t MAX_RECORD_LENGTH = 10u + 1u + MAX_GAMEPADS * (2u + INPUT_LOG_AXES * 2u);
+
+		void WriteRecord(uint64_t tick, uint8_t changes, const InputLogPad (&pads)[MAX_GAMEPADS]) {
+			uint8_t record[MAX_RECORD_LENGTH];
+			size_t length = WriteHead(record, tick, changes);
+
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				if ((changes & (1u << pad)) != 0u) {
+					length = WriteValue(record, length, pads[pad].buttons);
+				}
+			}
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				if ((changes & (0x10u << pad)) != 0u) {
+					for (uint32_t axis = 0u; axis < INPUT_LOG_AXES; ++axis) {
+						length = WriteValue(record, length, static_cast<uint16_t>(pads[pad].axes[axis]));
+					}
+				}
+			}
+
+			// stdio buffers this, the input thread doesn't wait for the disk
+			fwrite(record, 1u, length, m_File);
+			m_LastRecordTick = tick;
+		}
+
+		void WriteEnd(uint64_t tick) {
+			uint8_t record[MAX_RECORD_LENGTH];
+			fwrite(record, 1u, WriteHead(record, tick, INPUT_LOG_END), m_File);
+			m_LastRecordTick = tick;
+		}
+
+		size_t WriteHead(uint8_t* record, uint64_t tick, uint8_t changes) const {
+			size_t length = 0u;
+			uint64_t delta = tick - m_LastRecordTick;
+			do {
+				record[length++] = static_cast<uint8_t>((delta & 0x7Fu) | (delta >= 0x80u ? 0x80u : 0u));
+				delta >>= 7;
+			} while (delta != 0u);
+
+			record[length++] = changes;
+			return length;
+		}
+
+		static size_t WriteValue(uint8_t* record, size_t length, uint16_t value) {
+			record[length++] = static_cast<uint8_t>(value & 0xFFu);
+			record[length++] = static_cast<uint8_t>(value >> 8);
+			return length;
+		}
+
+		FILE* m_File = nullptr;
+		uint64_t m_Tick = 0u;
+		uint64_t m_LastRecordTick = 0u;
+		InputLogPad m_LastPads[MAX_GAMEPADS];
+	};
+
+	/*
+	 * Start before the input thread runs. While a replay is active the device isn't polled at all.
+	 */
+	class InputReplayer
+	{
+	public:
+		/*
+		 * Loads the whole log, `framesPerSecond` is the game loop's rate (used at MAXIMUM speed)
+		 */
+		bool Start(const char* path, ReplaySpeed speed, uint32_t framesPerSecond) {
+			m_IsActive = false;
+			if (!Load(path) || framesPerSecond == 0u) {
+				return false;
+			}
+
+			m_Speed = speed;
+			m_FramesPerSecond = framesPerSecond;
+			m_NextChange = 0u;
+			m_Tick = 0u;
+			m_Frame = 0u;
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				m_Pads[pad] = InputLogPad();
+			}
+			m_StartTime = Clock::Now();
+			m_IsFinished.store(m_TickCount == 0u, std::memory_order_release);
+			m_IsActive = true;
+			return true;
+		}
+
+		bool IsActive() const {
+			return m_IsActive;
+		}
+
+		bool IsFinished() const {
+			return m_IsActive && m_IsFinished.load(std::memory_order_acquire);
+		}
+
+		ReplaySpeed GetSpeed() const {
+			return m_Speed;
+		}
+
+		// polls per second the log was recorded with
+		uint32_t GetPollRate() const {
+			return m_PollRate;
+		}
+
+		/*
+		 * Input thread - returns true if the replay takes the place of polling the device
+		 */
+		bool ReplayPoll(ButtonEventQueue& events, AnalogInput& analog) {
+			if (!m_IsActive) {
+				return false;
+			}
+			if (m_Speed == ReplaySpeed::ORIGINAL) {
+				PublishTick(events, analog, Clock::Now());
+			}
+			return true;
+		}
+
+		/*
+		 * Game thread, before ButtonEventQueue::BeginFrame - at MAXIMUM speed publishes the ticks of this frame
+		 * with their original timestamps
+		 */
+		void ReplayFrame(ButtonEventQueue& events, AnalogInput& analog) {
+			if (!m_IsActive || m_Speed != ReplaySpeed::MAXIMUM) {
+				return;
+			}
+
+			++m_Frame;
+			const uint64_t lastTick = m_Frame * m_PollRate / m_FramesPerSecond;
+			while (m_Tick < lastTick && !m_IsFinished.load(std::memory_order_relaxed)) {
+				PublishTick(events, analog, m_StartTime + TickOffset(m_Tick, m_PollRate));
+			}
+		}
+
+	private:
+		struct Change
+		{
+			uint64_t tick;
+			uint8_t changes;
+			InputLogPad pads[MAX_GAMEPADS];
+		};
+
+		bool Load(const char* path) {
+			FILE* file = fopen(path, "rb");
+			if (file == nullptr) {
+				return false;
+			}
+
+			std::vector<uint8_t> data;
+			uint8_t buffer[4096];
+			size_t read = 0u;
+			while ((read = fread(buffer, 1u, sizeof(buffer), file)) > 0u) {
+				data.insert(data.end(), buffer, buffer + read);
+			}
+			fclose(file);
+
+			InputLogHeader header;
+			if (data.size() < sizeof(header)) {
+				return false;
+			}
+			memcpy(&header, data.data(), sizeof(header));
+			if (header.magic != INPUT_LOG_MAGIC || header.version != INPUT_LOG_VERSION || header.buttonCount != GAMEPAD_BUTTON_COUNT || header.pollRate == 0u) {
+				return false;
+			}
+
+			m_PollRate = header.pollRate;
+			m_Changes.clear();
+			m_TickCount = 0u;
+
+			size_t offset = sizeof(header);
+			uint64_t tick = 0u;
+			while (offset < data.size()) {
+				uint64_t delta = 0u;
+				uint32_t shift = 0u;
+				uint8_t value = 0u;
+				do {
+					if (offset >= data.size() || shift > 63u) {
+						return false;
+					}
+					value = data[offset++];
+					delta |= static_cast<uint64_t>(value & 0x7Fu) << shift;
+					shift += 7u;
+				} while ((value & 0x80u) != 0u);
+
+				if (offset >= data.size()) {
+					return false;
+				}
+				Change change;
+				change.changes = data[offset++];
+				tick += delta;
+
+				if (change.changes == INPUT_LOG_END) {
+					m_TickCount = tick;
+					return true;
+				}
+
+				change.tick = tick;
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					if ((change.changes & (1u << pad)) != 0u && !ReadValue(data, offset, change.pads[pad].buttons)) {
+						return false;
+					}
+				}
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					for (uint32_t axis = 0u; (change.changes & (0x10u << pad)) != 0u && axis < INPUT_LOG_AXES; ++axis) {
+						uint16_t value = 0u;
+						if (!ReadValue(data, offset, value)) {
+							return false;
+						}
+						change.pads[pad].axes[axis] = static_cast<int16_t>(value);
+					}
+				}
+				m_Changes.push_back(change);
+			}
+
+			// the recording didn't stop properly (crash, killed), replay up to the last logged change
+			m_TickCount = m_Changes.empty() ? 0u : m_Changes.back().tick + 1u;
+			return true;
+		}
+
+		static bool ReadValue(const std::vector<uint8_t>& data, size_t& offset, uint16_t& value) {
+			if (data.size() - offset < 2u) {
+				return false;
+			}
+			value = static_cast<uint16_t>(data[offset] | (data[offset + 1u] << 8));
+			offset += 2u;
+			return true;
+		}
+
+		void PublishTick(ButtonEventQueue& events, AnalogInput& analog, TimePoint timestamp) {
+			if (m_Tick >= m_TickCount) {
+				m_IsFinished.store(true, std::memory_order_release);
+				return;
+			}
+
+			while (m_NextChange < m_Changes.size() && m_Changes[m_NextChange].tick <= m_Tick) {
+				const Change& change = m_Changes[m_NextChange];
+				for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+					if ((change.changes & (1u << pad)) != 0u) {
+						m_Pads[pad].buttons = change.pads[pad].buttons;
+					}
+					if ((change.changes & (0x10u << pad)) != 0u) {
+						memcpy(m_Pads[pad].axes, change.pads[pad].axes, sizeof(m_Pads[pad].axes));
+					}
+				}
+				++m_NextChange;
+			}
+
+			int states[MAX_GAMEPADS];
+			AnalogSample sample;
+			for (uint32_t pad = 0u; pad < MAX_GAMEPADS; ++pad) {
+				FromLogPad(m_Pads[pad], pad, states[pad], sample);
+			}
+			events.Publish(states, timestamp);
+			analog.Publish(sample, timestamp);
+
+			++m_Tick;
+			if (m_Tick >= m_TickCount) {
+				m_IsFinished.store(true, std::memory_order_release);
+			}
+		}
+
+		bool m_IsActive = false;
+		ReplaySpeed m_Speed = ReplaySpeed::ORIGINAL;
+		std::atomic<bool> m_IsFinished { false };
+
+		std::vector<Change> m_Changes;
+		size_t m_NextChange = 0u;
+		uint64_t m_Tick = 0u;
+		uint64_t m_TickCount = 0u;
+		InputLogPad m_Pads[MAX_GAMEPADS];
+
+		uint32_t m_PollRate = 0u;
+		uint32_t m_FramesPerSecond = 0u;
+		uint64_t m_Frame = 0u;
+		TimePoint m_StartTime;
+	};
+}
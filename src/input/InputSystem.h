@@ -4,6 +4,8 @@
 #include "InputSystemPS4.h"
 #elif PLATFORM_WINDOWS
 #include "InputSystemWin.h"
+#elif PLATFORM_LINUX
+#include "InputSystemLinux.h"
 #else
 #pragma error "Unsupported platform"
 #endif
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../core/Clock.h"
+#include "AnalogInput.h"
+#include "GamepadInputTypes.h"
+#include "Haptics.h"
+#include "InputEventQueue.h"
+#include "InputLog.h"
+
+namespace Input
+{
+	/*
+	 * Platform independent front-end of the InputSystem: per-frame snapshots, button queries, actions, analog
+	 * axes, recording / replay, latency stats and the game thread side of the haptics.
+	 *
+	 * Each platform derives its InputSystem from it and only adds the device side: the constructor, connection
+	 * queries and Update, which polls the pads on the input thread and hands the result to Publish, plus the
+	 * FlushHaptics that writes the motor speeds.
+	 */
+	class InputSystemBase
+	{
+	public:
+		/*
+		* Queries the state of the provided button and checks if the provided action was done
+		*
+		* BUTTON_HOLD - returns true as long as the button is done, otherwise false
+		* BUTTON_PRESSED - returns true when the button was pressed, otherwise false
+		* BUTTON_RELEASED - returns true when the button was release, otherwise false
+		*
+		* `pad` selects the gamepad slot, 0 to MAX_GAMEPADS - 1
+		*/
+		bool QueryGameButtonState(GamepadButtons button, InputAction action, uint32_t pad = 0u) {
+			if (pad >= MAX_GAMEPADS) {
+				return false;
+			}
+
+			int queriedButton = ButtonBit(button);
+			bool consumed = false;
+
+			switch (action) {
+			case InputAction::BUTTON_PRESSED:
+				// check if queried button is part of buttons pressed this frame
+				consumed = (queriedButton & m_Events.GetButtonDowns(pad)) != 0;
+				if (consumed) {
+					// remove queried button from buttons down (in order to prevent positive return in next query for pressed)
+					m_Events.ConsumeDowns(pad, queriedButton);
+				}
+				return consumed;
+			case InputAction::BUTTON_HOLD:
+				// return true if queried button was down in both the previous and the current frame
+				return (queriedButton & m_Events.GetStates(pad) & m_Events.GetPreviousStates(pad)) != 0;
+			case InputAction::BUTTON_RELEASED:
+				// same as pressed
+				consumed = (queriedButton & m_Events.GetButtonUps(pad)) != 0;
+				if (consumed) {
+					m_Events.ConsumeUps(pad, queriedButton);
+				}
+				return consumed;
+			default:
+				return false;
+			}
+		}
+
+		/*
+		* Same as above, `edgeTime` receives the poll time of the press (PRESSED, HOLD) or release (RELEASED). Use
+		* it to compensate for sub-frame timing, e.g. how long a button was already down when the frame started
+		*/
+		bool QueryGameButtonState(GamepadButtons button, InputAction action, TimePoint& edgeTime, uint32_t pad = 0u) {
+			if (pad >= MAX_GAMEPADS) {
+				return false;
+			}
+
+			const int queriedButton = ButtonBit(button);
+			edgeTime = action == InputAction::BUTTON_RELEASED ? m_Events.GetUpTime(pad, queriedButton) : m_Events.GetDownTime(pad, queriedButton);
+			return QueryGameButtonState(button, action, pad);
+		}
+
+		/*
+		* Takes the snapshot all queries of this frame work on. Call once per frame on the game thread
+		*/
+		void BeginFrame() {
+			m_Replayer.ReplayFrame(m_Events, m_Analog);
+			m_Events.BeginFrame();
+			m_Analog.BeginFrame();
+		}
+
+		/*
+		* Pressed / held / released of `pad` for this frame as GamepadButtons bitmasks (see Input::ButtonBit).
+		* Doesn't consume anything, any number of systems can read it
+		*/
+		InputFrame Snapshot(uint32_t pad = 0u) const {
+			if (pad >= MAX_GAMEPADS) {
+				return InputFrame();
+			}
+
+			InputFrame frame = m_Events.GetFrame(pad);
+			m_Analog.GetAxes(pad, frame.axes);
+			return frame;
+		}
+
+		/*
+		* Processed stick (-1..1) or trigger (0..1) value of this frame
+		*/
+		float GetAxis(GamepadAxis axis, uint32_t pad = 0u) const {
+			return pad < MAX_GAMEPADS ? m_Analog.GetAxis(pad, axis) : 0.0f;
+		}
+
+		/*
+		* Deadzones, response curve and smoothing of the analog axes, set them before the input thread starts
+		*/
+		void SetAnalogSettings(const AnalogSettings& settings) {
+			m_Analog.SetSettings(settings);
+		}
+
+		/*
+		* Game actions (see ActionMap.h). Bindings can be replaced or rebound at any time on the game thread, the
+		* input thread picks them up with its next poll
+		*/
+		template <uint32_t Count>
+		void SetActionBindings(const ActionBinding (&bindings)[Count]) {
+			m_Events.GetActionMap().SetBindings(bindings);
+		}
+
+		bool RebindAction(const ActionBinding& binding) {
+			return m_Events.GetActionMap().Rebind(binding);
+		}
+
+		/*
+		* Whether `action` is active / became active this frame (single bit tests on the BeginFrame snapshot)
+		*/
+		bool IsActionActive(uint32_t action, uint32_t pad = 0u) const {
+			return pad < MAX_GAMEPADS && action < MAX_ACTIONS && (m_Events.GetActions(pad) & ActionBit(action)) != 0;
+		}
+
+		bool WasActionTriggered(uint32_t action, uint32_t pad = 0u) const {
+			return pad < MAX_GAMEPADS && action < MAX_ACTIONS && (m_Events.GetActionsTriggered(pad) & ActionBit(action)) != 0;
+		}
+
+		/*
+		* Input recording and replay (see InputLog.h). Start them before the input thread runs and stop recording
+		* after it finished
+		*/
+		bool StartRecording(const char* path, uint32_t pollRate) {
+			return m_Recorder.Start(path, pollRate);
+		}
+
+		void StopRecording() {
+			m_Recorder.Stop();
+		}
+
+		bool StartReplay(const char* path, ReplaySpeed speed, uint32_t framesPerSecond) {
+			if (!m_Replayer.Start(path, speed, framesPerSecond)) {
+				return false;
+			}
+			SetPollRate(m_Replayer.GetPollRate());
+			return true;
+		}
+
+		bool IsReplayFinished() const {
+			return m_Replayer.IsFinished();
+		}
+
+		bool IsReplayingAtMaximumSpeed() const {
+			return m_Replayer.IsActive() && m_Replayer.GetSpeed() == ReplaySpeed::MAXIMUM;
+		}
+
+		/*
+		* Polls per second of the input thread (clamped to MIN_POLL_RATE..MAX_POLL_RATE), set it before the thread
+		* starts. A replay polls at the rate its log was recorded with
+		*/
+		void SetPollRate(uint32_t pollRate) {
+			m_PollRate = ClampPollRate(pollRate);
+			m_Analog.SetPollRate(m_PollRate);
+		}
+
+		uint32_t GetPollRate() const {
+			return m_PollRate;
+		}
+
+		/*
+		* Poll-to-frame latency of every press, release and action start that BeginFrame delivered since the last
+		* reset (game thread)
+		*/
+		InputLatencyStats GetInputLatencyStats() const {
+			return m_Events.GetLatencyStats();
+		}
+
+		void ResetInputLatencyStats() {
+			m_Events.ResetLatencyStats();
+		}
+
+		/*
+		* Applies a vibration effect to the gamepad by letting a user provide a value (could come from a curve asset for
+		* gameplay effects for example)
+		*
+		* The speed (0..Input::MAX_MOTOR_SPEED) is kept until the next call. Requests are buffered for the frame and
+		* deduplicated, calling it every frame with the same value costs nothing
+		*/
+		void ApplyVibrationEffect(uint32_t motorSpeed, uint32_t pad = 0u) {
+			m_Haptics.SetVibration(pad, motorSpeed, motorSpeed);
+		}
+
+		/*
+		* Plays a timed vibration on top of the constant one, evaluated by the input thread
+		*/
+		void PlayVibrationEnvelope(const VibrationEnvelope& envelope, uint32_t pad = 0u) {
+			m_Haptics.PlayEnvelope(pad, envelope);
+		}
+
+		/*
+		* Hands this frame's vibration requests to the input thread. Call once per frame after the game logic
+		*/
+		void EndFrame() {
+			m_Haptics.Submit();
+		}
+
+		HapticsStats GetHapticsStats() const {
+			return m_Haptics.GetStats();
+		}
+
+	protected:
+		InputSystemBase() = default;
+
+		/*
+		* Input thread - feeds the next poll of an active replay, the backend skips reading its devices then
+		*/
+		bool ReplayPoll() {
+			return m_Replayer.ReplayPoll(m_Events, m_Analog);
+		}
+
+		/*
+		* Input thread - records the poll and hands it to the game thread
+		*/
+		void Publish(const int (&states)[MAX_GAMEPADS], const AnalogSample& analog, TimePoint now) {
+			m_Recorder.Record(states, analog);
+			m_Events.Publish(states, now);
+			m_Analog.Publish(analog, now);
+		}
+
+		// recorded by the game thread, flushed to the devices by the backend's Update
+		Haptics m_Haptics;
+
+	private:
+		// written by Update (input thread), drained by BeginFrame (game thread)
+		ButtonEventQueue m_Events;
+		// processed by Update, the newest state is picked up by BeginFrame
+		AnalogInput m_Analog;
+
+		InputRecorder m_Recorder;
+		InputReplayer m_Replayer;
+		uint32_t m_PollRate = DEFAULT_POLL_RATE;
+	};
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "../core/Clock.h"
+#include "../core/Profiler.h"
+#include "GamepadInputTypes.h"
+#include "InputSystemBase.h"
+
+/*
+ * Headless input backend for Linux builds (CI, profiling, soak tests). There is no device to poll: a virtual
+ * gamepad plays a deterministic script instead, so the game loop sees presses, holds and releases on every
+ * button. Once the run time is over it presses FACE_BUTTON_RIGHT, which quits the game.
+ *
+ * The run time defaults to VIRTUAL_GAMEPAD_RUN_TIME and can be overridden in seconds with the environment
+ * variable MMP_HEADLESS_SECONDS.
+ */
+
+const int LINUX_BUTTONS[10] = {
+		1 << 0,
+		1 << 1,
+		1 << 2,
+		1 << 3,
+
+		1 << 4,
+		1 << 5,
+		1 << 6,
+		1 << 7,
+
+		1 << 8,
+		1 << 9
+};
+
+constexpr Duration VIRTUAL_GAMEPAD_RUN_TIME = Duration::FromSeconds(10);
+// every button is held for half of its period, the periods differ so the buttons overlap in varying patterns
+constexpr Duration VIRTUAL_GAMEPAD_BASE_PERIOD = Duration::FromMilliseconds(200);
+
+class InputSystem : public Input::InputSystemBase {
+private:
+	TimePoint m_StartTime;
+	Duration m_RunTime;
+	// input thread, the virtual gamepad has no motors
+	Input::MotorSpeeds m_LastVibration;
+
+	/*
+	* The virtual gamepad's buttons at the given time since startup
+	*/
+	int ScriptedButtons(Duration elapsed) const {
+		if (elapsed >= m_RunTime) {
+			return LINUX_BUTTONS[(int)Input::GamepadButtons::FACE_BUTTON_RIGHT];
+		}
+
+		int buttons = 0;
+		for (int i = 0; i < 10; ++i) {
+			if (i == (int)Input::GamepadButtons::FACE_BUTTON_RIGHT) {
+				continue;
+			}
+
+			const int64_t period = VIRTUAL_GAMEPAD_BASE_PERIOD.ToNanoseconds() * (i + 2);
+			if (elapsed.ToNanoseconds() % period < period / 2) {
+				buttons |= LINUX_BUTTONS[i];
+			}
+		}
+		return buttons;
+	}
+
+	/*
+	* Input thread - the virtual gamepad only remembers the motor speeds it would run at
+	*/
+	void FlushHaptics() {
+		m_Haptics.Flush(Clock::Now(), [this](uint32_t pad, Input::MotorSpeeds speeds) {
+			if (pad != 0u) {
+				return false;
+			}
+			m_LastVibration = speeds;
+			return true;
+		});
+	}
+
+	/*
+	* The virtual gamepad's sticks circle at different speeds and the triggers ramp up and down
+	*/
+	static void ScriptedAnalog(Duration elapsed, Input::AnalogSample& analog) {
+		const float seconds = elapsed.ToSecondsF();
+		analog.stickX[0] = std::cos(seconds * 2.0f);
+		analog.stickY[0] = std::sin(seconds * 2.0f);
+		analog.stickX[1] = 0.5f * std::cos(seconds * -3.0f);
+		analog.stickY[1] = 0.5f * std::sin(seconds * -3.0f);
+		analog.triggers[0] = 0.5f + 0.5f * std::sin(seconds);
+		analog.triggers[1] = 0.5f - 0.5f * std::sin(seconds);
+	}
+
+public:
+	InputSystem()
+		: m_StartTime(Clock::Now())
+		, m_RunTime(VIRTUAL_GAMEPAD_RUN_TIME)
+	{
+		const char* seconds = getenv("MMP_HEADLESS_SECONDS");
+		if (seconds != nullptr && atoi(seconds) > 0) {
+			m_RunTime = Duration::FromSeconds(atoi(seconds));
+		}
+	}
+
+	// the virtual gamepad sits in the first slot, the others stay empty
+	bool IsGamepadConnected(uint32_t pad = 0u) const {
+		return pad == 0u;
+	}
+
+	uint32_t GetConnectedGamepads() const {
+		return 1u;
+	}
+
+	/*
+	* Advances the virtual gamepad's script. Runs on the input thread, the edges are handed to the game thread
+	* through a lock-free queue
+	*/
+	void Update() {
+		PROFILE_SCOPE("InputSystem::Update");
+
+		// vibration keeps working while a replay drives the buttons
+		FlushHaptics();
+
+		if (ReplayPoll()) {
+			return;
+		}
+
+		const TimePoint now = Clock::Now();
+		const Duration elapsed = now - m_StartTime;
+		int states[Input::MAX_GAMEPADS] = {};
+		states[0] = Input::ToNeutralButtons(ScriptedButtons(elapsed), LINUX_BUTTONS);
+
+		Input::AnalogSample analog;
+		ScriptedAnalog(elapsed, analog);
+		Publish(states, analog, now);
+	}
+};
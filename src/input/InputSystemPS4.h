@@ -6,7 +6,10 @@
 #include <pad.h>
 #include <user_service.h>
 
+#include "../core/Profiler.h"
 #include "GamepadInputTypes.h"
+#include "GamepadSlots.h"
+#include "InputSystemBase.h"
 
 /*
  * The implementation of the InputSystem is up to you. It has to work on both platforms, PS4 and PC,
@@ -31,21 +34,21 @@ const int PS4_BUTTONS[10] = {
 	SCE_PAD_BUTTON_R1
 };
 
-class InputSystem
+class InputSystem : public Input::InputSystemBase
 {
 public:
 	InputSystem()
-		: m_UserId(-1)
-		, m_PortHandle(-1)
-		, m_ButtonDowns(0)
-		, m_ButtonUps(0)
-		, m_States(0)
-		, m_PreviousStates(0)
 	{
+		for (uint32_t pad = 0u; pad < Input::MAX_GAMEPADS; ++pad) {
+			m_UserIds[pad] = SCE_USER_SERVICE_USER_ID_INVALID;
+			m_PortHandles[pad] = -1;
+		}
+
 		sceUserServiceInitialize(NULL);
 		scePadInit();
 
-		int ret = sceUserServiceGetInitialUser(&m_UserId);
+		// the initial user always gets the first slot, users that log in later are picked up by the hot-plug probe
+		int ret = sceUserServiceGetInitialUser(&m_UserIds[0]);
 		if (ret < 0) {
 			std::cout << "Failed to obtain user id" << std::endl;
 			return;
@@ -54,101 +57,135 @@ public:
 			std::cout << "Successfully obtained user id" << std::endl;
 		}
 
-		m_PortHandle = scePadOpen(m_UserId, SCE_PAD_PORT_TYPE_STANDARD, 0, NULL);
-		if (m_PortHandle < 0) {
+		m_PortHandles[0] = scePadOpen(m_UserIds[0], SCE_PAD_PORT_TYPE_STANDARD, 0, NULL);
+		if (m_PortHandles[0] < 0) {
 			std::cout << "Setting failed" << std::endl;
 		}
 		else {
 			std::cout << "Setting suceeded" << std::endl;
 		}
 	}
+
 	/*
-		* Queries the state of the provided button and checks if the provided action was done
-		*
-		* BUTTON_HOLD - returns true as long as the button is done, otherwise false
-		* BUTTON_PRESSED - returns true when the button was pressed, otherwise false
-		* BUTTON_RELEASED - returns true when the button was release, otherwise false
-		*
+		* Queries whether the gamepad in slot `pad` was connected at the last poll
+		* (doesn't read the pad, cheap to call every frame)
 		*/
-	bool QueryGameButtonState(Input::GamepadButtons button, Input::InputAction action)
+	bool IsGamepadConnected(uint32_t pad = 0u) const
 	{
-		int queriedButton = PS4_BUTTONS[(int)button];
-		bool consumed = false;
-
-		switch (action) {
-		case Input::InputAction::BUTTON_PRESSED:
-			consumed = (queriedButton & m_ButtonDowns) != 0;
-			if (consumed) {
-				m_ButtonDowns = queriedButton ^ m_ButtonDowns;
-			}
-			return consumed;
-		case Input::InputAction::BUTTON_HOLD:
-			return (queriedButton & m_States & m_PreviousStates) != 0;
-		case Input::InputAction::BUTTON_RELEASED:
-			consumed = (queriedButton & m_ButtonUps) != 0;
-			if (consumed) {
-				m_ButtonUps = queriedButton ^ m_ButtonUps;
-			}
-			return consumed;
-		default:
-			return false;
-		}
+		return m_Slots.IsConnected(pad);
 	}
 
-	/*
-		* Queries whether a gamepad is currently connected or not
-		* Note: normally this would take a handle or ID for the gamepad, but in
-		* this assignment, we assume there's only * one * gamepad at a time
-		*/
-	bool IsGamepadConnected() const
-	{
-		ScePadData data;
-		int ret = scePadReadState(m_PortHandle, &data);
-		return data.connected;
+	uint32_t GetConnectedGamepads() const {
+		return m_Slots.GetConnectedMask();
 	}
 
 	/*
 		* Update the internals of the input system (poll gamepads, update states, ...)
-		* For now, this will be called once per frame in the main loop
+		* Runs on the input thread, the edges of all pads are handed to the game thread through a lock-free queue
 		*/
 	void Update() {
-		ScePadData data;
-		int ret = scePadReadState(m_PortHandle, &data);
+		PROFILE_SCOPE("InputSystem::Update");
 
-		// Data successfully returned
-		if (ret >= 0) {
+		// vibration keeps working while a replay drives the buttons
+		FlushHaptics();
 
-			m_PreviousStates = m_States;
-			m_States = data.buttons;
-			int changes = m_PreviousStates ^ m_States;
+		if (ReplayPoll()) {
+			return;
+		}
+
+		const TimePoint now = Clock::Now();
+		const uint32_t pollMask = m_Slots.BeginPoll(now);
 
-			if (m_States > 0) {
-				m_ButtonDowns = m_ButtonDowns | changes;
+		// pads that aren't read (or got disconnected) report no buttons, so held buttons get their release
+		int states[Input::MAX_GAMEPADS] = {};
+		Input::AnalogSample analog;
+		for (uint32_t pad = 0u; pad < Input::MAX_GAMEPADS; ++pad) {
+			if ((pollMask & (1u << pad)) == 0u) {
+				continue;
 			}
-			else {
-				m_ButtonUps = m_ButtonUps | changes;
+			if (m_PortHandles[pad] < 0 && !OpenPad(pad)) {
+				continue;
 			}
+
+			ScePadData data;
+			int ret = scePadReadState(m_PortHandles[pad], &data);
+
+			// Data successfully returned
+			const bool connected = ret >= 0 && data.connected;
+			m_Slots.SetConnected(pad, connected);
+			if (!connected) {
+				continue;
+			}
+
+			states[pad] = Input::ToNeutralButtons(static_cast<int>(data.buttons), PS4_BUTTONS);
+			// the stick's y axis points down, ours up
+			analog.stickX[pad * 2u] = Input::NormalizeCentered8(data.leftStick.x);
+			analog.stickY[pad * 2u] = -Input::NormalizeCentered8(data.leftStick.y);
+			analog.stickX[pad * 2u + 1u] = Input::NormalizeCentered8(data.rightStick.x);
+			analog.stickY[pad * 2u + 1u] = -Input::NormalizeCentered8(data.rightStick.y);
+			analog.triggers[pad * 2u] = Input::NormalizeUnsigned8(data.analogButtons.l2);
+			analog.triggers[pad * 2u + 1u] = Input::NormalizeUnsigned8(data.analogButtons.r2);
 		}
+
+		Publish(states, analog, now);
 	}
 
+private:
 	/*
-		* Applies a vibration effect to the gamepad by letting a user provide a value (could come from a curve asset for
-		* gameplay effects for example)
+		* Input thread - writes changed motor speeds, at most once per pad and poll
 		*/
-	void ApplyVibrationEffect(uint32_t motorSpeed) {
-		ScePadVibrationParam vibration;
-		vibration.largeMotor = motorSpeed;
-		vibration.smallMotor = motorSpeed;
+	void FlushHaptics() {
+		m_Haptics.Flush(Clock::Now(), [this](uint32_t pad, Input::MotorSpeeds speeds) {
+			if (!m_Slots.IsConnected(pad)) {
+				return false;
+			}
 
-		scePadSetVibration(m_PortHandle, &vibration);
+			ScePadVibrationParam vibration;
+			vibration.largeMotor = static_cast<uint8_t>(speeds.large >> 8);
+			vibration.smallMotor = static_cast<uint8_t>(speeds.small >> 8);
+			return scePadSetVibration(m_PortHandles[pad], &vibration) >= 0;
+		});
 	}
 
-private:
-	SceUserServiceUserId m_UserId;
-	int32_t m_PortHandle;
+	/*
+		* Input thread - gives the slot to a logged in user that doesn't have a pad yet. Handles are never closed
+		* or replaced, so the game thread can use them once the slot reports connected
+		*/
+	bool OpenPad(uint32_t pad) {
+		SceUserServiceLoginUserIdList users;
+		if (sceUserServiceGetLoginUserIdList(&users) < 0) {
+			return false;
+		}
+
+		for (int i = 0; i < SCE_USER_SERVICE_MAX_LOGIN_USERS; ++i) {
+			const SceUserServiceUserId userId = users.userId[i];
+			if (userId == SCE_USER_SERVICE_USER_ID_INVALID || HasSlot(userId)) {
+				continue;
+			}
+
+			const int32_t handle = scePadOpen(userId, SCE_PAD_PORT_TYPE_STANDARD, 0, NULL);
+			if (handle >= 0) {
+				m_UserIds[pad] = userId;
+				m_PortHandles[pad] = handle;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool HasSlot(SceUserServiceUserId userId) const {
+		for (uint32_t pad = 0u; pad < Input::MAX_GAMEPADS; ++pad) {
+			if (m_PortHandles[pad] >= 0 && m_UserIds[pad] == userId) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	SceUserServiceUserId m_UserIds[Input::MAX_GAMEPADS];
+	int32_t m_PortHandles[Input::MAX_GAMEPADS];
+
+	// which slots hold a connected pad, empty ones are only probed now and then
+	Input::GamepadSlots m_Slots;
 
-	int m_ButtonDowns;
-	int m_ButtonUps;
-	int m_States;
-	int m_PreviousStates;
 };
\ No newline at end of file
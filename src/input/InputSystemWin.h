@@ -4,7 +4,10 @@
 #include <cstdint>
 #include <xinput.h>
 
+#include "../core/Profiler.h"
 #include "GamepadInputTypes.h"
+#include "GamepadSlots.h"
+#include "InputSystemBase.h"
 
 /*
  * The implementation of the InputSystem is up to you. It has to work on both platforms, PS4 and PC,
@@ -28,97 +31,86 @@ const int WIN_BUTTONS[10] = {
 		XINPUT_GAMEPAD_RIGHT_SHOULDER
 };
 
-class InputSystem {
+class InputSystem : public Input::InputSystemBase {
 private:
-	DWORD m_GamePadIndex = 0;
-
-	int m_ButtonDowns;
-	int m_ButtonUps;
-	int m_States;
-	int m_PreviousStates;
+	// which XInput user indices hold a controller, empty ones are only probed now and then
+	Input::GamepadSlots m_Slots;
 
 public:
-	// member initialization list constructor
-	InputSystem()
-		: m_GamePadIndex(0)
-		, m_ButtonDowns(0)
-		, m_ButtonUps(0)
-		, m_States(0)
-		, m_PreviousStates(0) {}
-
-	bool IsGamepadConnected() const {
-		DWORD dwResult;
-		XINPUT_STATE state;
-		ZeroMemory(&state, sizeof(XINPUT_STATE));
-
-		dwResult = XInputGetState(m_GamePadIndex, &state);
-
-		return dwResult == ERROR_SUCCESS;
-	}
+	InputSystem() {}
 
 	/*
-	* Queries the state of the provided button and checks if the provided action was done
-	*
-	* BUTTON_HOLD - returns true as long as the button is done, otherwise false
-	* BUTTON_PRESSED - returns true when the button was pressed, otherwise false
-	* BUTTON_RELEASED - returns true when the button was release, otherwise false
-	*
+	* Connection state as of the last poll, doesn't touch XInput (cheap to call every frame)
 	*/
-	bool QueryGameButtonState(Input::GamepadButtons button, Input::InputAction action) {
-		int queriedButton = WIN_BUTTONS[(int)button];
-		bool consumed = false;
-
-		switch (action) {
-		case Input::InputAction::BUTTON_PRESSED:
-			// check if queried button is part of buttons currently down
-			consumed = (queriedButton & m_ButtonDowns) != 0;
-			if (consumed) {
-				// remove queried button from buttons down (in order to prevent positive return in next query for pressed)
-				m_ButtonDowns = queriedButton ^ m_ButtonDowns;
-			}
-			return consumed;
-		case Input::InputAction::BUTTON_HOLD:
-			// return true if queried button in both previous and current state
-			return (queriedButton & m_States & m_PreviousStates) != 0;
-		case Input::InputAction::BUTTON_RELEASED:
-			// same as pressed
-			consumed = (queriedButton & m_ButtonUps) != 0;
-			if (consumed) {
-				m_ButtonUps = queriedButton ^ m_ButtonUps;
-			}
-			return consumed;
-		default:
-			return false;
-		}
+	bool IsGamepadConnected(uint32_t pad = 0u) const {
+		return m_Slots.IsConnected(pad);
+	}
+
+	uint32_t GetConnectedGamepads() const {
+		return m_Slots.GetConnectedMask();
 	}
 
 	/*
 	* Update the internals of the input system (poll gamepads, update states, ...)
-	* For now, this will be called once per frame in the main loop
+	* Runs on the input thread, the edges of all pads are handed to the game thread through a lock-free queue
 	*/
 	void Update() {
-		XINPUT_STATE state;
-		ZeroMemory(&state, sizeof(XINPUT_STATE));
-		XInputGetState(m_GamePadIndex, &state);
+		PROFILE_SCOPE("InputSystem::Update");
 
-		m_PreviousStates = m_States;
-		m_States = state.Gamepad.wButtons;
-		int changes = m_PreviousStates ^ m_States;
+		// vibration keeps working while a replay drives the buttons
+		FlushHaptics();
 
-		// apply changes to button downs/ups
-		if (m_States > 0) {
-			m_ButtonDowns |= changes;
+		if (ReplayPoll()) {
+			return;
 		}
-		else {
-			m_ButtonUps |= changes;
+
+		const TimePoint now = Clock::Now();
+		const uint32_t pollMask = m_Slots.BeginPoll(now);
+
+		// pads that aren't read (or got unplugged) report no buttons, so held buttons get their release
+		int states[Input::MAX_GAMEPADS] = {};
+		Input::AnalogSample analog;
+		for (uint32_t pad = 0u; pad < Input::MAX_GAMEPADS; ++pad) {
+			if ((pollMask & (1u << pad)) == 0u) {
+				continue;
+			}
+
+			XINPUT_STATE state;
+			ZeroMemory(&state, sizeof(XINPUT_STATE));
+			const bool connected = XInputGetState(pad, &state) == ERROR_SUCCESS;
+			m_Slots.SetConnected(pad, connected);
+			if (!connected) {
+				continue;
+			}
+
+			const XINPUT_GAMEPAD& gamepad = state.Gamepad;
+			states[pad] = Input::ToNeutralButtons(gamepad.wButtons, WIN_BUTTONS);
+			analog.stickX[pad * 2u] = Input::NormalizeSigned16(gamepad.sThumbLX);
+			analog.stickY[pad * 2u] = Input::NormalizeSigned16(gamepad.sThumbLY);
+			analog.stickX[pad * 2u + 1u] = Input::NormalizeSigned16(gamepad.sThumbRX);
+			analog.stickY[pad * 2u + 1u] = Input::NormalizeSigned16(gamepad.sThumbRY);
+			analog.triggers[pad * 2u] = Input::NormalizeUnsigned8(gamepad.bLeftTrigger);
+			analog.triggers[pad * 2u + 1u] = Input::NormalizeUnsigned8(gamepad.bRightTrigger);
 		}
+
+		Publish(states, analog, now);
 	}
 
-	void ApplyVibrationEffect(uint32_t motorSpeed) {
-		XINPUT_VIBRATION vibration;
-		ZeroMemory(&vibration, sizeof(XINPUT_VIBRATION));
-		vibration.wLeftMotorSpeed = motorSpeed;
-		vibration.wRightMotorSpeed = motorSpeed;
-		XInputSetState(m_GamePadIndex, &vibration);
+private:
+	/*
+	* Input thread - writes changed motor speeds, at most once per controller and poll
+	*/
+	void FlushHaptics() {
+		m_Haptics.Flush(Clock::Now(), [this](uint32_t pad, Input::MotorSpeeds speeds) {
+			if (!m_Slots.IsConnected(pad)) {
+				return false;
+			}
+
+			XINPUT_VIBRATION vibration;
+			ZeroMemory(&vibration, sizeof(XINPUT_VIBRATION));
+			vibration.wLeftMotorSpeed = speeds.large;
+			vibration.wRightMotorSpeed = speeds.small;
+			return XInputSetState(pad, &vibration) == ERROR_SUCCESS;
+		});
 	}
 };
\ No newline at end of file
@@ -1,33 +1,279 @@
+#include <cassert>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include "input/InputSystem.h"
 #include "threading/Sys_Threading.h"
+#include "threading/Sys_JobSystem.h"
+#include "core/AllocationCounter.h"
 #include "core/Clock.h"
+#include "core/Profiler.h"
+#include "core/TickScheduler.h"
+#include "core/TripleBuffer.h"
 #include "save/SaveSystemAPI.h"
 
 namespace GameConstants
 {
-	constexpr float CONTROLLER_TICK_RATE = 250.0f;
-	constexpr float CONTROLLER_TARGET_DELTA = 1000.0f / CONTROLLER_TICK_RATE;
-	constexpr float GAME_TICK_RATE = 60.0f;
-	constexpr float GAME_TARGET_DELTA = 1000.0f / GAME_TICK_RATE;
+	// @note - rates are in integer Hz, the scheduler derives exact nanosecond deadlines from them
+	// default input poll rate, --poll-rate overrides it (up to Input::MAX_POLL_RATE)
+	constexpr uint32_t CONTROLLER_TICK_RATE = 250u;
+	constexpr uint32_t GAME_TICK_RATE = 60u;
+	// fixed steps the simulation may fall behind before it drops steps instead of catching up
+	constexpr uint32_t MAX_CATCH_UP_STEPS = 4u;
+	// saves of the same slot within this interval are coalesced into one write
+	constexpr Duration MIN_SAVE_INTERVAL = Duration::FromMilliseconds(500);
+	// buffers grow, threads register with the profiler and the first saves are written, afterwards frames must not allocate
+	constexpr Duration ALLOCATION_WARMUP = Duration::FromSeconds(1);
+	// short buzz when the score goes up
+	constexpr Input::VibrationEnvelope SCORE_PULSE = Input::VibrationPulse(0u, 30000u, Duration::FromMilliseconds(80));
+#if PLATFORM_LINUX
+	// headless, nothing to present: the simulation runs at full speed for profiling and soak tests
+	constexpr bool PACE_GAME_LOOP = false;
+#else
+	constexpr bool PACE_GAME_LOOP = true;
+#endif
 }
 
-bool shouldExitGame = false;
+enum GameAction : uint32_t
+{
+	ACTION_SAVE,
+	ACTION_LOAD,
+	ACTION_VIBRATE,
+	ACTION_INCREASE_SCORE,
+	ACTION_DECREASE_SCORE,
+	ACTION_RESET_SCORE,
+};
+
+// default bindings, checked at compile time and rebindable at runtime (InputSystem::RebindAction)
+constexpr Input::ActionBinding DEFAULT_BINDINGS[] = {
+	Input::ChordBinding("Save", ACTION_SAVE, Input::ButtonBit(Input::GamepadButtons::FACE_BUTTON_DOWN)),
+	Input::ChordBinding("Load", ACTION_LOAD, Input::ButtonBit(Input::GamepadButtons::FACE_BUTTON_TOP)),
+	Input::ChordBinding("Vibrate", ACTION_VIBRATE, Input::ButtonBit(Input::GamepadButtons::FACE_BUTTON_LEFT)),
+	Input::ChordBinding("IncreaseScore", ACTION_INCREASE_SCORE, Input::ButtonBit(Input::GamepadButtons::SHOULDER_RIGHT)),
+	Input::ChordBinding("DecreaseScore", ACTION_DECREASE_SCORE, Input::ButtonBit(Input::GamepadButtons::SHOULDER_LEFT)),
+	Input::HoldBinding("ResetScore", ACTION_RESET_SCORE,
+		Input::ButtonBit(Input::GamepadButtons::SHOULDER_LEFT) | Input::ButtonBit(Input::GamepadButtons::SHOULDER_RIGHT), Duration::FromSeconds(1)),
+};
+static_assert(Input::ValidateBindings(DEFAULT_BINDINGS), "invalid default action binding");
+
+// everything the subsystem ticks share
+struct Game
+{
+	InputSystem input;
+	SaveData::SaveSystem saveSystem;
+	SaveData::SaveGame saveGame;
+	// latest state the simulation wants written, picked up by the save tick
+	TripleBuffer<SaveData::SaveGame> saveSnapshot;
+	TickScheduler scheduler;
+	uint32_t saveSubsystem = TickScheduler::INVALID_SUBSYSTEM;
+	// heap allocations of all threads per simulation frame, checked once the warm-up is over
+	TimePoint allocationCheckStart;
+	uint64_t allocationCount = 0u;
+	uint64_t checkedFrames = 0u;
+	uint64_t steadyStateAllocations = 0u;
+};
 
-void UpdateInput(InputSystem& input) {
-	Clock::Init();
-	Clock clock;
-	clock.Start();
+/*
+ * Asserts that nothing allocated since the last frame, on any thread (input, save and I/O ticks included)
+ */
+void CheckFrameAllocations(Game& game) {
+	const uint64_t allocationCount = AllocationCounter::GetCount();
+	const uint64_t frameAllocations = allocationCount - game.allocationCount;
+	game.allocationCount = allocationCount;
+	if (!ALLOCATION_COUNTER_ENABLED || Clock::Now() < game.allocationCheckStart) {
+		return;
+	}
+
+	++game.checkedFrames;
+	if (frameAllocations != 0u) {
+		game.steadyStateAllocations += frameAllocations;
+		printf("Frame %llu allocated %llu times after the warm-up\n", static_cast<unsigned long long>(game.checkedFrames),
+			static_cast<unsigned long long>(frameAllocations));
+	}
+	assert(frameAllocations == 0u && "steady state frames must not touch the heap");
+}
+
+void PrintTickStats(const TickScheduler& scheduler) {
+	TickSubsystemStats subsystems[TickScheduler::MAX_SUBSYSTEMS];
+	const uint32_t count = scheduler.GetStats(subsystems, TickScheduler::MAX_SUBSYSTEMS);
+	for (uint32_t i = 0u; i < count; ++i) {
+		const TickSubsystemStats& stats = subsystems[i];
+		printf("Ticks %-12s %8llu ticks, %llu overruns, %llu skipped, avg %.3fms max %.3fms, latency avg %.3fms p50 %.3fms p99 %.3fms max %.3fms\n",
+			stats.name, static_cast<unsigned long long>(stats.ticks), static_cast<unsigned long long>(stats.overruns),
+			static_cast<unsigned long long>(stats.skippedTicks), stats.avgTickMs, stats.maxTickMs, stats.avgLatencyMs, stats.p50LatencyMs,
+			stats.p99LatencyMs, stats.maxLatencyMs);
+	}
+
+	const TickSchedulerStats schedulerStats = scheduler.GetSchedulerStats();
+	printf("Tick pacing: sleep overshoot %.3fms, %.1f%% of the waiting time spent spinning\n", schedulerStats.sleepOvershootMs,
+		schedulerStats.spinRatio * 100.0f);
+}
+
+void PrintSaveSlots(const SaveData::SaveSystem& saveSystem) {
+	// straight from the slot index, no file is opened
+	const uint32_t count = saveSystem.GetSaveSlotCount();
+	printf("Save slots: %u\n", count);
+	for (uint32_t i = 0u; i < count; ++i) {
+		SaveData::SaveSlotInfo slot;
+		if (saveSystem.GetSaveSlot(i, slot)) {
+			printf("  %-24s %8llu bytes, crc %08x, format %u, %s, written %lld\n", slot.name, static_cast<unsigned long long>(slot.payloadLength),
+				slot.checksum, slot.version, slot.hasBackup ? "backup" : "no backup", static_cast<long long>(slot.modifiedTime));
+		}
+	}
+}
+
+void PrintInputLatencyStats(const Input::InputLatencyStats& stats, uint32_t pollRate) {
+	printf("Input latency @ %u Hz: %u edges, mean %.3fms p50 %.3fms p90 %.3fms p99 %.3fms max %.3fms\n",
+		pollRate, stats.samples, stats.meanMs, stats.p50Ms, stats.p90Ms, stats.p99Ms, stats.maxMs);
+}
+
+void PrintHapticsStats(const Input::HapticsStats& stats) {
+	printf("Haptics: %llu requested, %llu submitted, %llu driver calls\n", static_cast<unsigned long long>(stats.requested),
+		static_cast<unsigned long long>(stats.submitted), static_cast<unsigned long long>(stats.issued));
+}
+
+void PrintProfile() {
+	ProfileZoneStats zones[32];
+	const uint32_t count = Profiler::GetZoneStats(zones, 32u);
+	for (uint32_t i = 0u; i < count; ++i) {
+		printf("Profile %-24s %8llu calls, avg %.4fms max %.3fms\n", zones[i].name, static_cast<unsigned long long>(zones[i].calls),
+			zones[i].totalMs / static_cast<float>(zones[i].calls), zones[i].maxMs);
+	}
+}
+
+void OnSaveCompleted(SaveData::SaveHandle handle, SaveData::SaveStatus status, void* userData) {
+	// a newer snapshot took the place of this one, its callback reports the write
+	if (status == SaveData::SaveStatus::SUPERSEDED) {
+		return;
+	}
+
+	// the score is smuggled through the user data, so we report what was actually written
+	const uint32_t score = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(userData));
+	if (status == SaveData::SaveStatus::SUCCEEDED) {
+		std::cout << "Saved score: " << score << std::endl;
+	}
+	else {
+		std::cout << "Saving score " << score << " failed (request " << handle << ")" << std::endl;
+	}
+}
+
+void TickInput(const TickInfo& tick, void* userData) {
+	(void)tick;
+	static_cast<Game*>(userData)->input.Update();
+}
+
+void TickSave(const TickInfo& tick, void* userData) {
+	(void)tick;
+	Game& game = *static_cast<Game*>(userData);
+	if (!game.saveSnapshot.Acquire()) {
+		return;
+	}
+
+	SaveData::SaveGame snapshot = game.saveSnapshot.GetReadBuffer();
+	SaveData::SaveFile saveFile;
+	saveFile.data = reinterpret_cast<byte*>(&snapshot);
+	saveFile.length = sizeof(snapshot);
+
+	// the payload is copied, the write itself happens on the save I/O thread
+	game.saveSystem.SaveAsync(saveFile, "save.dat", OnSaveCompleted, reinterpret_cast<void*>(static_cast<uintptr_t>(snapshot.score)));
+}
+
+/*
+ * One fixed step of the game, GAME_TICK_RATE times a second (or back to back when the game isn't paced)
+ */
+void TickSimulation(const TickInfo& tick, void* userData) {
+	(void)tick;
+	Game& game = *static_cast<Game*>(userData);
+	InputSystem& input = game.input;
+	SaveData::SaveSystem& saveSystem = game.saveSystem;
+	SaveData::SaveGame& saveGame = game.saveGame;
+
+	// take this frame's input snapshot, all queries below see the same state
+	input.BeginFrame();
+	// read-only view of this frame's buttons and actions, doesn't consume the edges the queries below look at
+	const Input::InputFrame frame = input.Snapshot();
+
+	// report async saves that finished since last frame
+	saveSystem.Update();
+
+	// @note - lukas.vogl - We want to exit the game when the right button on the gamepad face is pressed ( B on XBox controllers, Circle on Dualshocks )
+	if ( input.QueryGameButtonState( Input::GamepadButtons::FACE_BUTTON_RIGHT, Input::InputAction::BUTTON_PRESSED ) )
+	{
+		game.scheduler.Stop();
+	}
+
+	if (input.IsReplayFinished()) {
+		game.scheduler.Stop();
+	}
+
+	/*
+	if (!input.IsGamepadConnected()) {
+		std::cout << "No controller found." << std::endl;
+		game.scheduler.Stop();
+	}*/
+
+	saveGame.score = 8u;
+
+	if (true || frame.WasActionTriggered(ACTION_SAVE))
+	{
+		// written by the save tick, the simulation doesn't wait for the copy
+		game.saveSnapshot.GetWriteBuffer() = saveGame;
+		game.saveSnapshot.Publish();
+		game.scheduler.Request(game.saveSubsystem);
+	}
+
+	if (true || frame.WasActionTriggered(ACTION_LOAD))
+	{
+		// reads straight from the mapped file, released at the end of the scope
+		const SaveData::SaveView saveView = saveSystem.LoadView("save.dat");
+
+		if (const SaveData::SaveGame* loaded = saveView.As<SaveData::SaveGame>()) {
+			saveGame = *loaded;
+			std::cout << "Loading last saved score: " << saveGame.score << std::endl;
+		}
+		else {
+			std::cout << "Could not load save file. Make sure a save file exists. " << std::endl;
+		}
+	}
 
-	float passedGameTime = 0.0f;
+	// // @note - lukas.vogl - We want to test the vibration feature with the down button (as long as it's hold, we vibrate)
+	if ( frame.IsActionActive( ACTION_VIBRATE ) )
+	{
+		input.ApplyVibrationEffect( 20000 );
+	}
+	else
+	{
+		input.ApplyVibrationEffect( 0 );
+	}
+
+	if (frame.WasActionTriggered(ACTION_INCREASE_SCORE)) {
+		saveGame.score++;
+		std::cout << "Increasing score: " << saveGame.score << std::endl;
+		input.PlayVibrationEnvelope(GameConstants::SCORE_PULSE);
+	}
 
-	while (!shouldExitGame) {
-		input.Update();
+	if (frame.WasActionTriggered(ACTION_DECREASE_SCORE)) {
+		if (saveGame.score > 0) {
+			saveGame.score--;
+		}
+		std::cout << "Decreasing score: " << saveGame.score << std::endl;
+	}
 
-		while (clock.ToMilliseconds() < passedGameTime + GameConstants::CONTROLLER_TARGET_DELTA);
-		passedGameTime = clock.ToMilliseconds();
+	if (frame.WasActionTriggered(ACTION_RESET_SCORE)) {
+		saveGame.score = 0u;
+		std::cout << "Resetting score" << std::endl;
 	}
+
+	// @task - lukas.vogl - Add another function here that let's you (and later me) test that your input system reacts to presses, releases and hold actions for the supported buttons
+
+	// hands this frame's vibration requests to the input tick
+	input.EndFrame();
+
+	CheckFrameAllocations(game);
+
+	// folds this frame's zones of all threads into the profile (this tick's own zone shows up next frame)
+	PROFILE_END_FRAME();
 }
 
 /*
@@ -39,111 +285,167 @@ void UpdateInput(InputSystem& input) {
 RB - INCREASE SCORE
 LB - DECREASE SCORE
 
+ --record <file>	writes the buttons and analog axes of every poll of all gamepads to an input log
+ --replay <file>	plays an input log back instead of polling the gamepads
+ --replay-fast		plays it back as fast as the game loop runs (one logged frame per game frame)
+ --poll-rate <hz>	input poll rate, 30 to 1000
+ --trace <file>		writes the last profiler zones of every thread as a Chrome trace (chrome://tracing, ui.perfetto.dev)
+ --unpinned-input	leaves the tick scheduler thread, which polls the input, to the OS (compare the "Ticks Input" latency with the pinned default)
+
 */
 
-int main() 
+int main(int argc, char** argv) 
 {
 	// @note - lukas.vogl - Setting up a basic clock that works on PC and PS4
 	Clock::Init();
 	Clock clock;
 	clock.Start();
 
+	Profiler::Init();
+	Sys_SetThreadName(Sys_GetCurrentThreadID(), "Main");
+
 	printf("Hello MMP course development project\n");
 
+	// one worker per core, the main thread is worker 0
+	Sys_InitJobSystem();
+
 	/*
 	 * The setup of the input system is up to you. It can be initialized after the CTOR
 	 * but you can also use `Initialize` methods when it makes sense for your implementation.
 	 */
-	InputSystem input;
-
-	threadCreateParam_t params;
-	params.function = reinterpret_cast<thread_t>(UpdateInput);
-	params.params = &input;
-	params.name = "UpdateInput";
-
-	threadHandle_t handle = Sys_CreateThread(params);
-
-	SaveData::SaveGame saveGame;
-	SaveData::SaveSystem saveSystem;
-
-	saveSystem.Initialize();
-
-	// @note - lukas.vogl - Pseudo "game-loop" to simulate we are doing something (will ne necessary for further milestones)
-	float passedGameTime = 0.0f;
-	while ( !shouldExitGame )
-	{
-		// @note - lukas.vogl - We want to exit the game when the right button on the gamepad face is pressed ( B on XBox controllers, Circle on Dualshocks )
-		if ( input.QueryGameButtonState( Input::GamepadButtons::FACE_BUTTON_RIGHT, Input::InputAction::BUTTON_PRESSED ) )
-		{
-			shouldExitGame = true;
+	Game game;
+	InputSystem& input = game.input;
+	SaveData::SaveSystem& saveSystem = game.saveSystem;
+
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	bool fastReplay = false;
+	bool pinInput = true;
+	const char* tracePath = nullptr;
+	uint32_t pollRate = GameConstants::CONTROLLER_TICK_RATE;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordPath = argv[++i];
 		}
-
-		/*
-		if (!input.IsGamepadConnected()) {
-			std::cout << "No controller found." << std::endl;
-			shouldExitGame = true;
-		}*/
-
-		saveGame.score = 8u;
-
-		if (true || input.QueryGameButtonState(Input::GamepadButtons::FACE_BUTTON_DOWN, Input::InputAction::BUTTON_PRESSED))
-		{
-			SaveData::SaveFile saveFile;
-			saveFile.data = reinterpret_cast<byte*>(&saveGame);
-			saveFile.length = sizeof(saveGame);
-
-			if (saveSystem.Save(saveFile, "save.dat")) {
-				SaveData::SaveGame save = *reinterpret_cast<SaveData::SaveGame*>(saveFile.data);
-				std::cout << "Saving current score: " << save.score << std::endl;
-			}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayPath = argv[++i];
 		}
-
-		if (true || input.QueryGameButtonState(Input::GamepadButtons::FACE_BUTTON_TOP, Input::InputAction::BUTTON_PRESSED))
-		{
-			SaveData::SaveFile* saveFile = saveSystem.Load("save.dat");
-
-			if (saveFile->IsValid()) {
-				saveGame = *reinterpret_cast<SaveData::SaveGame*>(saveFile->data);
-				std::cout << "Loading last saved score: " << saveGame.score << std::endl;
-			}
-			else {
-				std::cout << "Could not load save file. Make sure a save file exists. " << std::endl;
-			}
-
-			delete saveFile;
+		else if (strcmp(argv[i], "--replay-fast") == 0) {
+			fastReplay = true;
 		}
-
-		// // @note - lukas.vogl - We want to test the vibration feature with the down button (as long as it's hold, we vibrate)
-		if ( input.QueryGameButtonState( Input::GamepadButtons::FACE_BUTTON_LEFT, Input::InputAction::BUTTON_HOLD ) )
-		{
-			input.ApplyVibrationEffect( 20000 );
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			tracePath = argv[++i];
 		}
-		else
-		{
-			input.ApplyVibrationEffect( 0 );
+		else if (strcmp(argv[i], "--unpinned-input") == 0) {
+			pinInput = false;
 		}
-
-		if (input.QueryGameButtonState(Input::GamepadButtons::SHOULDER_RIGHT, Input::InputAction::BUTTON_PRESSED)) {
-			saveGame.score++;
-			std::cout << "Increasing score: " << saveGame.score << std::endl;
+		else if (strcmp(argv[i], "--poll-rate") == 0 && i + 1 < argc) {
+			pollRate = static_cast<uint32_t>(atoi(argv[++i]));
 		}
+	}
+
+	input.SetPollRate(pollRate);
+	input.SetActionBindings(DEFAULT_BINDINGS);
 
-		if (input.QueryGameButtonState(Input::GamepadButtons::SHOULDER_LEFT, Input::InputAction::BUTTON_PRESSED)) {
-			if (saveGame.score > 0) {
-				saveGame.score--;
-			}
-			std::cout << "Decreasing score: " << saveGame.score << std::endl;
+	// has to happen before the input tick starts polling
+	if (replayPath != nullptr) {
+		const Input::ReplaySpeed speed = fastReplay ? Input::ReplaySpeed::MAXIMUM : Input::ReplaySpeed::ORIGINAL;
+		if (!input.StartReplay(replayPath, speed, GameConstants::GAME_TICK_RATE)) {
+			printf("Failed to load input log %s\n", replayPath);
+			Sys_ShutdownJobSystem();
+			return 1;
 		}
+	}
+	else if (recordPath != nullptr && !input.StartRecording(recordPath, input.GetPollRate())) {
+		printf("Failed to create input log %s\n", recordPath);
+	}
 
-		// @task - lukas.vogl - Add another function here that let's you (and later me) test that your input system reacts to presses, releases and hold actions for the supported buttons
+	saveSystem.Initialize();
+	saveSystem.SetMinSaveInterval(GameConstants::MIN_SAVE_INTERVAL);
+	PrintSaveSlots(saveSystem);
+
+	TickSubsystemDesc inputTick;
+	inputTick.name = "Input";
+	inputTick.function = TickInput;
+	inputTick.userData = &game;
+	inputTick.mode = TickMode::FIXED_RATE;
+	inputTick.ticksPerSecond = input.GetPollRate();
+	inputTick.priority = 2u;
+	// polls on the scheduler thread, with its priority and core
+	inputTick.runOnSchedulerThread = true;
+	game.scheduler.Register(inputTick);
+
+	// @note - lukas.vogl - This is here to simulate a 60HZ game-loop and will later be used to show further optimizations we can do by using threads
+	TickSubsystemDesc simulationTick;
+	simulationTick.name = "Simulation";
+	simulationTick.function = TickSimulation;
+	simulationTick.userData = &game;
+	simulationTick.priority = 1u;
+	if (GameConstants::PACE_GAME_LOOP && !input.IsReplayingAtMaximumSpeed()) {
+		simulationTick.mode = TickMode::FIXED_STEP;
+		simulationTick.ticksPerSecond = GameConstants::GAME_TICK_RATE;
+		simulationTick.maxCatchUpSteps = GameConstants::MAX_CATCH_UP_STEPS;
+	}
+	else {
+		simulationTick.mode = TickMode::CONTINUOUS;
+	}
+	game.scheduler.Register(simulationTick);
+
+	TickSubsystemDesc saveTick;
+	saveTick.name = "Save";
+	saveTick.function = TickSave;
+	saveTick.userData = &game;
+	saveTick.mode = TickMode::ON_DEMAND;
+	game.saveSubsystem = game.scheduler.Register(saveTick);
+
+	game.allocationCheckStart = Clock::Now() + GameConstants::ALLOCATION_WARMUP;
+
+	// the main thread works off the ticks until the simulation stops the scheduler
+	if (pinInput) {
+		// the scheduler thread gets its own core (the last one, the main thread and the first workers start at the
+		// front) and preempts the workers, so the input is polled and the other ticks are dispatched on time
+		game.scheduler.Run(threadPriority_t::HIGH, Sys_CoreMask(Sys_GetCoreCount() - 1u, Sys_GetCoreCount()));
+	}
+	else {
+		game.scheduler.Run(threadPriority_t::NORMAL);
+	}
+
+	input.StopRecording();
+
+	// flushes the saves that are still queued
+	saveSystem.Shutdown();
+	saveSystem.Update();
+
+	SaveData::SaveStats saveStats = saveSystem.GetSaveStats();
+	printf("Saves: %llu requested, %llu coalesced, %llu written\n", static_cast<unsigned long long>(saveStats.requestedSaves),
+		static_cast<unsigned long long>(saveStats.coalescedSaves), static_cast<unsigned long long>(saveStats.physicalWrites));
+	printf("Save writes: %llu snapshots, %llu deltas, %llu bytes\n", static_cast<unsigned long long>(saveStats.snapshotWrites),
+		static_cast<unsigned long long>(saveStats.deltaWrites), static_cast<unsigned long long>(saveStats.bytesWritten));
+
+	const float compressionSeconds = saveStats.compressionTime.ToSecondsF();
+	printf("Save compression: %llu compressed, %llu bypassed, ratio %.2f, %.0f MB/s\n", static_cast<unsigned long long>(saveStats.compressedSaves),
+		static_cast<unsigned long long>(saveStats.bypassedCompressions),
+		saveStats.compressionOutputBytes > 0u ? static_cast<float>(saveStats.compressionInputBytes) / saveStats.compressionOutputBytes : 1.0f,
+		compressionSeconds > 0.0f ? saveStats.compressionInputBytes / (1024.0f * 1024.0f) / compressionSeconds : 0.0f);
+
+	PrintTickStats(game.scheduler);
+	if (ALLOCATION_COUNTER_ENABLED) {
+		printf("Heap: %llu allocations in %llu frames after the warm-up, %llu allocations (%llu bytes) in total\n",
+			static_cast<unsigned long long>(game.steadyStateAllocations), static_cast<unsigned long long>(game.checkedFrames),
+			static_cast<unsigned long long>(AllocationCounter::GetCount()), static_cast<unsigned long long>(AllocationCounter::GetBytes()));
+	}
+	PrintInputLatencyStats(input.GetInputLatencyStats(), input.GetPollRate());
+	PrintHapticsStats(input.GetHapticsStats());
 
-		// @note - lukas.vogl - This is here to simulate a 60HZ game-loop and will later be used to show further optimizations we can do by using threads
-		while ( clock.ToMilliseconds() < passedGameTime + GameConstants::GAME_TARGET_DELTA ) { /* busy wait here - not optimal, and not production ready code, but enough for the assignment */ }
-		passedGameTime = clock.ToMilliseconds();
+	PROFILE_END_FRAME();
+	PrintProfile();
+	if (tracePath != nullptr && !Profiler::WriteChromeTrace(tracePath)) {
+		printf("Failed to write the profiler trace %s\n", tracePath);
 	}
 
-	Sys_WaitForThread(handle);
-	Sys_DestroyThread(handle);
+	jobSystemStats_t jobStats = Sys_GetJobSystemStats();
+	printf("Job system: %u workers, %.0f jobs/sec, steal rate %.2f\n", jobStats.workerCount, jobStats.jobsPerSecond, jobStats.stealRate);
+	Sys_ShutdownJobSystem();
 
 	printf("Shutting dow ...\n");
 
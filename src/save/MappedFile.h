@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if PLATFORM_WINDOWS
+	#define WIN_LEAN_AND_MEAN
+	#include <windows.h>
+	#undef WIN_LEAN_AND_MEAN
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "SaveTypes.h"
+
+namespace SaveData
+{
+	/*
+	 * Read-only memory mapping of a whole file. Pages are only faulted in when they are touched, and the
+	 * mapping is released in the destructor.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) {
+			*this = std::move(other);
+		}
+
+		MappedFile& operator=(MappedFile&& other) {
+			if (this != &other) {
+				Close();
+				std::swap(m_Data, other.m_Data);
+				std::swap(m_Size, other.m_Size);
+#if PLATFORM_WINDOWS
+				std::swap(m_File, other.m_File);
+				std::swap(m_Mapping, other.m_Mapping);
+#endif
+			}
+			return *this;
+		}
+
+		~MappedFile() {
+			Close();
+		}
+
+		bool Open(const char* path) {
+			Close();
+
+#if PLATFORM_WINDOWS
+			// full sharing lets the save worker rename or replace the file while it is still mapped, ReplaceFile opens
+			// the replaced file for writing to carry its attributes over
+			m_File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+				FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (m_File == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+				Close();
+				return false;
+			}
+
+			m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (m_Mapping == NULL) {
+				Close();
+				return false;
+			}
+
+			m_Data = static_cast<const byte*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+			if (m_Data == nullptr) {
+				Close();
+				return false;
+			}
+			m_Size = static_cast<size_t>(size.QuadPart);
+#else
+			const int file = open(path, O_RDONLY);
+			if (file < 0) {
+				return false;
+			}
+
+			struct stat info;
+			if (fstat(file, &info) != 0 || info.st_size == 0) {
+				close(file);
+				return false;
+			}
+
+			void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			// the mapping keeps its own reference to the file
+			close(file);
+			if (data == MAP_FAILED) {
+				return false;
+			}
+
+			m_Data = static_cast<const byte*>(data);
+			m_Size = static_cast<size_t>(info.st_size);
+#endif
+			return true;
+		}
+
+		void Close() {
+#if PLATFORM_WINDOWS
+			if (m_Data != nullptr) {
+				UnmapViewOfFile(m_Data);
+			}
+			if (m_Mapping != NULL) {
+				CloseHandle(m_Mapping);
+				m_Mapping = NULL;
+			}
+			if (m_File != INVALID_HANDLE_VALUE) {
+				CloseHandle(m_File);
+				m_File = INVALID_HANDLE_VALUE;
+			}
+#else
+			if (m_Data != nullptr) {
+				munmap(const_cast<byte*>(m_Data), m_Size);
+			}
+#endif
+			m_Data = nullptr;
+			m_Size = 0u;
+		}
+
+		bool IsOpen() const { return m_Data != nullptr; }
+		const byte* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const byte* m_Data = nullptr;
+		size_t m_Size = 0u;
+
+#if PLATFORM_WINDOWS
+		HANDLE m_File = INVALID_HANDLE_VALUE;
+		HANDLE m_Mapping = NULL;
+#endif
+	};
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "SaveTypes.h"
+
+namespace SaveData
+{
+	constexpr size_t SAVE_ARENA_SIZE = 64u * 1024u;
+
+	struct SaveArenaStats
+	{
+		size_t capacity = 0u;
+		// most bytes ever in use at once
+		size_t highWater = 0u;
+		// requests that didn't fit, the operation that made them failed instead of touching the heap
+		uint64_t failedAllocations = 0u;
+	};
+
+	/*
+	 * Fixed-size bump allocator for the temporaries of a single save or load operation.
+	 *
+	 * The whole block is allocated once when the save system is created. Allocating only moves an offset, nothing
+	 * is freed individually: an operation takes a marker (or opens a SaveArenaScope) and rewinds to it when it's
+	 * done, so steady state saving and loading never touches the global heap. A request that doesn't fit returns
+	 * nullptr and is counted, the capacity has to cover the largest operation.
+	 *
+	 * Not thread-safe, the save system only uses it while holding its file mutex.
+	 */
+	class SaveArena {
+	public:
+		typedef size_t Marker;
+
+		explicit SaveArena(size_t capacity = SAVE_ARENA_SIZE)
+			: m_Memory(new byte[capacity])
+			, m_Capacity(capacity) {}
+
+		SaveArena(const SaveArena&) = delete;
+		SaveArena& operator=(const SaveArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+			const uintptr_t base = reinterpret_cast<uintptr_t>(m_Memory.get());
+			const size_t offset = static_cast<size_t>(((base + m_Offset + alignment - 1u) & ~(static_cast<uintptr_t>(alignment) - 1u)) - base);
+			if (offset > m_Capacity || size > m_Capacity - offset) {
+				++m_FailedAllocations;
+				return nullptr;
+			}
+
+			m_Offset = offset + size;
+			if (m_Offset > m_HighWater) {
+				m_HighWater = m_Offset;
+			}
+			return m_Memory.get() + offset;
+		}
+
+		/*
+		 * Value-initialized object, never destroyed, so only trivially destructible types are allowed
+		 */
+		template <typename T>
+		T* Create() {
+			static_assert(std::is_trivially_destructible<T>::value, "arena objects are released without running their destructor");
+			void* memory = Allocate(sizeof(T), alignof(T));
+			return memory != nullptr ? new (memory) T() : nullptr;
+		}
+
+		/*
+		 * The strings back to back as a terminated string in the arena (e.g. the temp file of a slot)
+		 */
+		const char* Concat(const char* first, const char* second, const char* third = "") {
+			const size_t firstLength = strlen(first);
+			const size_t secondLength = strlen(second);
+			const size_t thirdLength = strlen(third);
+			char* text = static_cast<char*>(Allocate(firstLength + secondLength + thirdLength + 1u, 1u));
+			if (text == nullptr) {
+				return nullptr;
+			}
+
+			memcpy(text, first, firstLength);
+			memcpy(text + firstLength, second, secondLength);
+			memcpy(text + firstLength + secondLength, third, thirdLength + 1u);
+			return text;
+		}
+
+		Marker GetMarker() const {
+			return m_Offset;
+		}
+
+		/*
+		 * Releases everything allocated after the marker was taken
+		 */
+		void Rewind(Marker marker) {
+			m_Offset = marker < m_Offset ? marker : m_Offset;
+		}
+
+		void Reset() {
+			m_Offset = 0u;
+		}
+
+		SaveArenaStats GetStats() const {
+			SaveArenaStats stats;
+			stats.capacity = m_Capacity;
+			stats.highWater = m_HighWater;
+			stats.failedAllocations = m_FailedAllocations;
+			return stats;
+		}
+
+	private:
+		std::unique_ptr<byte[]> m_Memory;
+		size_t m_Capacity;
+		size_t m_Offset = 0u;
+		size_t m_HighWater = 0u;
+		uint64_t m_FailedAllocations = 0u;
+	};
+
+	/*
+	 * Rewinds the arena to where it was when the scope was opened
+	 */
+	class SaveArenaScope {
+	public:
+		explicit SaveArenaScope(SaveArena& arena)
+			: m_Arena(arena)
+			, m_Marker(arena.GetMarker()) {}
+
+		~SaveArenaScope() {
+			m_Arena.Rewind(m_Marker);
+		}
+
+		SaveArenaScope(const SaveArenaScope&) = delete;
+		SaveArenaScope& operator=(const SaveArenaScope&) = delete;
+
+	private:
+		SaveArena& m_Arena;
+		SaveArena::Marker m_Marker;
+	};
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if PLATFORM_WINDOWS
+	#define WIN_LEAN_AND_MEAN
+	#include <windows.h>
+	#undef WIN_LEAN_AND_MEAN
+#else
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <stdio.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "SaveArena.h"
+#include "SaveTypes.h"
+
+/*
+ * Crash-safe commit of a file generation on plain file systems (PC / Linux):
+ *
+ * 1. the new data is written exactly once into `<name>.tmp` and flushed to the disk
+ * 2. the current `<name>` becomes `<name>.bak` and `<name>.tmp` atomically takes its place
+ *
+ * At every point in time either the old or the new generation is complete under `<name>`, and the previous
+ * generation survives as the backup. Compared to writing the file, reading it back and copying it this is a
+ * single write per save.
+ */
+namespace SaveData
+{
+	constexpr const char* TEMP_SAVE_SUFFIX = ".tmp";
+	constexpr const char* BACKUP_SAVE_SUFFIX = ".bak";
+	// longest path the commit handles without allocating
+	constexpr size_t MAX_SAVE_PATH_LENGTH = 260u;
+
+	enum class CommitStep
+	{
+		OPEN_TEMP,
+		WRITE_TEMP,
+		FLUSH_TEMP,
+		CLOSE_TEMP,
+		ROTATE_BACKUP,
+		RENAME_TEMP,
+		FLUSH_DIRECTORY,
+		APPEND_JOURNAL,
+		FLUSH_JOURNAL,
+	};
+
+	/*
+	 * Fault injection: when set, the hook is asked before every step and returning true aborts the commit right
+	 * there, leaving the files exactly as a crash at that point would. Used to verify Load's recovery paths.
+	 */
+	typedef bool (*CommitFaultHook)(CommitStep step);
+	CommitFaultHook commitFaultHook = nullptr;
+
+	bool InjectCommitFault(CommitStep step) {
+		return commitFaultHook != nullptr && commitFaultHook(step);
+	}
+
+	// one piece of a file that is written with a single call (e.g. container header + payload)
+	struct SaveBuffer
+	{
+		const byte* data;
+		size_t length;
+	};
+
+	// the names live in the arena, nullptr when it's full
+	const char* TempSaveName(SaveArena& arena, const char* name) {
+		return arena.Concat(name, TEMP_SAVE_SUFFIX);
+	}
+
+	const char* BackupSaveName(SaveArena& arena, const char* name) {
+		return arena.Concat(name, BACKUP_SAVE_SUFFIX);
+	}
+
+#if PLATFORM_WINDOWS
+
+	bool WriteBuffers(HANDLE file, const SaveBuffer* buffers, size_t bufferCount) {
+		bool succeeded = true;
+		for (size_t i = 0u; succeeded && i < bufferCount; ++i) {
+			const byte* data = buffers[i].data;
+			const size_t length = buffers[i].length;
+
+			size_t written = 0u;
+			while (succeeded && written < length) {
+				DWORD chunk = 0;
+				const DWORD request = static_cast<DWORD>((length - written) > 0x40000000u ? 0x40000000u : (length - written));
+				succeeded = WriteFile(file, data + written, request, &chunk, NULL) != 0;
+				written += chunk;
+			}
+		}
+		return succeeded;
+	}
+
+	/*
+	 * Writes the buffers back to back into the file and only returns true once they reached the disk
+	 */
+	bool WriteFileDurable(const char* path, const SaveBuffer* buffers, size_t bufferCount) {
+		if (InjectCommitFault(CommitStep::OPEN_TEMP)) {
+			return false;
+		}
+
+		HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		bool succeeded = !InjectCommitFault(CommitStep::WRITE_TEMP) && WriteBuffers(file, buffers, bufferCount);
+		succeeded = succeeded && !InjectCommitFault(CommitStep::FLUSH_TEMP) && FlushFileBuffers(file) != 0;
+		if (InjectCommitFault(CommitStep::CLOSE_TEMP)) {
+			// a crashing process doesn't keep the handle either
+			CloseHandle(file);
+			return false;
+		}
+		return CloseHandle(file) != 0 && succeeded;
+	}
+
+	/*
+	 * Cuts the file off at `offset` (dropping a torn tail) and appends the buffers there, returns true once they
+	 * reached the disk. A crash leaves everything before `offset` untouched.
+	 */
+	bool AppendFileDurable(const char* path, uint64_t offset, const SaveBuffer* buffers, size_t bufferCount) {
+		HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		LARGE_INTEGER position;
+		position.QuadPart = static_cast<LONGLONG>(offset);
+		bool succeeded = SetFilePointerEx(file, position, NULL, FILE_BEGIN) != 0 && SetEndOfFile(file) != 0;
+
+		succeeded = succeeded && !InjectCommitFault(CommitStep::APPEND_JOURNAL) && WriteBuffers(file, buffers, bufferCount);
+		succeeded = succeeded && !InjectCommitFault(CommitStep::FLUSH_JOURNAL) && FlushFileBuffers(file) != 0;
+		return CloseHandle(file) != 0 && succeeded;
+	}
+
+	// ReplaceFile attempts before falling back to two renames, virus scanners and indexers briefly lock new files
+	constexpr uint32_t REPLACE_FILE_ATTEMPTS = 3u;
+	constexpr DWORD REPLACE_FILE_RETRY_MILLISECONDS = 2u;
+
+	/*
+	 * Atomically replaces `target` with `temp`, the replaced generation is kept as `backup`.
+	 *
+	 * When ReplaceFile keeps failing (e.g. another handle to `target` doesn't share write access) the generations
+	 * are rotated with two renames instead. A crash between them leaves only the backup, which Load restores.
+	 */
+	bool CommitFile(const char* temp, const char* target, const char* backup) {
+		if (InjectCommitFault(CommitStep::ROTATE_BACKUP) || InjectCommitFault(CommitStep::RENAME_TEMP)) {
+			return false;
+		}
+
+		for (uint32_t attempt = 0u; attempt < REPLACE_FILE_ATTEMPTS; ++attempt) {
+			// very first save, or ReplaceFile already moved the old target to the backup, there is nothing to replace
+			if (GetFileAttributesA(target) == INVALID_FILE_ATTRIBUTES) {
+				return MoveFileExA(temp, target, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+			}
+
+			// ReplaceFile swaps the files and moves the old target to the backup in one go
+			if (ReplaceFileA(target, temp, backup, REPLACEFILE_WRITE_THROUGH, NULL, NULL) != 0) {
+				return true;
+			}
+			Sleep(REPLACE_FILE_RETRY_MILLISECONDS);
+		}
+
+		if (MoveFileExA(target, backup, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == 0) {
+			return false;
+		}
+		return MoveFileExA(temp, target, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+
+	bool SaveFileExists(const char* path) {
+		return GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES;
+	}
+
+#else
+
+	bool WriteBuffers(int file, const SaveBuffer* buffers, size_t bufferCount) {
+		bool succeeded = true;
+		for (size_t i = 0u; succeeded && i < bufferCount; ++i) {
+			const byte* data = buffers[i].data;
+			const size_t length = buffers[i].length;
+
+			size_t written = 0u;
+			while (succeeded && written < length) {
+				const ssize_t chunk = write(file, data + written, length - written);
+				if (chunk < 0 && errno == EINTR) {
+					continue;
+				}
+				succeeded = chunk > 0;
+				written += succeeded ? static_cast<size_t>(chunk) : 0u;
+			}
+		}
+		return succeeded;
+	}
+
+	/*
+	 * Writes the buffers back to back into the file and only returns true once they reached the disk
+	 */
+	bool WriteFileDurable(const char* path, const SaveBuffer* buffers, size_t bufferCount) {
+		if (InjectCommitFault(CommitStep::OPEN_TEMP)) {
+			return false;
+		}
+
+		const int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (file < 0) {
+			return false;
+		}
+
+		bool succeeded = !InjectCommitFault(CommitStep::WRITE_TEMP) && WriteBuffers(file, buffers, bufferCount);
+		succeeded = succeeded && !InjectCommitFault(CommitStep::FLUSH_TEMP) && fsync(file) == 0;
+		if (InjectCommitFault(CommitStep::CLOSE_TEMP)) {
+			// a crashing process doesn't keep the descriptor either
+			close(file);
+			return false;
+		}
+		return close(file) == 0 && succeeded;
+	}
+
+	/*
+	 * Cuts the file off at `offset` (dropping a torn tail) and appends the buffers there, returns true once they
+	 * reached the disk. A crash leaves everything before `offset` untouched.
+	 */
+	bool AppendFileDurable(const char* path, uint64_t offset, const SaveBuffer* buffers, size_t bufferCount) {
+		const int file = open(path, O_WRONLY | O_CREAT, 0644);
+		if (file < 0) {
+			return false;
+		}
+
+		const off_t position = static_cast<off_t>(offset);
+		bool succeeded = ftruncate(file, position) == 0 && lseek(file, position, SEEK_SET) == position;
+
+		succeeded = succeeded && !InjectCommitFault(CommitStep::APPEND_JOURNAL) && WriteBuffers(file, buffers, bufferCount);
+		succeeded = succeeded && !InjectCommitFault(CommitStep::FLUSH_JOURNAL) && fsync(file) == 0;
+		return close(file) == 0 && succeeded;
+	}
+
+	/*
+	 * Makes renames inside the directory of `path` durable
+	 */
+	bool FlushParentDirectory(const char* path) {
+		const char* separator = strrchr(path, '/');
+		const size_t length = separator == nullptr ? 0u : (separator == path ? 1u : static_cast<size_t>(separator - path));
+		if (length >= MAX_SAVE_PATH_LENGTH) {
+			return false;
+		}
+
+		char directory[MAX_SAVE_PATH_LENGTH] = ".";
+		if (length > 0u) {
+			memcpy(directory, path, length);
+			directory[length] = '\0';
+		}
+
+		const int handle = open(directory, O_RDONLY);
+		if (handle < 0) {
+			return false;
+		}
+		const bool succeeded = fsync(handle) == 0;
+		close(handle);
+		return succeeded;
+	}
+
+	/*
+	 * Atomically replaces `target` with `temp`, the replaced generation is kept as `backup`
+	 */
+	bool CommitFile(const char* temp, const char* target, const char* backup) {
+		if (InjectCommitFault(CommitStep::ROTATE_BACKUP)) {
+			return false;
+		}
+
+		// hard-link the current generation as backup, so `target` never disappears (no data is copied)
+		struct stat info;
+		if (stat(target, &info) == 0) {
+			unlink(backup);
+			if (link(target, backup) != 0 && rename(target, backup) != 0) {
+				return false;
+			}
+		}
+
+		if (InjectCommitFault(CommitStep::RENAME_TEMP)) {
+			return false;
+		}
+		if (rename(temp, target) != 0) {
+			return false;
+		}
+
+		if (InjectCommitFault(CommitStep::FLUSH_DIRECTORY)) {
+			return false;
+		}
+		return FlushParentDirectory(target);
+	}
+
+	bool SaveFileExists(const char* path) {
+		struct stat info;
+		return stat(path, &info) == 0;
+	}
+
+#endif
+
+	bool WriteFileDurable(const char* path, const byte* data, size_t length) {
+		const SaveBuffer buffer = { data, length };
+		return WriteFileDurable(path, &buffer, 1u);
+	}
+}
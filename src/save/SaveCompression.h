@@ -0,0 +1,325 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../core/Clock.h"
+#include "../core/Lz4.h"
+#include "../threading/Sys_JobSystem.h"
+
+#include "SaveContainer.h"
+#include "SaveIOQueue.h"
+#include "SaveTypes.h"
+
+/*
+ * Compression stage between the save payload and the container.
+ *
+ * The payload is cut into blocks that are LZ4 compressed independently, so both directions can run in parallel on
+ * the job system. Stored layout behind the container header:
+ *
+ *   [uint32_t block sizes (blockCount)][block 0][block 1]...
+ *
+ * A block that doesn't shrink is stored raw and flagged with RAW_BLOCK_FLAG in its size. Small payloads, data
+ * whose first block barely compresses and results that don't save enough overall are written uncompressed
+ * (codec NONE), so incompressible saves only pay for compressing a single block.
+ */
+namespace SaveData
+{
+	constexpr uint32_t SAVE_COMPRESSION_BLOCK_SIZE = 256u * 1024u;
+	constexpr size_t MIN_COMPRESSED_SAVE_SIZE = 4096u;
+	constexpr uint32_t RAW_BLOCK_FLAG = 0x80000000u;
+	// compression has to cut at least this percentage of the size, otherwise the payload is stored raw
+	constexpr size_t MIN_COMPRESSION_SAVING_PERCENT = 10u;
+	constexpr uint32_t MAX_COMPRESSION_JOBS = 64u;
+
+	enum class BlockExecution
+	{
+		// spread over the job workers, the caller waits and must not hold a lock that a job may take
+		JOBS,
+		// all blocks on the calling thread, for callers that hold the save system's file mutex
+		CALLING_THREAD,
+	};
+
+	/*
+	 * Not thread-safe, every compressor of the save system is guarded by one of its mutexes. The stats may be read
+	 * anytime.
+	 */
+	class SaveCompressor
+	{
+	public:
+		explicit SaveCompressor(BlockExecution execution)
+			: m_Execution(execution) {}
+
+		/*
+		 * Compression is on by default, disabled saves are written uncompressed. Loading handles both
+		 */
+		void SetEnabled(bool enabled) {
+			m_IsEnabled.store(enabled, std::memory_order_relaxed);
+		}
+
+		/*
+		 * Returns the header for the bytes to store, `stored` either points at the payload or into the
+		 * compressor's buffer (valid until the next Encode)
+		 */
+		SaveContainerHeader Encode(const SaveFile& save, SaveFile& stored) {
+			stored = save;
+			if (!m_IsEnabled.load(std::memory_order_relaxed) || save.length < MIN_COMPRESSED_SAVE_SIZE) {
+				return MakeSaveContainerHeader(save);
+			}
+
+			const Clock::Cycles start = Clock::QueryCycles();
+			m_Codec = CodecType::COMPRESS;
+			m_Source = save.data;
+			m_SourceLength = save.length;
+			m_BlockCount = (save.length + SAVE_COMPRESSION_BLOCK_SIZE - 1u) / SAVE_COMPRESSION_BLOCK_SIZE;
+
+			// every block gets a worst case sized slot, so the jobs don't depend on each other
+			const size_t tableSize = m_BlockCount * sizeof(uint32_t);
+			const size_t slotSize = Lz4::CompressBound(SAVE_COMPRESSION_BLOCK_SIZE);
+			m_Buffer.resize(tableSize + m_BlockCount * slotSize);
+			m_BlockSizes.resize(m_BlockCount);
+
+			// the first block tells whether compressing this payload pays off at all
+			ProcessBlocks(0u, 1u);
+			if (!PaysOff(m_BlockSizes[0] & ~RAW_BLOCK_FLAG, GetBlockLength(0u))) {
+				return Bypass(save, start);
+			}
+
+			RunBlocks(1u, m_BlockCount);
+
+			// close the gaps between the slots
+			size_t storedLength = tableSize;
+			for (size_t block = 0u; block < m_BlockCount; ++block) {
+				const size_t size = m_BlockSizes[block] & ~RAW_BLOCK_FLAG;
+				memmove(m_Buffer.data() + storedLength, m_Buffer.data() + tableSize + block * slotSize, size);
+				storedLength += size;
+			}
+			memcpy(m_Buffer.data(), m_BlockSizes.data(), tableSize);
+
+			if (!PaysOff(storedLength, save.length)) {
+				return Bypass(save, start);
+			}
+
+			stored.data = m_Buffer.data();
+			stored.length = storedLength;
+
+			m_CompressedSaves.fetch_add(1u, std::memory_order_relaxed);
+			m_CompressionInputBytes.fetch_add(save.length, std::memory_order_relaxed);
+			m_CompressionOutputBytes.fetch_add(storedLength, std::memory_order_relaxed);
+			m_CompressionTime.fetch_add(Clock::ToDuration(Clock::QueryCycles() - start).ToNanoseconds(), std::memory_order_relaxed);
+
+			return MakeSaveContainerHeader(stored, save.length, SaveCodec::LZ4_BLOCKS, SAVE_COMPRESSION_BLOCK_SIZE);
+		}
+
+		/*
+		 * Restores the payload of a validated container into `payload`
+		 */
+		bool Decode(const SaveContainerHeader& header, const SaveFile& stored, std::vector<byte>& payload) {
+			if (header.codec == SaveCodec::NONE) {
+				payload.assign(stored.data, stored.data + stored.length);
+				return true;
+			}
+			if (header.codec != SaveCodec::LZ4_BLOCKS || header.blockSize == 0u || header.payloadLength == 0u) {
+				return false;
+			}
+
+			const Clock::Cycles start = Clock::QueryCycles();
+			const size_t blockSize = header.blockSize;
+			const size_t payloadLength = static_cast<size_t>(header.payloadLength);
+			const size_t blockCount = (payloadLength + blockSize - 1u) / blockSize;
+			const size_t tableSize = blockCount * sizeof(uint32_t);
+			if (blockCount == 0u || stored.length < tableSize) {
+				return false;
+			}
+
+			m_BlockSizes.resize(blockCount);
+			memcpy(m_BlockSizes.data(), stored.data, tableSize);
+
+			// the table has to describe the stored bytes exactly
+			m_BlockOffsets.resize(blockCount);
+			size_t offset = tableSize;
+			for (size_t block = 0u; block < blockCount; ++block) {
+				const size_t size = m_BlockSizes[block] & ~RAW_BLOCK_FLAG;
+				const size_t length = block + 1u < blockCount ? blockSize : payloadLength - block * blockSize;
+				const bool isRaw = (m_BlockSizes[block] & RAW_BLOCK_FLAG) != 0u;
+				if ((isRaw && size != length) || size > stored.length - offset) {
+					return false;
+				}
+				m_BlockOffsets[block] = offset;
+				offset += size;
+			}
+			if (offset != stored.length) {
+				return false;
+			}
+
+			payload.resize(payloadLength);
+
+			m_Codec = CodecType::DECOMPRESS;
+			m_Source = stored.data;
+			m_SourceLength = payloadLength;
+			m_BlockCount = blockCount;
+			m_DecodeBlockSize = blockSize;
+			m_Target = payload.data();
+			m_HasFailed.store(false, std::memory_order_relaxed);
+
+			RunBlocks(0u, blockCount);
+
+			if (m_HasFailed.load(std::memory_order_relaxed)) {
+				return false;
+			}
+
+			m_DecompressedBytes.fetch_add(payloadLength, std::memory_order_relaxed);
+			m_DecompressionTime.fetch_add(Clock::ToDuration(Clock::QueryCycles() - start).ToNanoseconds(), std::memory_order_relaxed);
+			return true;
+		}
+
+		/*
+		 * Adds this compressor's numbers, so the stats of several compressors sum up
+		 */
+		void AddStats(SaveStats& stats) const {
+			stats.compressedSaves += m_CompressedSaves.load(std::memory_order_relaxed);
+			stats.bypassedCompressions += m_BypassedCompressions.load(std::memory_order_relaxed);
+			stats.compressionInputBytes += m_CompressionInputBytes.load(std::memory_order_relaxed);
+			stats.compressionOutputBytes += m_CompressionOutputBytes.load(std::memory_order_relaxed);
+			stats.compressionTime += Duration::FromNanoseconds(m_CompressionTime.load(std::memory_order_relaxed));
+			stats.decompressedBytes += m_DecompressedBytes.load(std::memory_order_relaxed);
+			stats.decompressionTime += Duration::FromNanoseconds(m_DecompressionTime.load(std::memory_order_relaxed));
+		}
+
+	private:
+		enum class CodecType
+		{
+			COMPRESS,
+			DECOMPRESS,
+		};
+
+		struct BlockRange
+		{
+			SaveCompressor* compressor = nullptr;
+			size_t first = 0u;
+			size_t last = 0u;
+		};
+
+		static bool PaysOff(size_t storedLength, size_t length) {
+			return storedLength * 100u <= length * (100u - MIN_COMPRESSION_SAVING_PERCENT);
+		}
+
+		size_t GetBlockLength(size_t block) const {
+			const size_t blockSize = m_Codec == CodecType::COMPRESS ? SAVE_COMPRESSION_BLOCK_SIZE : m_DecodeBlockSize;
+			const size_t offset = block * blockSize;
+			return m_SourceLength - offset < blockSize ? m_SourceLength - offset : blockSize;
+		}
+
+		SaveContainerHeader Bypass(const SaveFile& save, Clock::Cycles start) {
+			m_BypassedCompressions.fetch_add(1u, std::memory_order_relaxed);
+			m_CompressionTime.fetch_add(Clock::ToDuration(Clock::QueryCycles() - start).ToNanoseconds(), std::memory_order_relaxed);
+			return MakeSaveContainerHeader(save);
+		}
+
+		/*
+		 * Spreads the blocks over up to MAX_COMPRESSION_JOBS jobs and waits for them. A pool worker runs other
+		 * queued jobs while it waits, a thread outside of the pool (the save I/O worker) only yields
+		 */
+		void RunBlocks(size_t first, size_t last) {
+			const size_t blockCount = last - first;
+			if (blockCount == 0u) {
+				return;
+			}
+
+			const size_t jobCount = blockCount < MAX_COMPRESSION_JOBS ? blockCount : MAX_COMPRESSION_JOBS;
+			if (jobCount == 1u || m_Execution == BlockExecution::CALLING_THREAD) {
+				ProcessBlocks(first, last);
+				return;
+			}
+
+			BlockRange ranges[MAX_COMPRESSION_JOBS];
+			jobHandle_t jobs[MAX_COMPRESSION_JOBS];
+			for (size_t i = 0u; i < jobCount; ++i) {
+				ranges[i].compressor = this;
+				ranges[i].first = first + blockCount * i / jobCount;
+				ranges[i].last = first + blockCount * (i + 1u) / jobCount;
+				jobs[i] = Sys_CreateJob(BlockJob, &ranges[i]);
+				Sys_RunJob(jobs[i]);
+			}
+
+			for (size_t i = 0u; i < jobCount; ++i) {
+				Sys_WaitForJob(jobs[i]);
+			}
+		}
+
+		static void BlockJob(void* params) {
+			const BlockRange* range = static_cast<const BlockRange*>(params);
+			range->compressor->ProcessBlocks(range->first, range->last);
+		}
+
+		void ProcessBlocks(size_t first, size_t last) {
+			for (size_t block = first; block < last; ++block) {
+				if (m_Codec == CodecType::COMPRESS) {
+					CompressBlock(block);
+				}
+				else {
+					DecompressBlock(block);
+				}
+			}
+		}
+
+		void CompressBlock(size_t block) {
+			const size_t tableSize = m_BlockCount * sizeof(uint32_t);
+			const size_t slotSize = Lz4::CompressBound(SAVE_COMPRESSION_BLOCK_SIZE);
+			const byte* source = m_Source + block * SAVE_COMPRESSION_BLOCK_SIZE;
+			const size_t length = GetBlockLength(block);
+			byte* slot = m_Buffer.data() + tableSize + block * slotSize;
+
+			const size_t size = Lz4::Compress(source, length, slot, length - 1u);
+			if (size == 0u) {
+				memcpy(slot, source, length);
+				m_BlockSizes[block] = static_cast<uint32_t>(length) | RAW_BLOCK_FLAG;
+			}
+			else {
+				m_BlockSizes[block] = static_cast<uint32_t>(size);
+			}
+		}
+
+		void DecompressBlock(size_t block) {
+			const size_t size = m_BlockSizes[block] & ~RAW_BLOCK_FLAG;
+			const size_t length = GetBlockLength(block);
+			const byte* source = m_Source + m_BlockOffsets[block];
+			byte* target = m_Target + block * m_DecodeBlockSize;
+
+			if ((m_BlockSizes[block] & RAW_BLOCK_FLAG) != 0u) {
+				memcpy(target, source, length);
+			}
+			else if (!Lz4::Decompress(source, size, target, length)) {
+				m_HasFailed.store(true, std::memory_order_relaxed);
+			}
+		}
+
+		const BlockExecution m_Execution;
+		std::atomic<bool> m_IsEnabled { true };
+
+		// state of the running Encode / Decode, read by the jobs
+		CodecType m_Codec = CodecType::COMPRESS;
+		const byte* m_Source = nullptr;
+		// uncompressed length
+		size_t m_SourceLength = 0u;
+		size_t m_BlockCount = 0u;
+		size_t m_DecodeBlockSize = 0u;
+		byte* m_Target = nullptr;
+		std::atomic<bool> m_HasFailed { false };
+
+		std::vector<byte> m_Buffer;
+		std::vector<uint32_t> m_BlockSizes;
+		std::vector<size_t> m_BlockOffsets;
+
+		std::atomic<uint64_t> m_CompressedSaves { 0u };
+		std::atomic<uint64_t> m_BypassedCompressions { 0u };
+		std::atomic<uint64_t> m_CompressionInputBytes { 0u };
+		std::atomic<uint64_t> m_CompressionOutputBytes { 0u };
+		std::atomic<int64_t> m_CompressionTime { 0 };
+		std::atomic<uint64_t> m_DecompressedBytes { 0u };
+		std::atomic<int64_t> m_DecompressionTime { 0 };
+	};
+}
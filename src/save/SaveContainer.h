@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../core/Crc32c.h"
+
+#include "SaveTypes.h"
+
+/*
+ * On-disk container around a SaveFile payload:
+ *
+ *   [SaveContainerHeader][stored payload bytes]
+ *
+ * The header carries a magic, the schema version, its own size (so newer versions can append fields while old
+ * files stay readable), the payload length and CRC32C checksums of the stored bytes and of the header itself.
+ * Torn writes, truncation and bit rot all fail validation, which makes Load fall back to the backup.
+ *
+ * Version 2 appends the codec the payload is stored with (see SaveCompression.h). Version 1 files (24 byte
+ * header) are always stored uncompressed.
+ */
+namespace SaveData
+{
+	constexpr uint32_t SAVE_CONTAINER_MAGIC = 0x53444D4Du; // "MMDS"
+	constexpr uint16_t SAVE_CONTAINER_VERSION = 2u;
+	constexpr uint16_t SAVE_CONTAINER_V1_HEADER_SIZE = 24u;
+
+	enum class SaveCodec : uint16_t
+	{
+		NONE = 0u,
+		LZ4_BLOCKS = 1u,
+	};
+
+	struct SaveContainerHeader
+	{
+		uint32_t magic = SAVE_CONTAINER_MAGIC;
+		uint16_t version = SAVE_CONTAINER_VERSION;
+		uint16_t headerSize = sizeof(SaveContainerHeader);
+		// uncompressed size
+		uint64_t payloadLength = 0u;
+		// checksum over the stored bytes
+		uint32_t payloadCrc = 0u;
+		// checksum over all other header bytes
+		uint32_t headerCrc = 0u;
+
+		// version 2
+		SaveCodec codec = SaveCodec::NONE;
+		uint16_t reserved = 0u;
+		// uncompressed size of the independently compressed blocks
+		uint32_t blockSize = 0u;
+		uint64_t storedLength = 0u;
+	};
+
+	static_assert(sizeof(SaveContainerHeader) == 40u, "SaveContainerHeader is part of the file format, keep it packed");
+
+	enum class SaveContainerError
+	{
+		NONE,
+		TRUNCATED,
+		BAD_MAGIC,
+		UNSUPPORTED_VERSION,
+		HEADER_CORRUPTED,
+		PAYLOAD_CORRUPTED,
+		UNSUPPORTED_CODEC,
+	};
+
+	const char* ToString(SaveContainerError error) {
+		switch (error) {
+		case SaveContainerError::NONE: return "none";
+		case SaveContainerError::TRUNCATED: return "file is truncated";
+		case SaveContainerError::BAD_MAGIC: return "not a save file";
+		case SaveContainerError::UNSUPPORTED_VERSION: return "unsupported save version";
+		case SaveContainerError::HEADER_CORRUPTED: return "header checksum mismatch";
+		case SaveContainerError::PAYLOAD_CORRUPTED: return "payload checksum mismatch";
+		case SaveContainerError::UNSUPPORTED_CODEC: return "unsupported compression";
+		default: return "unknown";
+		}
+	}
+
+	uint32_t ComputeHeaderCrc(const SaveContainerHeader& header) {
+		const size_t crcEnd = offsetof(SaveContainerHeader, headerCrc) + sizeof(header.headerCrc);
+		const size_t headerSize = header.headerSize < sizeof(header) ? header.headerSize : sizeof(header);
+
+		const uint32_t crc = Crc32c::Compute(&header, offsetof(SaveContainerHeader, headerCrc));
+		return headerSize > crcEnd ? Crc32c::Update(crc, reinterpret_cast<const byte*>(&header) + crcEnd, headerSize - crcEnd) : crc;
+	}
+
+	/*
+	 * Builds the header that has to be written in front of the stored bytes
+	 */
+	SaveContainerHeader MakeSaveContainerHeader(const SaveFile& stored, size_t payloadLength, SaveCodec codec, uint32_t blockSize) {
+		SaveContainerHeader header;
+		header.payloadLength = payloadLength;
+		header.payloadCrc = Crc32c::Compute(stored.data, stored.length);
+		header.codec = codec;
+		header.blockSize = blockSize;
+		header.storedLength = stored.length;
+		header.headerCrc = ComputeHeaderCrc(header);
+		return header;
+	}
+
+	SaveContainerHeader MakeSaveContainerHeader(const SaveFile& save) {
+		return MakeSaveContainerHeader(save, save.length, SaveCodec::NONE, 0u);
+	}
+
+	/*
+	 * Validates only the header (magic, version, header checksum and codec), the stored bytes aren't touched.
+	 * Enough to read a save's metadata, `data` has to cover at least the header.
+	 */
+	SaveContainerError ValidateSaveContainerHeader(const byte* data, size_t size, SaveContainerHeader& header) {
+		header = SaveContainerHeader();
+		if (size < SAVE_CONTAINER_V1_HEADER_SIZE) {
+			return SaveContainerError::TRUNCATED;
+		}
+		memcpy(static_cast<void*>(&header), data, SAVE_CONTAINER_V1_HEADER_SIZE);
+
+		if (header.magic != SAVE_CONTAINER_MAGIC) {
+			return SaveContainerError::BAD_MAGIC;
+		}
+
+		const size_t knownHeaderSize = header.version >= 2u ? sizeof(header) : SAVE_CONTAINER_V1_HEADER_SIZE;
+		if (header.version == 0u || header.version > SAVE_CONTAINER_VERSION || header.headerSize < knownHeaderSize) {
+			return SaveContainerError::UNSUPPORTED_VERSION;
+		}
+		if (header.headerSize > size) {
+			return SaveContainerError::TRUNCATED;
+		}
+
+		if (header.version >= 2u) {
+			memcpy(&header, data, sizeof(header));
+		}
+		else {
+			header.storedLength = header.payloadLength;
+		}
+
+		if (header.headerCrc != ComputeHeaderCrc(header)) {
+			return SaveContainerError::HEADER_CORRUPTED;
+		}
+		if (header.codec != SaveCodec::NONE && header.codec != SaveCodec::LZ4_BLOCKS) {
+			return SaveContainerError::UNSUPPORTED_CODEC;
+		}
+		return SaveContainerError::NONE;
+	}
+
+	/*
+	 * Validates a complete container in memory (typically a mapped file) in a single pass over the stored bytes.
+	 * On success `stored` points into `data`; it is the payload itself unless the header names a codec.
+	 */
+	SaveContainerError ValidateSaveContainer(const byte* data, size_t size, SaveContainerHeader& header, SaveFile& stored) {
+		const SaveContainerError error = ValidateSaveContainerHeader(data, size, header);
+		if (error != SaveContainerError::NONE) {
+			return error;
+		}
+		if (header.storedLength > size - header.headerSize || (header.codec == SaveCodec::NONE && header.storedLength != header.payloadLength)) {
+			return SaveContainerError::TRUNCATED;
+		}
+
+		const byte* storedData = data + header.headerSize;
+		const size_t storedLength = static_cast<size_t>(header.storedLength);
+		if (Crc32c::Compute(storedData, storedLength) != header.payloadCrc) {
+			return SaveContainerError::PAYLOAD_CORRUPTED;
+		}
+
+		stored.data = const_cast<byte*>(storedData);
+		stored.length = storedLength;
+		return SaveContainerError::NONE;
+	}
+}
@@ -0,0 +1,498 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "../core/Clock.h"
+#include "../core/SpscQueue.h"
+#include "../threading/Sys_JobSystem.h"
+#include "../threading/Sys_Threading.h"
+
+#include "SaveTypes.h"
+
+namespace SaveData
+{
+	typedef uint32_t SaveHandle;
+	constexpr SaveHandle INVALID_SAVE_HANDLE = 0u;
+	// including the terminator
+	constexpr size_t MAX_SAVE_NAME_LENGTH = 64u;
+
+	enum class SaveStatus
+	{
+		UNKNOWN,		// invalid handle, or the request is so old its slot got reused
+		PENDING,		// queued, the I/O worker didn't pick it up yet
+		WRITING,
+		SUCCEEDED,
+		FAILED,
+		SUPERSEDED,		// a newer snapshot of the same slot replaced the payload before it was written
+	};
+
+	/*
+	 * Invoked on the game thread (from SaveSystem::Update) once per request: SUCCEEDED or FAILED after the I/O
+	 * worker finished it, SUPERSEDED when a newer request of the slot took its place in the queue
+	 */
+	typedef void (*SaveCallback)(SaveHandle handle, SaveStatus status, void* userData);
+
+	struct SaveStats
+	{
+		uint64_t requestedSaves = 0u;
+		// requests that were replaced by a newer snapshot of the same slot before they hit the disk
+		uint64_t coalescedSaves = 0u;
+		uint64_t physicalWrites = 0u;
+		uint64_t failedWrites = 0u;
+		// filled in by the save system: full snapshots vs. journal appends, and the bytes that went to the disk
+		uint64_t snapshotWrites = 0u;
+		uint64_t deltaWrites = 0u;
+		uint64_t bytesWritten = 0u;
+		// compression of full saves: stored compressed vs. written raw because it didn't pay off
+		uint64_t compressedSaves = 0u;
+		uint64_t bypassedCompressions = 0u;
+		uint64_t compressionInputBytes = 0u;
+		uint64_t compressionOutputBytes = 0u;
+		// includes the attempts that were bypassed
+		Duration compressionTime;
+		uint64_t decompressedBytes = 0u;
+		Duration decompressionTime;
+	};
+
+	/*
+	 * Runs the blocking save I/O of a SaveSystem on a background worker thread.
+	 *
+	 * Submit copies the payload into a pooled buffer and returns right away. The worker calls the system's
+	 * synchronous Save for each request in order. Results go back to the game thread through a lock-free queue
+	 * and are dispatched to the callbacks in DispatchCompletions. The status of a handle can be polled at any
+	 * time without locking. Statuses live in STATUS_SLOTS slots indexed by handle, a new handle takes over its slot
+	 * and the worker only updates a slot that still belongs to the handle it finished.
+	 *
+	 * Saves are coalesced per slot (file name): while a request for a slot is still queued, a newer snapshot
+	 * replaces its payload instead of queueing a second write, and a slot is not written more often than the
+	 * minimum write interval. A replaced request completes right away as SUPERSEDED, so every write reports one
+	 * request no matter how many snapshots it absorbed.
+	 *
+	 * Requests live in a fixed pool of MAX_PENDING_SAVES slots. A slot keeps its payload buffer when it's released,
+	 * so once every slot saw its largest save, submitting never allocates. Completions go through two fixed rings,
+	 * one filled by the worker and one by Submit for the superseded requests.
+	 *
+	 * SaveSystemT has to provide `bool Save(const SaveFile&, const char*)`, which serializes itself with the
+	 * system's other file operations through GetFileMutex.
+	 */
+	template <typename SaveSystemT>
+	class SaveIOQueue
+	{
+	public:
+		static constexpr uint32_t STATUS_SLOTS = 64u;
+		static constexpr uint32_t MAX_COMPLETIONS = 256u;
+		// distinct slots that are queued at the same time, and slots whose last write time is remembered
+		static constexpr uint32_t MAX_PENDING_SAVES = 32u;
+
+		explicit SaveIOQueue(SaveSystemT* system)
+			: m_System(system) {}
+
+		~SaveIOQueue() {
+			Stop();
+		}
+
+		void Start() {
+			if (m_IsRunning) {
+				return;
+			}
+
+			m_IsRunning.store(true);
+			m_IsWorkerFinished.store(false);
+
+			threadCreateParam_t params;
+			params.function = WorkerMain;
+			params.params = this;
+			params.name = "SaveIO";
+			// latency doesn't matter for writes, never take the core from the game or input thread
+			params.priority = threadPriority_t::LOW;
+			m_Thread = Sys_CreateThread(params);
+		}
+
+		/*
+		 * Game thread - finishes all queued requests, joins the worker and dispatches every completion that is
+		 * left, so no callback gets lost. Runs queued jobs meanwhile, the last writes may wait for their
+		 * compression jobs and the game thread can be the only job worker
+		 */
+		void Stop() {
+			if (!m_IsRunning) {
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_RequestMutex);
+				m_IsRunning.store(false);
+			}
+			m_RequestCondition.notify_one();
+
+			// the worker waits while the completion ring is full, keep draining it until the worker is done
+			while (!m_IsWorkerFinished.load(std::memory_order_acquire)) {
+				DispatchCompletions();
+				if (!Sys_ExecuteJob(1000u)) {
+					Sys_Yield();
+				}
+			}
+
+			Sys_WaitForThread(m_Thread);
+			Sys_DestroyThread(m_Thread);
+			m_Thread = INVALID_THREAD_HANDLE;
+
+			DispatchCompletions();
+		}
+
+		/*
+		 * Game thread - queues a copy of the payload, never touches the disk. Returns INVALID_SAVE_HANDLE when
+		 * the name is too long, MAX_PENDING_SAVES different slots are queued already or MAX_COMPLETIONS superseded
+		 * requests wait for DispatchCompletions
+		 */
+		SaveHandle Submit(const SaveFile& save, const char* name, SaveCallback callback, void* userData) {
+			if (strlen(name) >= MAX_SAVE_NAME_LENGTH) {
+				return INVALID_SAVE_HANDLE;
+			}
+
+			SaveHandle handle = INVALID_SAVE_HANDLE;
+			{
+				std::lock_guard<std::mutex> lock(m_RequestMutex);
+
+				Request* request = FindRequest(RequestState::QUEUED, name);
+				const bool isCoalesced = request != nullptr;
+				if (isCoalesced) {
+					// a coalesced snapshot replaces the older one, which never reaches the disk
+					Completion completion;
+					completion.handle = request->handle;
+					completion.status = SaveStatus::SUPERSEDED;
+					completion.callback = request->callback;
+					completion.userData = request->userData;
+					if (!m_SupersededCompletions.TryPush(completion)) {
+						return INVALID_SAVE_HANDLE;
+					}
+					SetStatus(request->handle, SaveStatus::SUPERSEDED);
+				}
+				else {
+					request = FindRequest(RequestState::FREE, nullptr);
+					if (request == nullptr) {
+						return INVALID_SAVE_HANDLE;
+					}
+
+					strcpy(request->name, name);
+					request->sequence = m_NextSequence++;
+					request->state = RequestState::QUEUED;
+					++m_QueuedRequests;
+				}
+
+				handle = NextHandle();
+				ClaimStatus(handle, SaveStatus::PENDING);
+				m_RequestedSaves.fetch_add(1u, std::memory_order_relaxed);
+
+				request->payload.assign(save.data, save.data + save.length);
+				request->handle = handle;
+				request->callback = callback;
+				request->userData = userData;
+
+				if (isCoalesced) {
+					m_CoalescedSaves.fetch_add(1u, std::memory_order_relaxed);
+					return handle;
+				}
+			}
+			m_RequestCondition.notify_one();
+
+			return handle;
+		}
+
+		/*
+		 * A slot is written at most once per interval, newer snapshots wait (and coalesce) in the queue meanwhile
+		 */
+		void SetMinWriteInterval(Duration interval) {
+			{
+				std::lock_guard<std::mutex> lock(m_RequestMutex);
+				m_MinWriteInterval = interval;
+			}
+			m_RequestCondition.notify_one();
+		}
+
+		SaveStats GetStats() const {
+			SaveStats stats;
+			stats.requestedSaves = m_RequestedSaves.load(std::memory_order_relaxed);
+			stats.coalescedSaves = m_CoalescedSaves.load(std::memory_order_relaxed);
+			stats.physicalWrites = m_PhysicalWrites.load(std::memory_order_relaxed);
+			stats.failedWrites = m_FailedWrites.load(std::memory_order_relaxed);
+			return stats;
+		}
+
+		/*
+		 * Any thread - lock-free status lookup
+		 */
+		SaveStatus GetStatus(SaveHandle handle) const {
+			const uint64_t slot = m_Statuses[handle % STATUS_SLOTS].load(std::memory_order_acquire);
+			if (handle == INVALID_SAVE_HANDLE || SlotHandle(slot) != handle) {
+				return SaveStatus::UNKNOWN;
+			}
+			return static_cast<SaveStatus>(slot & 0xFFFFFFFFu);
+		}
+
+		/*
+		 * Game thread - invokes the callbacks of all requests that finished or were superseded since the last call
+		 */
+		void DispatchCompletions() {
+			Completion completion;
+			while (m_SupersededCompletions.TryPop(completion)) {
+				Dispatch(completion);
+			}
+			while (m_Completions.TryPop(completion)) {
+				Dispatch(completion);
+			}
+		}
+
+		/*
+		 * Serializes the worker's writes (Save) with synchronous operations (Load) of the save system
+		 */
+		std::mutex& GetFileMutex() {
+			return m_FileMutex;
+		}
+
+	private:
+		enum class RequestState
+		{
+			FREE,
+			QUEUED,
+			// owned by the worker until the write finished
+			WRITING,
+		};
+
+		struct Request
+		{
+			RequestState state = RequestState::FREE;
+			char name[MAX_SAVE_NAME_LENGTH] = {};
+			// submission order, the oldest ready request is written first
+			uint64_t sequence = 0u;
+			// keeps its capacity while the slot is free
+			std::vector<byte> payload;
+			// the newest request of the slot, the ones it replaced completed as SUPERSEDED
+			SaveHandle handle = INVALID_SAVE_HANDLE;
+			SaveCallback callback = nullptr;
+			void* userData = nullptr;
+		};
+
+		struct LastWrite
+		{
+			char name[MAX_SAVE_NAME_LENGTH] = {};
+			TimePoint time;
+		};
+
+		struct Completion
+		{
+			SaveHandle handle = INVALID_SAVE_HANDLE;
+			SaveStatus status = SaveStatus::UNKNOWN;
+			SaveCallback callback = nullptr;
+			void* userData = nullptr;
+		};
+
+		static void Dispatch(const Completion& completion) {
+			if (completion.callback != nullptr) {
+				completion.callback(completion.handle, completion.status, completion.userData);
+			}
+		}
+
+		SaveHandle NextHandle() {
+			++m_LastHandle;
+			if (m_LastHandle == INVALID_SAVE_HANDLE) {
+				++m_LastHandle;
+			}
+			return m_LastHandle;
+		}
+
+		/*
+		 * A status slot holds the handle in the upper and its status in the lower half, so both change together
+		 */
+		static uint64_t MakeSlot(SaveHandle handle, SaveStatus status) {
+			return (static_cast<uint64_t>(handle) << 32u) | static_cast<uint32_t>(status);
+		}
+
+		static SaveHandle SlotHandle(uint64_t slot) {
+			return static_cast<SaveHandle>(slot >> 32u);
+		}
+
+		/*
+		 * Game thread - a new handle takes over its slot
+		 */
+		void ClaimStatus(SaveHandle handle, SaveStatus status) {
+			m_Statuses[handle % STATUS_SLOTS].store(MakeSlot(handle, status), std::memory_order_release);
+		}
+
+		/*
+		 * Any thread - leaves the slot alone once a newer handle claimed it, the old request then reads as UNKNOWN
+		 */
+		void SetStatus(SaveHandle handle, SaveStatus status) {
+			std::atomic<uint64_t>& slot = m_Statuses[handle % STATUS_SLOTS];
+			uint64_t current = slot.load(std::memory_order_relaxed);
+			while (SlotHandle(current) == handle
+				&& !slot.compare_exchange_weak(current, MakeSlot(handle, status), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			}
+		}
+
+		static void WorkerMain(void* params) {
+			SaveIOQueue* queue = static_cast<SaveIOQueue*>(params);
+			queue->Run();
+			queue->m_IsWorkerFinished.store(true, std::memory_order_release);
+		}
+
+		/*
+		 * The request in `state` with the name, any request in that state for nullptr (request mutex held)
+		 */
+		Request* FindRequest(RequestState state, const char* name) {
+			for (Request& request : m_Requests) {
+				if (request.state == state && (name == nullptr || strcmp(request.name, name) == 0)) {
+					return &request;
+				}
+			}
+			return nullptr;
+		}
+
+		/*
+		 * The remembered write of the slot, or the entry to overwrite for it (a free or the oldest one)
+		 */
+		LastWrite& FindLastWrite(const char* name) {
+			LastWrite* oldest = &m_LastWrites[0];
+			for (LastWrite& lastWrite : m_LastWrites) {
+				if (strcmp(lastWrite.name, name) == 0) {
+					return lastWrite;
+				}
+				if (lastWrite.name[0] == '\0' || (oldest->name[0] != '\0' && lastWrite.time < oldest->time)) {
+					oldest = &lastWrite;
+				}
+			}
+			return *oldest;
+		}
+
+		/*
+		 * Picks the oldest request whose slot may be written again, or tells how long to wait for one
+		 */
+		Request* TakeReadyRequest(Duration& waitTime) {
+			const TimePoint now = Clock::Now();
+			const bool ignoreInterval = !m_IsRunning.load();
+			waitTime = Duration::FromSeconds(1);
+
+			Request* ready = nullptr;
+			for (Request& request : m_Requests) {
+				if (request.state != RequestState::QUEUED || (ready != nullptr && ready->sequence < request.sequence)) {
+					continue;
+				}
+
+				const LastWrite& lastWrite = FindLastWrite(request.name);
+				const TimePoint earliest = strcmp(lastWrite.name, request.name) == 0 ? lastWrite.time + m_MinWriteInterval : now;
+
+				if (ignoreInterval || earliest <= now) {
+					ready = &request;
+				}
+				else if (earliest - now < waitTime) {
+					waitTime = earliest - now;
+				}
+			}
+
+			if (ready != nullptr) {
+				ready->state = RequestState::WRITING;
+				--m_QueuedRequests;
+			}
+			return ready;
+		}
+
+		void Run() {
+			for (;;) {
+				Request* request = nullptr;
+				{
+					std::unique_lock<std::mutex> lock(m_RequestMutex);
+					for (;;) {
+						if (m_QueuedRequests == 0u) {
+							if (!m_IsRunning) {
+								return;
+							}
+							m_RequestCondition.wait(lock);
+							continue;
+						}
+
+						Duration waitTime;
+						request = TakeReadyRequest(waitTime);
+						if (request != nullptr) {
+							break;
+						}
+						m_RequestCondition.wait_for(lock, std::chrono::nanoseconds(waitTime.ToNanoseconds()));
+					}
+				}
+
+				// Submit leaves WRITING requests alone, so the payload and handle are read without the lock
+				SetStatus(request->handle, SaveStatus::WRITING);
+
+				SaveFile save;
+				save.data = request->payload.data();
+				save.length = request->payload.size();
+
+				const bool succeeded = m_System->Save(save, request->name);
+
+				m_PhysicalWrites.fetch_add(1u, std::memory_order_relaxed);
+				if (!succeeded) {
+					m_FailedWrites.fetch_add(1u, std::memory_order_relaxed);
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_RequestMutex);
+					LastWrite& lastWrite = FindLastWrite(request->name);
+					strcpy(lastWrite.name, request->name);
+					lastWrite.time = Clock::Now();
+				}
+
+				Completion completion;
+				completion.handle = request->handle;
+				completion.status = succeeded ? SaveStatus::SUCCEEDED : SaveStatus::FAILED;
+				completion.callback = request->callback;
+				completion.userData = request->userData;
+				SetStatus(completion.handle, completion.status);
+
+				// one entry per write and the game thread drains them every frame, so this only fills up if nobody
+				// calls Update. Stop keeps draining while it waits for the worker
+				while (!m_Completions.TryPush(completion)) {
+					Sys_Sleep(1000u);
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_RequestMutex);
+					request->state = RequestState::FREE;
+				}
+			}
+		}
+
+		SaveSystemT* m_System;
+		threadHandle_t m_Thread = INVALID_THREAD_HANDLE;
+		std::atomic<bool> m_IsRunning { false };
+		std::atomic<bool> m_IsWorkerFinished { false };
+
+		std::mutex m_RequestMutex;
+		std::condition_variable m_RequestCondition;
+		Request m_Requests[MAX_PENDING_SAVES];
+		// requests in the QUEUED state
+		uint32_t m_QueuedRequests = 0u;
+		uint64_t m_NextSequence = 0u;
+		LastWrite m_LastWrites[MAX_PENDING_SAVES];
+		Duration m_MinWriteInterval;
+
+		std::mutex m_FileMutex;
+
+		std::atomic<uint64_t> m_RequestedSaves { 0u };
+		std::atomic<uint64_t> m_CoalescedSaves { 0u };
+		std::atomic<uint64_t> m_PhysicalWrites { 0u };
+		std::atomic<uint64_t> m_FailedWrites { 0u };
+
+		// game thread only
+		SaveHandle m_LastHandle = INVALID_SAVE_HANDLE;
+
+		// see MakeSlot, zero is INVALID_SAVE_HANDLE / UNKNOWN
+		std::atomic<uint64_t> m_Statuses[STATUS_SLOTS] = {};
+		// written by the worker / by Submit, both read by DispatchCompletions
+		SpscQueue<Completion, MAX_COMPLETIONS> m_Completions;
+		SpscQueue<Completion, MAX_COMPLETIONS> m_SupersededCompletions;
+	};
+}
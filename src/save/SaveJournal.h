@@ -0,0 +1,373 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdio.h>
+#include <vector>
+
+#include "../core/Crc32c.h"
+#include "../core/Hash64.h"
+
+#include "MappedFile.h"
+#include "SaveArena.h"
+#include "SaveCommit.h"
+#include "SaveTypes.h"
+
+/*
+ * Delta saves for large save states on plain file systems (PC / Linux).
+ *
+ * A slot consists of the base snapshot `<name>` (a regular save container) and the journal `<name>.journal`:
+ *
+ *   [SaveJournalHeader][SaveJournalRecord + chunk indices + chunk data]...
+ *
+ * The payload is split into fixed-size chunks that are hashed on every save. Only the chunks that changed since
+ * the last save are appended to the journal as one record, Load applies the records in order on top of the base.
+ * Once the journal grew to a good part of the payload, the next save writes a fresh base snapshot through the
+ * regular atomic commit and starts an empty journal (compaction).
+ *
+ * The journal header names the base it belongs to (length and a hash over the chunk hashes), so a journal that
+ * survived a crash during compaction is never applied to the new base. Every record is checksummed, a torn append
+ * simply ends the replay at the last complete record.
+ */
+namespace SaveData
+{
+	constexpr size_t SAVE_CHUNK_SIZE = 16u * 1024u;
+	constexpr uint32_t SAVE_JOURNAL_MAGIC = 0x4A444D4Du; // "MMDJ"
+	constexpr uint32_t SAVE_JOURNAL_RECORD_MAGIC = 0x52444D4Du; // "MMDR"
+	constexpr uint16_t SAVE_JOURNAL_VERSION = 1u;
+	constexpr const char* JOURNAL_SAVE_SUFFIX = ".journal";
+
+	struct SaveJournalHeader
+	{
+		uint32_t magic = SAVE_JOURNAL_MAGIC;
+		uint16_t version = SAVE_JOURNAL_VERSION;
+		uint16_t headerSize = sizeof(SaveJournalHeader);
+		uint64_t baseLength = 0u;
+		uint64_t baseHash = 0u;
+		uint32_t chunkSize = static_cast<uint32_t>(SAVE_CHUNK_SIZE);
+		// checksum over all header bytes before this field
+		uint32_t headerCrc = 0u;
+	};
+
+	// followed by `chunkCount` uint32_t chunk indices (ascending) and the data of these chunks
+	struct SaveJournalRecord
+	{
+		uint32_t magic = SAVE_JOURNAL_RECORD_MAGIC;
+		uint32_t chunkCount = 0u;
+		// records are numbered from 1 without gaps
+		uint64_t sequence = 0u;
+		// checksum over the chunk indices and the chunk data
+		uint32_t dataCrc = 0u;
+		// checksum over all record header bytes before this field
+		uint32_t headerCrc = 0u;
+	};
+
+	static_assert(sizeof(SaveJournalHeader) == 32u, "SaveJournalHeader is part of the file format, keep it packed");
+	static_assert(sizeof(SaveJournalRecord) == 24u, "SaveJournalRecord is part of the file format, keep it packed");
+
+	// lives in the arena, nullptr when it's full
+	const char* JournalSaveName(SaveArena& arena, const char* name) {
+		return arena.Concat(name, JOURNAL_SAVE_SUFFIX);
+	}
+
+	inline size_t GetChunkCount(size_t length) {
+		return (length + SAVE_CHUNK_SIZE - 1u) / SAVE_CHUNK_SIZE;
+	}
+
+	inline size_t GetChunkLength(size_t length, size_t chunk) {
+		const size_t offset = chunk * SAVE_CHUNK_SIZE;
+		return length - offset < SAVE_CHUNK_SIZE ? length - offset : SAVE_CHUNK_SIZE;
+	}
+
+	/*
+	 * Delta state of one save slot. Not thread-safe, the save system only touches it while holding its file mutex.
+	 */
+	class SaveJournal
+	{
+	public:
+		/*
+		 * Forgets what is on the disk, the next save writes a full snapshot
+		 */
+		void Invalidate() {
+			m_IsKnown = false;
+			m_JournalLength = 0u;
+		}
+
+		/*
+		 * Hashes the chunks of the new state and collects the ones that changed since the last save.
+		 * Returns false when the state has to be written as a full snapshot instead (no known base, resized
+		 * payload, too much changed, or the journal is due for compaction).
+		 */
+		bool PrepareDelta(const SaveFile& save) {
+			HashChunks(save, m_PendingHashes);
+
+			// without a journal for this base there is nothing to append to
+			if (!m_IsKnown || m_JournalLength == 0u || save.length != m_BaseLength || save.length <= SAVE_CHUNK_SIZE) {
+				return false;
+			}
+
+			m_ChangedChunks.clear();
+			size_t changedBytes = 0u;
+			for (size_t chunk = 0u; chunk < m_PendingHashes.size(); ++chunk) {
+				if (m_PendingHashes[chunk] != m_CommittedHashes[chunk]) {
+					m_ChangedChunks.push_back(static_cast<uint32_t>(chunk));
+					changedBytes += GetChunkLength(save.length, chunk);
+				}
+			}
+
+			// once the journal holds about half a payload, rewriting the base is cheaper than replaying it
+			const uint64_t recordSize = sizeof(SaveJournalRecord) + m_ChangedChunks.size() * sizeof(uint32_t) + changedBytes;
+			return m_JournalLength + recordSize <= sizeof(SaveJournalHeader) + save.length / 2u;
+		}
+
+		/*
+		 * Appends the chunks collected by PrepareDelta as one record. Nothing is written when nothing changed.
+		 */
+		bool AppendDelta(const char* journalPath, const SaveFile& save, size_t& bytesWritten) {
+			bytesWritten = 0u;
+			if (m_ChangedChunks.empty()) {
+				return true;
+			}
+
+			SaveJournalRecord record;
+			record.chunkCount = static_cast<uint32_t>(m_ChangedChunks.size());
+			record.sequence = m_Sequence + 1u;
+
+			std::vector<SaveBuffer>& buffers = m_Buffers;
+			buffers.clear();
+			buffers.push_back({ reinterpret_cast<const byte*>(&record), sizeof(record) });
+			buffers.push_back({ reinterpret_cast<const byte*>(m_ChangedChunks.data()), m_ChangedChunks.size() * sizeof(uint32_t) });
+
+			uint32_t dataCrc = Crc32c::Update(0u, m_ChangedChunks.data(), m_ChangedChunks.size() * sizeof(uint32_t));
+			for (size_t i = 0u; i < m_ChangedChunks.size(); ++i) {
+				const size_t chunk = m_ChangedChunks[i];
+				const SaveBuffer data = { save.data + chunk * SAVE_CHUNK_SIZE, GetChunkLength(save.length, chunk) };
+				dataCrc = Crc32c::Update(dataCrc, data.data, data.length);
+
+				// neighbouring chunks go out with a single write
+				SaveBuffer& last = buffers.back();
+				if (buffers.size() > 2u && last.data + last.length == data.data) {
+					last.length += data.length;
+				}
+				else {
+					buffers.push_back(data);
+				}
+			}
+
+			record.dataCrc = dataCrc;
+			record.headerCrc = Crc32c::Compute(&record, offsetof(SaveJournalRecord, headerCrc));
+
+			if (!AppendFileDurable(journalPath, m_JournalLength, buffers.data(), buffers.size())) {
+				// the tail of the journal is unknown now
+				Invalidate();
+				return false;
+			}
+
+			for (size_t i = 0u; i < buffers.size(); ++i) {
+				bytesWritten += buffers[i].length;
+			}
+
+			m_JournalLength += bytesWritten;
+			m_Sequence = record.sequence;
+			m_CommittedHashes.swap(m_PendingHashes);
+			return true;
+		}
+
+		/*
+		 * Call once the state prepared by PrepareDelta was committed as the new base snapshot, replaces the
+		 * journal by an empty one for this base
+		 */
+		bool BeginJournal(const char* journalPath, const SaveFile& save, size_t& bytesWritten) {
+			bytesWritten = 0u;
+
+			// a single chunk gains nothing from deltas, make sure no stale journal is lying around
+			if (save.length <= SAVE_CHUNK_SIZE) {
+				if (!m_IsKnown || m_JournalLength != 0u) {
+					remove(journalPath);
+				}
+				Reset(save, 0u);
+				return true;
+			}
+
+			SaveJournalHeader header;
+			header.baseLength = save.length;
+			header.baseHash = HashOfHashes(m_PendingHashes);
+			header.headerCrc = Crc32c::Compute(&header, offsetof(SaveJournalHeader, headerCrc));
+
+			if (!WriteFileDurable(journalPath, reinterpret_cast<const byte*>(&header), sizeof(header))) {
+				Invalidate();
+				return false;
+			}
+
+			bytesWritten = sizeof(header);
+			Reset(save, sizeof(header));
+			return true;
+		}
+
+		/*
+		 * Applies the records of the journal that belong to `base` and learns the state on the disk.
+		 * Returns true if records were applied, in which case `state` holds the reassembled payload; otherwise the
+		 * base is the latest state and `state` is left alone.
+		 */
+		bool Replay(const char* journalPath, const SaveFile& base, std::vector<byte>& state) {
+			if (base.length <= SAVE_CHUNK_SIZE) {
+				// never journaled, unless we wrote it ourselves the next save makes sure no stale journal is left
+				if (!m_IsKnown || m_JournalLength != 0u) {
+					Invalidate();
+				}
+				return false;
+			}
+
+			MappedFile journal;
+			if (!journal.Open(journalPath)) {
+				Learn(base);
+				return false;
+			}
+
+			SaveJournalHeader header;
+			if (journal.GetSize() < sizeof(header)) {
+				Invalidate();
+				return false;
+			}
+			memcpy(&header, journal.GetData(), sizeof(header));
+
+			const bool validHeader = header.magic == SAVE_JOURNAL_MAGIC && header.version == SAVE_JOURNAL_VERSION
+				&& header.headerSize >= sizeof(header) && header.headerSize <= journal.GetSize()
+				&& header.headerCrc == Crc32c::Compute(&header, offsetof(SaveJournalHeader, headerCrc))
+				&& header.chunkSize == SAVE_CHUNK_SIZE && header.baseLength == base.length;
+
+			if (!m_IsKnown) {
+				HashChunks(base, m_CommittedHashes);
+				m_BaseHash = HashOfHashes(m_CommittedHashes);
+			}
+
+			if (!validHeader || header.baseHash != m_BaseHash) {
+				// left over from a crash during compaction (or damaged), the next save starts a new journal
+				Invalidate();
+				return false;
+			}
+
+			const size_t chunkCount = GetChunkCount(base.length);
+			const byte* data = journal.GetData();
+			size_t offset = header.headerSize;
+			uint64_t sequence = 0u;
+			bool applied = false;
+
+			for (;;) {
+				SaveJournalRecord record;
+				if (journal.GetSize() - offset < sizeof(record)) {
+					break;
+				}
+				memcpy(&record, data + offset, sizeof(record));
+
+				if (record.magic != SAVE_JOURNAL_RECORD_MAGIC || record.sequence != sequence + 1u
+					|| record.headerCrc != Crc32c::Compute(&record, offsetof(SaveJournalRecord, headerCrc))
+					|| record.chunkCount == 0u || record.chunkCount > chunkCount) {
+					break;
+				}
+
+				const size_t indicesSize = record.chunkCount * sizeof(uint32_t);
+				if (journal.GetSize() - offset - sizeof(record) < indicesSize) {
+					break;
+				}
+
+				m_ChangedChunks.resize(record.chunkCount);
+				memcpy(m_ChangedChunks.data(), data + offset + sizeof(record), indicesSize);
+
+				size_t dataSize = 0u;
+				bool validIndices = true;
+				for (size_t i = 0u; validIndices && i < m_ChangedChunks.size(); ++i) {
+					validIndices = m_ChangedChunks[i] < chunkCount && (i == 0u || m_ChangedChunks[i - 1u] < m_ChangedChunks[i]);
+					dataSize += validIndices ? GetChunkLength(base.length, m_ChangedChunks[i]) : 0u;
+				}
+
+				const byte* chunkData = data + offset + sizeof(record) + indicesSize;
+				if (!validIndices || journal.GetSize() - offset - sizeof(record) - indicesSize < dataSize
+					|| Crc32c::Update(Crc32c::Update(0u, m_ChangedChunks.data(), indicesSize), chunkData, dataSize) != record.dataCrc) {
+					// torn or damaged, everything from here on is ignored
+					break;
+				}
+
+				if (!applied) {
+					state.assign(base.data, base.data + base.length);
+					applied = true;
+				}
+
+				for (size_t i = 0u; i < m_ChangedChunks.size(); ++i) {
+					const size_t chunk = m_ChangedChunks[i];
+					const size_t length = GetChunkLength(base.length, chunk);
+					memcpy(state.data() + chunk * SAVE_CHUNK_SIZE, chunkData, length);
+					chunkData += length;
+				}
+
+				offset += sizeof(record) + indicesSize + dataSize;
+				sequence = record.sequence;
+			}
+
+			if (!m_IsKnown) {
+				if (applied) {
+					SaveFile latest;
+					latest.data = state.data();
+					latest.length = state.size();
+					HashChunks(latest, m_CommittedHashes);
+				}
+				m_BaseLength = base.length;
+				m_IsKnown = true;
+			}
+
+			// the next append overwrites a torn tail
+			m_JournalLength = offset;
+			m_Sequence = sequence;
+			return applied;
+		}
+
+	private:
+		static void HashChunks(const SaveFile& save, std::vector<uint64_t>& hashes) {
+			hashes.resize(GetChunkCount(save.length));
+			for (size_t chunk = 0u; chunk < hashes.size(); ++chunk) {
+				hashes[chunk] = Hash64::Compute(save.data + chunk * SAVE_CHUNK_SIZE, GetChunkLength(save.length, chunk));
+			}
+		}
+
+		static uint64_t HashOfHashes(const std::vector<uint64_t>& hashes) {
+			return Hash64::Compute(hashes.data(), hashes.size() * sizeof(uint64_t));
+		}
+
+		// the prepared state is the new base
+		void Reset(const SaveFile& save, uint64_t journalLength) {
+			m_CommittedHashes.swap(m_PendingHashes);
+			m_BaseHash = HashOfHashes(m_CommittedHashes);
+			m_BaseLength = save.length;
+			m_JournalLength = journalLength;
+			m_Sequence = 0u;
+			m_IsKnown = true;
+		}
+
+		// the base without journal is the state on the disk
+		void Learn(const SaveFile& base) {
+			if (m_IsKnown) {
+				return;
+			}
+			HashChunks(base, m_CommittedHashes);
+			m_BaseHash = HashOfHashes(m_CommittedHashes);
+			m_BaseLength = base.length;
+			m_JournalLength = 0u;
+			m_Sequence = 0u;
+			m_IsKnown = true;
+		}
+
+		bool m_IsKnown = false;
+		uint64_t m_BaseLength = 0u;
+		uint64_t m_BaseHash = 0u;
+		// valid bytes of the journal file, 0 if there is none
+		uint64_t m_JournalLength = 0u;
+		uint64_t m_Sequence = 0u;
+
+		// chunk hashes of the state on the disk (base + journal)
+		std::vector<uint64_t> m_CommittedHashes;
+		std::vector<uint64_t> m_PendingHashes;
+		std::vector<uint32_t> m_ChangedChunks;
+		std::vector<SaveBuffer> m_Buffers;
+	};
+}
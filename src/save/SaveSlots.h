@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdio.h>
+
+#if PLATFORM_WINDOWS
+	#include <windows.h>
+#elif !PLATFORM_ORBIS
+	#include <dirent.h>
+	#include <errno.h>
+	#include <sys/stat.h>
+#endif
+
+#if !PLATFORM_ORBIS
+	#include "SaveCommit.h"
+	#include "SaveJournal.h"
+#endif
+
+#include "SaveIOQueue.h"
+#include "SaveTypes.h"
+
+/*
+ * Save slots: every save name is a slot with its own files (PC: `<directory>/<name>` plus its temp, backup and
+ * journal files, PS4: its own save data directory, which the SDK backs up on its own).
+ *
+ * The save system keeps the metadata of all slots in a SaveSlotIndex. It's built once in Initialize (PC: one
+ * directory listing plus a header read per slot, PS4: one directory search that returns the params stored with
+ * every slot) and updated after every write, so a save selection menu lists the slots without touching the disk.
+ */
+namespace SaveData
+{
+	constexpr uint32_t MAX_SAVE_SLOTS = 16u;
+	constexpr uint32_t INVALID_SAVE_SLOT = ~0u;
+
+	struct SaveSlotInfo
+	{
+		char name[MAX_SAVE_NAME_LENGTH] = {};
+		// uncompressed payload size
+		uint64_t payloadLength = 0u;
+		// container checksum of the last full snapshot (journaled deltas on PC don't change it)
+		uint32_t checksum = 0u;
+		// container format version
+		uint16_t version = 0u;
+		// a previous generation can be restored if the slot breaks
+		bool hasBackup = false;
+		// last write, seconds since the Unix epoch
+		int64_t modifiedTime = 0;
+	};
+
+	/*
+	 * Fixed table of MAX_SAVE_SLOTS slots. A slot keeps its position for the whole session (PS4: the number of its
+	 * save data directory), lookups go by name.
+	 *
+	 * Writers hold the save system's file mutex, the lookups for the menu only take the index's own lock for
+	 * the copy, so they never wait for a write to finish.
+	 */
+	class SaveSlotIndex {
+	public:
+		/*
+		 * Position of the slot, INVALID_SAVE_SLOT when it doesn't exist
+		 */
+		uint32_t Find(const char* name) const {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return FindLocked(name);
+		}
+
+		/*
+		 * Position a new slot would get, INVALID_SAVE_SLOT when all are taken
+		 */
+		uint32_t FindFree() const {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (uint32_t position = 0u; position < MAX_SAVE_SLOTS; ++position) {
+				if (!m_IsUsed[position]) {
+					return position;
+				}
+			}
+			return INVALID_SAVE_SLOT;
+		}
+
+		/*
+		 * Stores the metadata, the first call for a position creates the slot
+		 */
+		void Set(uint32_t position, const SaveSlotInfo& info) {
+			if (position >= MAX_SAVE_SLOTS) {
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (!m_IsUsed[position]) {
+				m_IsUsed[position] = true;
+				m_Order[m_Count++] = position;
+			}
+			m_Slots[position] = info;
+		}
+
+		bool Get(const char* name, SaveSlotInfo& info) const {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			const uint32_t position = FindLocked(name);
+			if (position == INVALID_SAVE_SLOT) {
+				return false;
+			}
+			info = m_Slots[position];
+			return true;
+		}
+
+		/*
+		 * The `index`th slot in the order they were found or created, for index < GetCount()
+		 */
+		bool GetAt(uint32_t index, SaveSlotInfo& info) const {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (index >= m_Count) {
+				return false;
+			}
+			info = m_Slots[m_Order[index]];
+			return true;
+		}
+
+		uint32_t GetCount() const {
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Count;
+		}
+
+	private:
+		uint32_t FindLocked(const char* name) const {
+			for (uint32_t index = 0u; index < m_Count; ++index) {
+				if (strcmp(m_Slots[m_Order[index]].name, name) == 0) {
+					return m_Order[index];
+				}
+			}
+			return INVALID_SAVE_SLOT;
+		}
+
+		mutable std::mutex m_Mutex;
+		SaveSlotInfo m_Slots[MAX_SAVE_SLOTS];
+		bool m_IsUsed[MAX_SAVE_SLOTS] = {};
+		// positions of the used slots, so enumerating skips the free ones
+		uint32_t m_Order[MAX_SAVE_SLOTS] = {};
+		uint32_t m_Count = 0u;
+	};
+
+	inline void CopySaveSlotName(SaveSlotInfo& info, const char* name) {
+		snprintf(info.name, sizeof(info.name), "%s", name);
+	}
+
+#if !PLATFORM_ORBIS
+
+	constexpr const char* DEFAULT_SAVE_DIRECTORY = "saves";
+
+	// invoked with the name of every file in the directory (without the directory)
+	typedef void (*SaveDirectoryVisitor)(const char* fileName, void* userData);
+
+	/*
+	 * True when the name belongs to a slot and isn't one of its temp, backup or journal files
+	 */
+	bool IsSaveSlotFile(const char* fileName) {
+		const char* extension = strrchr(fileName, '.');
+		const bool isSlotFile = extension == nullptr || (strcmp(extension, TEMP_SAVE_SUFFIX) != 0 && strcmp(extension, BACKUP_SAVE_SUFFIX) != 0 &&
+			strcmp(extension, JOURNAL_SAVE_SUFFIX) != 0);
+		return isSlotFile && strlen(fileName) < MAX_SAVE_NAME_LENGTH;
+	}
+
+#if PLATFORM_WINDOWS
+
+	bool CreateSaveDirectory(const char* path) {
+		return CreateDirectoryA(path, NULL) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+
+	bool GetSaveFileTime(const char* path, int64_t& seconds) {
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+			return false;
+		}
+
+		// 100ns ticks since 1601
+		ULARGE_INTEGER ticks;
+		ticks.LowPart = data.ftLastWriteTime.dwLowDateTime;
+		ticks.HighPart = data.ftLastWriteTime.dwHighDateTime;
+		seconds = static_cast<int64_t>(ticks.QuadPart / 10000000u) - 11644473600;
+		return true;
+	}
+
+	void ListSaveDirectory(const char* directory, SaveDirectoryVisitor visitor, void* userData) {
+		char pattern[MAX_SAVE_PATH_LENGTH];
+		if (snprintf(pattern, sizeof(pattern), "%s/*", directory) >= static_cast<int>(sizeof(pattern))) {
+			return;
+		}
+
+		WIN32_FIND_DATAA entry;
+		HANDLE find = FindFirstFileA(pattern, &entry);
+		if (find == INVALID_HANDLE_VALUE) {
+			return;
+		}
+
+		do {
+			if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0u) {
+				visitor(entry.cFileName, userData);
+			}
+		} while (FindNextFileA(find, &entry));
+		FindClose(find);
+	}
+
+#else
+
+	bool CreateSaveDirectory(const char* path) {
+		return mkdir(path, 0755) == 0 || errno == EEXIST;
+	}
+
+	bool GetSaveFileTime(const char* path, int64_t& seconds) {
+		struct stat info;
+		if (stat(path, &info) != 0) {
+			return false;
+		}
+		seconds = static_cast<int64_t>(info.st_mtime);
+		return true;
+	}
+
+	void ListSaveDirectory(const char* directory, SaveDirectoryVisitor visitor, void* userData) {
+		DIR* listing = opendir(directory);
+		if (listing == nullptr) {
+			return;
+		}
+
+		while (const dirent* entry = readdir(listing)) {
+			if (entry->d_type != DT_DIR) {
+				visitor(entry->d_name, userData);
+			}
+		}
+		closedir(listing);
+	}
+
+#endif
+
+#endif
+}
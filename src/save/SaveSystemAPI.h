@@ -2,8 +2,9 @@
 
 #ifdef PLATFORM_ORBIS
 	#include "SaveSystemAPIPS4.h"
-#elif PLATFORM_WINDOWS
-	#include "SaveSystemAPIWin.h"
+#elif PLATFORM_WINDOWS || PLATFORM_LINUX
+	// plain file system implementation for Windows and Linux, Win32 or POSIX file I/O is selected inside
+	#include "SaveSystemAPIFile.h"
 #else
 	#pragma error "Unsupported platform"
 #endif
\ No newline at end of file
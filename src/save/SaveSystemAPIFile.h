@@ -0,0 +1,547 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "../core/Profiler.h"
+
+#include "MappedFile.h"
+#include "SaveArena.h"
+#include "SaveCommit.h"
+#include "SaveCompression.h"
+#include "SaveContainer.h"
+#include "SaveIOQueue.h"
+#include "SaveJournal.h"
+#include "SaveSlots.h"
+#include "SaveTypes.h"
+#include "SaveView.h"
+
+namespace SaveData {
+
+	class SaveSystem {
+	public:
+		SaveSystem()
+			: m_IOQueue(this) {}
+
+		/*
+		* Initialize your save-data API. On consoles we maybe need to do additional
+		* things in here as well.
+		*
+		* Every slot lives in the save directory (created if needed). Its slots are indexed once here, the slot
+		* queries below never touch the disk afterwards.
+		*/
+		bool Initialize(const char* directory = DEFAULT_SAVE_DIRECTORY) {
+			const int length = snprintf(m_Directory, sizeof(m_Directory), "%s", directory);
+			if (length < 0 || length >= static_cast<int>(sizeof(m_Directory)) || !CreateSaveDirectory(m_Directory)) {
+				std::cout << "Could not create the save directory " << directory << std::endl;
+				return false;
+			}
+
+			ListSaveDirectory(m_Directory, IndexSlotFile, this);
+			m_IOQueue.Start();
+			return true;
+		}
+
+		/*
+		* Properly shutdown your save-data API. Finishes all queued async saves first.
+		*/
+		void Shutdown() {
+			m_IOQueue.Stop();
+		};
+
+		/*
+		* Store the provided data into a file on the current platform.
+		*
+		* - You receive a uint8_t buffer and a length, as well as the name of the save-data file
+		* - Write a platform file and store the binary data in it to ready it back later
+		* - Make sure to use a corruption-protection mechanism:
+		*	- PS4: Use the backup and recovery API provided by the SDK
+		*	- PC: Implement your own way of making sure that we only ever override the previous save-data when we could entirely write the new one
+		* - Return true when saving worked, and false, if something didn't work (not enough space anymore, other error, ...) -> normally we would return an error reason enum but we stick with a binary output now
+		*/
+		bool Save(const SaveFile& save, const char* name) {
+			PROFILE_SCOPE("SaveSystem::Save");
+
+			// one save at a time. Nothing else takes this mutex, so it may be held while waiting for the compression jobs
+			std::lock_guard<std::mutex> saveLock(m_SaveMutex);
+
+			// STEP 0: if only a few chunks of a large save changed, append just those to the journal
+
+			{
+				// serializes with Load
+				std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+				const DeltaResult result = SaveDelta(save, name);
+				if (result != DeltaResult::FULL_SNAPSHOT) {
+					return result == DeltaResult::WRITTEN;
+				}
+			}
+
+			// STEP 1: compress without the file mutex, the blocks run on the job workers and one of them may be
+			// waiting for the mutex in a Load right now
+
+			SaveFile stored;
+			const SaveContainerHeader header = m_SaveCompressor.Encode(save, stored);
+
+			std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+
+			// file names of this save, released when it's done
+			SaveArenaScope scope(m_Arena);
+
+			SaveNames names;
+			if (!FindSaveNames(name, names)) {
+				return false;
+			}
+			SaveJournal& journal = GetJournal(name);
+
+			// STEP 2: write the new generation (checksummed container + payload) exactly once into a temp file and flush it
+
+			size_t containerBytes = 0u;
+			if (!WriteContainer(names.temp, header, stored, containerBytes)) {
+				std::cout << "There was a problem while saving" << std::endl;
+				remove(names.temp);
+				journal.Invalidate();
+				return false;
+			}
+
+			// STEP 3: atomically swap the temp file in, the previous generation becomes the backup
+
+			if (!CommitFile(names.temp, names.saveData, names.backup)) {
+				std::cout << "There was a problem while committing the save" << std::endl;
+				journal.Invalidate();
+				return false;
+			}
+
+			// the new generation is in place, even if the journal below fails
+			UpdateSlot(names.slot, name, save.length, &header, names.backup);
+
+			// STEP 4: start an empty journal for the new generation, the old one doesn't match it anymore
+
+			size_t journalBytes = 0u;
+			if (!journal.BeginJournal(names.journal, save, journalBytes)) {
+				std::cout << "There was a problem while starting the save journal" << std::endl;
+				return false;
+			}
+
+			m_SnapshotWrites.fetch_add(1u, std::memory_order_relaxed);
+			m_BytesWritten.fetch_add(containerBytes + journalBytes, std::memory_order_relaxed);
+			return true;
+		}
+
+		/*
+		* Queues the provided data to be stored by the background I/O worker and returns right away.
+		* The payload is copied, so the caller may reuse its buffer immediately. The callback is invoked
+		* from Update() on the calling (game) thread once the write finished.
+		*/
+		SaveHandle SaveAsync(const SaveFile& save, const char* name, SaveCallback callback = nullptr, void* userData = nullptr) {
+			PROFILE_SCOPE("SaveSystem::SaveAsync");
+			return m_IOQueue.Submit(save, name, callback, userData);
+		}
+
+		/*
+		* Lock-free poll of an async save request
+		*/
+		SaveStatus GetSaveStatus(SaveHandle handle) const {
+			return m_IOQueue.GetStatus(handle);
+		}
+
+		/*
+		* Async saves of the same slot are written at most once per interval, newer snapshots replace queued ones
+		*/
+		void SetMinSaveInterval(Duration interval) {
+			m_IOQueue.SetMinWriteInterval(interval);
+		}
+
+		/*
+		* Requested vs. physically written saves since startup
+		*/
+		SaveStats GetSaveStats() const {
+			SaveStats stats = m_IOQueue.GetStats();
+			stats.snapshotWrites = m_SnapshotWrites.load(std::memory_order_relaxed);
+			stats.deltaWrites = m_DeltaWrites.load(std::memory_order_relaxed);
+			stats.bytesWritten = m_BytesWritten.load(std::memory_order_relaxed);
+			m_SaveCompressor.AddStats(stats);
+			m_LoadCompressor.AddStats(stats);
+			return stats;
+		}
+
+		/*
+		* Full saves are LZ4 compressed when it pays off (on by default), loading handles both
+		*/
+		void SetCompressionEnabled(bool enabled) {
+			m_SaveCompressor.SetEnabled(enabled);
+			m_LoadCompressor.SetEnabled(enabled);
+		}
+
+		/*
+		* Number of save slots, answered from the in-memory index
+		*/
+		uint32_t GetSaveSlotCount() const {
+			return m_Slots.GetCount();
+		}
+
+		/*
+		* Metadata of the `index`th slot (index < GetSaveSlotCount()), answered from the in-memory index
+		*/
+		bool GetSaveSlot(uint32_t index, SaveSlotInfo& info) const {
+			return m_Slots.GetAt(index, info);
+		}
+
+		/*
+		* Metadata of the slot with the name, false if there's no such slot
+		*/
+		bool FindSaveSlot(const char* name, SaveSlotInfo& info) const {
+			return m_Slots.Get(name, info);
+		}
+
+		/*
+		* Dispatches the completion callbacks of finished async saves. Call once per frame on the game thread.
+		*/
+		void Update() {
+			m_IOQueue.DispatchCompletions();
+		}
+
+		/*
+		* Load the save that was previously stored under the provided name
+		*
+		* - The container is validated (magic, version, checksums) in a single pass over the mapped file
+		* - If the file is missing or fails validation, the backup generation is validated, restored and returned
+		* - Without compression and journaled deltas the payload is mapped read-only and exposed in place, nothing
+		*   is copied or allocated; the file is unmapped when the view is destroyed
+		* - Otherwise the payload is decompressed / the deltas are applied into the system's buffers and the view
+		*   points there, which stays valid until the next load
+		* - A live view doesn't block saves of the same slot, the save replaces the file underneath the mapping and
+		*   the view keeps showing the generation it loaded. Keep views short-lived anyway: each one pins a replaced
+		*   generation on the disk, and on Windows it forces a commit onto the slower two-rename path if anything
+		*   else opened the file without sharing write access
+		*/
+		SaveView LoadView(const char* name) {
+			PROFILE_SCOPE("SaveSystem::Load");
+
+			// don't read while the I/O worker is in the middle of writing
+			std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+			return LoadViewLocked(name);
+		}
+
+		/*
+		* Same as LoadView, but copies the payload. The returned file and its data are owned by the save system
+		* and stay valid until the next Load, don't delete them
+		*/
+		SaveFile* Load(const char* name) {
+			PROFILE_SCOPE("SaveSystem::Load");
+
+			std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+
+			// the previous header goes away, this one stays at the bottom of the arena until the next Load
+			m_Arena.Reset();
+			SaveFile* saveFile = m_Arena.Create<SaveFile>();
+
+			SaveView view = LoadViewLocked(name);
+			if (view.IsValid()) {
+				// a reassembled state already lives in the load buffer
+				if (view.GetData() != m_LoadBuffer.data()) {
+					m_LoadBuffer.assign(view.GetData(), view.GetData() + view.GetLength());
+				}
+				saveFile->data = m_LoadBuffer.data();
+				saveFile->length = m_LoadBuffer.size();
+			}
+			return saveFile;
+		}
+
+	private:
+		enum class DeltaResult
+		{
+			WRITTEN,
+			FAILED,
+			// the state has to be written as a full snapshot
+			FULL_SNAPSHOT,
+		};
+
+		// slot and file names of a save, the names live in the arena
+		struct SaveNames
+		{
+			uint32_t slot = INVALID_SAVE_SLOT;
+			const char* saveData = nullptr;
+			const char* journal = nullptr;
+			const char* temp = nullptr;
+			const char* backup = nullptr;
+		};
+
+		/*
+		* False (and says why) when all slots are in use or the names don't fit into the arena
+		*/
+		bool FindSaveNames(const char* name, SaveNames& names) {
+			names.slot = FindSlot(name);
+			if (names.slot == INVALID_SAVE_SLOT) {
+				std::cout << "All " << MAX_SAVE_SLOTS << " save slots are in use" << std::endl;
+				return false;
+			}
+
+			names.saveData = SlotPath(name);
+			names.journal = names.saveData != nullptr ? JournalSaveName(m_Arena, names.saveData) : nullptr;
+			names.temp = names.saveData != nullptr ? TempSaveName(m_Arena, names.saveData) : nullptr;
+			names.backup = names.saveData != nullptr ? BackupSaveName(m_Arena, names.saveData) : nullptr;
+			if (names.journal == nullptr || names.temp == nullptr || names.backup == nullptr) {
+				std::cout << "The save name doesn't fit into the save arena" << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		/*
+		* Appends the changed chunks to the journal if that's cheaper than a full snapshot (file mutex held)
+		*/
+		DeltaResult SaveDelta(const SaveFile& save, const char* name) {
+			SaveArenaScope scope(m_Arena);
+
+			SaveNames names;
+			if (!FindSaveNames(name, names)) {
+				return DeltaResult::FAILED;
+			}
+
+			SaveJournal& journal = GetJournal(name);
+			if (!journal.PrepareDelta(save)) {
+				return DeltaResult::FULL_SNAPSHOT;
+			}
+
+			size_t written = 0u;
+			if (!journal.AppendDelta(names.journal, save, written)) {
+				std::cout << "There was a problem while appending to the save journal, writing a full snapshot" << std::endl;
+				return DeltaResult::FULL_SNAPSHOT;
+			}
+
+			UpdateSlot(names.slot, name, save.length, nullptr, names.backup);
+			m_DeltaWrites.fetch_add(1u, std::memory_order_relaxed);
+			m_BytesWritten.fetch_add(written, std::memory_order_relaxed);
+			return DeltaResult::WRITTEN;
+		}
+
+		bool WriteContainer(const char* path, const SaveContainerHeader& header, const SaveFile& stored, size_t& containerBytes) {
+			const SaveBuffer buffers[] = {
+				{ reinterpret_cast<const byte*>(&header), sizeof(header) },
+				{ stored.data, stored.length },
+			};
+			containerBytes = sizeof(header) + stored.length;
+			return WriteFileDurable(path, buffers, 2u);
+		}
+
+		SaveView LoadViewLocked(const char* name) {
+			SaveArenaScope scope(m_Arena);
+
+			const char* saveDataName = SlotPath(name);
+			if (saveDataName == nullptr) {
+				std::cout << "The save name doesn't fit into the save arena" << std::endl;
+				return SaveView();
+			}
+
+			SaveView view;
+			if (MapValidated(saveDataName, view)) {
+				return ApplyJournal(name, saveDataName, std::move(view));
+			}
+
+			std::cout << "Attempting to load backup" << std::endl;
+
+			const char* backupSaveDataName = BackupSaveName(m_Arena, saveDataName);
+			if (backupSaveDataName == nullptr || !MapValidated(backupSaveDataName, view)) {
+				std::cout << "No valid backup exists" << std::endl;
+				return SaveView();
+			}
+
+			// drop the broken generation and commit the backup in its place, a crash here leaves the backup untouched
+			std::cout << "Restoring backup" << std::endl;
+			remove(saveDataName);
+
+			SaveFile payload;
+			payload.data = const_cast<byte*>(view.GetData());
+			payload.length = view.GetLength();
+
+			// the file mutex is held, so the payload is compressed on this thread
+			const char* tempSaveDataName = TempSaveName(m_Arena, saveDataName);
+			SaveFile stored;
+			const SaveContainerHeader header = m_LoadCompressor.Encode(payload, stored);
+			size_t containerBytes = 0u;
+			if (tempSaveDataName == nullptr || !WriteContainer(tempSaveDataName, header, stored, containerBytes) ||
+				!CommitFile(tempSaveDataName, saveDataName, backupSaveDataName)) {
+				std::cout << "Could not restore backup" << std::endl;
+			}
+			else {
+				UpdateSlot(FindSlot(name), name, payload.length, &header, backupSaveDataName);
+			}
+
+			// the journal belonged to the broken generation
+			GetJournal(name).Invalidate();
+			return view;
+		}
+
+		/*
+		* Replays the journal on top of the mapped base, a reassembled state is kept in the load buffer
+		*/
+		SaveView ApplyJournal(const char* name, const char* path, SaveView base) {
+			SaveFile payload;
+			payload.data = const_cast<byte*>(base.GetData());
+			payload.length = base.GetLength();
+
+			const char* journalSaveDataName = JournalSaveName(m_Arena, path);
+			if (journalSaveDataName == nullptr || !GetJournal(name).Replay(journalSaveDataName, payload, m_LoadBuffer)) {
+				return base;
+			}
+			return SaveView::Borrow(m_LoadBuffer.data(), m_LoadBuffer.size());
+		}
+
+		/*
+		* Maps the file and validates the container, on success the view points at the payload inside the mapping
+		* (or at the decompressed payload)
+		*/
+		bool MapValidated(const char* path, SaveView& view) {
+			MappedFile mapped;
+			if (!mapped.Open(path)) {
+				std::cout << "Could not open save file " << path << std::endl;
+				return false;
+			}
+
+			SaveContainerHeader header;
+			SaveFile stored;
+			const SaveContainerError error = ValidateSaveContainer(mapped.GetData(), mapped.GetSize(), header, stored);
+			if (error != SaveContainerError::NONE) {
+				std::cout << "Save file " << path << " is invalid: " << ToString(error) << std::endl;
+				return false;
+			}
+
+			if (header.codec == SaveCodec::NONE) {
+				view = SaveView::Map(std::move(mapped), stored);
+				return true;
+			}
+
+			if (!m_LoadCompressor.Decode(header, stored, m_DecodeBuffer)) {
+				std::cout << "Save file " << path << " could not be decompressed" << std::endl;
+				return false;
+			}
+
+			view = SaveView::Borrow(m_DecodeBuffer.data(), m_DecodeBuffer.size());
+			return true;
+		}
+
+		/*
+		* `<directory>/<name>` in the arena, nullptr when it's full
+		*/
+		const char* SlotPath(const char* name) {
+			return m_Arena.Concat(m_Directory, "/", name);
+		}
+
+		/*
+		* Position of the slot, or the one a new slot gets
+		*/
+		uint32_t FindSlot(const char* name) const {
+			const uint32_t slot = m_Slots.Find(name);
+			return slot != INVALID_SAVE_SLOT ? slot : m_Slots.FindFree();
+		}
+
+		/*
+		* Metadata after a write, `header` is the one of a new snapshot or nullptr for a journal append
+		*/
+		void UpdateSlot(uint32_t slot, const char* name, size_t payloadLength, const SaveContainerHeader* header, const char* backupPath) {
+			SaveSlotInfo info;
+			if (!m_Slots.Get(name, info)) {
+				CopySaveSlotName(info, name);
+			}
+
+			info.payloadLength = payloadLength;
+			info.modifiedTime = static_cast<int64_t>(time(nullptr));
+			if (header != nullptr) {
+				info.checksum = header->payloadCrc;
+				info.version = header->version;
+				info.hasBackup = SaveFileExists(backupPath);
+			}
+			m_Slots.Set(slot, info);
+		}
+
+		/*
+		* Initialize - adds a file of the save directory to the index. Only the container header is read, a slot
+		* whose snapshot is broken is listed with the metadata of its backup
+		*/
+		static void IndexSlotFile(const char* fileName, void* userData) {
+			SaveSystem& system = *static_cast<SaveSystem*>(userData);
+			const uint32_t slot = system.m_Slots.FindFree();
+			if (!IsSaveSlotFile(fileName) || slot == INVALID_SAVE_SLOT) {
+				return;
+			}
+
+			SaveArenaScope scope(system.m_Arena);
+			const char* saveDataName = system.SlotPath(fileName);
+			const char* backupSaveDataName = saveDataName != nullptr ? BackupSaveName(system.m_Arena, saveDataName) : nullptr;
+			const char* journalSaveDataName = saveDataName != nullptr ? JournalSaveName(system.m_Arena, saveDataName) : nullptr;
+			if (journalSaveDataName == nullptr) {
+				return;
+			}
+
+			SaveSlotInfo info;
+			CopySaveSlotName(info, fileName);
+			info.hasBackup = SaveFileExists(backupSaveDataName);
+
+			SaveContainerHeader header;
+			if (!ReadContainerHeader(saveDataName, header) && !(info.hasBackup && ReadContainerHeader(backupSaveDataName, header))) {
+				// not a save file
+				return;
+			}
+			info.payloadLength = header.payloadLength;
+			info.checksum = header.payloadCrc;
+			info.version = header.version;
+
+			// journal appends don't touch the snapshot
+			int64_t journalTime = 0;
+			GetSaveFileTime(saveDataName, info.modifiedTime);
+			if (GetSaveFileTime(journalSaveDataName, journalTime) && journalTime > info.modifiedTime) {
+				info.modifiedTime = journalTime;
+			}
+
+			system.m_Slots.Set(slot, info);
+		}
+
+		static bool ReadContainerHeader(const char* path, SaveContainerHeader& header) {
+			MappedFile mapped;
+			return mapped.Open(path) && ValidateSaveContainerHeader(mapped.GetData(), mapped.GetSize(), header) == SaveContainerError::NONE;
+		}
+
+		/*
+		* Created on the first save or load of a slot, later lookups don't build a key string
+		*/
+		SaveJournal& GetJournal(const char* name) {
+			auto journal = m_Journals.find(name);
+			if (journal == m_Journals.end()) {
+				journal = m_Journals.emplace(name, SaveJournal()).first;
+			}
+			return journal->second;
+		}
+
+		SaveIOQueue<SaveSystem> m_IOQueue;
+		// the working directory until Initialize names the save directory
+		char m_Directory[MAX_SAVE_PATH_LENGTH] = ".";
+		// metadata of every slot, written under the file mutex
+		SaveSlotIndex m_Slots;
+		// file names and the SaveFile returned by Load, guarded by the file mutex
+		SaveArena m_Arena;
+		// backs the SaveFile returned by Load
+		std::vector<byte> m_LoadBuffer;
+		// decompressed base snapshot
+		std::vector<byte> m_DecodeBuffer;
+		// delta state per slot, guarded by the file mutex
+		std::map<std::string, SaveJournal, std::less<>> m_Journals;
+		// serializes Save calls, held while the save compressor waits for its jobs
+		std::mutex m_SaveMutex;
+		// used by Save outside of the file mutex, its blocks run as jobs
+		SaveCompressor m_SaveCompressor { BlockExecution::JOBS };
+		// used under the file mutex (loads, restoring a backup) by whatever thread loads, so it never waits for jobs
+		SaveCompressor m_LoadCompressor { BlockExecution::CALLING_THREAD };
+
+		std::atomic<uint64_t> m_SnapshotWrites { 0u };
+		std::atomic<uint64_t> m_DeltaWrites { 0u };
+		std::atomic<uint64_t> m_BytesWritten { 0u };
+	};
+}
\ No newline at end of file
@@ -1,14 +1,26 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
-#include <fstream>
+#include <ctime>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
+#include <kernel.h>
 #include <save_data.h>
 #include <sceerror.h>
 #include <user_service.h>
 
-typedef uint8_t byte;
+#include "../core/Profiler.h"
+
+#include "SaveArena.h"
+#include "SaveCompression.h"
+#include "SaveContainer.h"
+#include "SaveIOQueue.h"
+#include "SaveSlots.h"
+#include "SaveTypes.h"
+#include "SaveView.h"
 
 #define PRINT					printf
 #define EPRINT					printf("Error : %s at %d\n  ", __FILE__, __LINE__ ); \
@@ -16,26 +28,19 @@ typedef uint8_t byte;
 
 namespace SaveData
 {
-	// @note - lukas.vogl - The data our "game" wants to store and read (will be altered, saved and loaded by using controller input)
-	struct SaveGame
-	{
-		uint32_t score = 0u;
-	};
-
-	// @note - lukas.vogl - This is a simple representation of a SaveFile that can be saved and loaded
-	struct SaveFile
-	{
-		byte* data = nullptr;
-		size_t length = 0u;
-
-		bool IsValid() const { return data != nullptr && length != 0u; }
-	};
+	// save data directory of a slot position, the single save of older builds lives in SAVEDATA00
+	constexpr const char* SAVE_SLOT_DIRECTORY_FORMAT = "SAVEDATA%02u";
+	constexpr const char* SAVE_SLOT_DIRECTORY_PATTERN = "SAVEDATA%";
+	// stored as the slot's param detail next to the name (title) and checksum (user param), so the directory
+	// search at startup returns everything the index needs
+	constexpr const char* SAVE_SLOT_DETAIL_FORMAT = "%llu bytes, format %u";
 
 	class SaveSystem
 	{
 	public:
 		SaveSystem()
 			:m_UserId(SCE_USER_SERVICE_USER_ID_INVALID)
+			,m_IOQueue(this)
 		{
 			int ret = SCE_OK;
 
@@ -66,55 +71,28 @@ namespace SaveData
 				return;
 			}
 			std::cout << "Obtained user id" << std::endl;
-
-			memset(&m_DirName, 0x00, sizeof(m_DirName));
-			strlcpy(m_DirName.data, "SAVEDATA00", sizeof(m_DirName.data));
 		}
 		/*
 		* Initialize your save-data API. On consoles we maybe need to do additional
 		* things in here as well.
+		*
+		* Every slot is its own save data directory, created on its first save. A single directory search reads
+		* the params of all of them into the slot index, nothing is mounted.
 		*/
 		bool Initialize() {
-			int ret = SCE_OK;
-
-			SceSaveDataMount2 mount2;
-			setupSceSaveDataMount2(m_UserId,
-				SCE_SAVE_DATA_MOUNT_MODE_CREATE | SCE_SAVE_DATA_MOUNT_MODE_RDWR,
-				&m_DirName,
-				&mount2);
-			SceSaveDataMountResult mountResult;
-			memset(&mountResult, 0x00, sizeof(mountResult));
-			ret = sceSaveDataMount2(&mount2, &mountResult);
-			if (ret < SCE_OK) {
-				if (ret == SCE_SAVE_DATA_ERROR_BUSY || ret == SCE_SAVE_DATA_ERROR_EXISTS) {
-					std::cout << "Save data already exists" << std::endl;
-					return true;
-				}
-				else {
-					std::cout << "Failed to mount save data" << std::endl;
-					return false;
-				}
-			}
-			std::cout << "Successfully mounted save data" << std::endl;
-
-			SceSaveDataMountPoint* mountPoint = &mountResult.mountPoint;
-
-			ret = sceSaveDataUmount(mountPoint);
-			if (ret < SCE_OK) {
-				std::cout << "Failed to unmount save data" << std::endl;
-				return false;
-			}
-			std::cout << "Successfully unmounted save data" << std::endl;
-
+			BuildSlotIndex();
+			m_IOQueue.Start();
 			return true;
 		}
 
 		/*
-		* Properly shutdown your save-data API.
+		* Properly shutdown your save-data API. Finishes all queued async saves first.
 		*/
 		void Shutdown() {
 			int ret = SCE_OK;
 
+			m_IOQueue.Stop();
+
 			ret = sceSaveDataTerminate();
 			if (ret < SCE_OK) {
 				std::cout << "Failed to terminate save data" << std::endl;
@@ -132,18 +110,47 @@ namespace SaveData
 		* - Return true when saving worked, and false, if something didn't work (not enough space anymore, other error, ...) -> normally we would return an error reason enum but we stick with a binary output now
 		*/
 		bool Save(const SaveFile& save, const char* name) {
+			PROFILE_SCOPE("SaveSystem::Save");
+
+			// one save at a time. Nothing else takes this mutex, so it may be held while waiting for the compression jobs
+			std::lock_guard<std::mutex> saveLock(m_SaveMutex);
+
+			// checksummed container in front of the (compressed) payload, so bit rot is detected on load. Compressed
+			// before taking the file mutex: the blocks run on the job workers, one of them may be waiting in a Load
+			SaveFile stored;
+			const SaveContainerHeader header = m_SaveCompressor.Encode(save, stored);
+
+			// the save data directory can't be mounted twice, so serialize with Load
+			std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+
 			int32_t ret = SCE_OK;
 			bool hasSaved = true;
 
+			// a new slot takes the first free directory
+			const uint32_t existingSlot = m_Slots.Find(name);
+			const uint32_t slot = existingSlot != INVALID_SAVE_SLOT ? existingSlot : m_Slots.FindFree();
+			if (slot == INVALID_SAVE_SLOT) {
+				std::cout << "All " << MAX_SAVE_SLOTS << " save slots are in use" << std::endl;
+				return false;
+			}
+
+			SceSaveDataDirName dirName;
+			MakeSlotDirName(slot, dirName);
+
 			// Mount
 			SceSaveDataMount2 mount2;
 			setupSceSaveDataMount2(m_UserId,
-				SCE_SAVE_DATA_MOUNT_MODE_RDWR,
-				&m_DirName,
+				existingSlot != INVALID_SAVE_SLOT ? SCE_SAVE_DATA_MOUNT_MODE_RDWR : SCE_SAVE_DATA_MOUNT_MODE_CREATE | SCE_SAVE_DATA_MOUNT_MODE_RDWR,
+				&dirName,
 				&mount2);
 			SceSaveDataMountResult mountResult;
 			memset(&mountResult, 0x00, sizeof(mountResult));
 			ret = sceSaveDataMount2(&mount2, &mountResult);
+			if (ret == SCE_SAVE_DATA_ERROR_EXISTS) {
+				// the directory exists without slot params (e.g. written by an older build), reuse it
+				mount2.mountMode = SCE_SAVE_DATA_MOUNT_MODE_RDWR;
+				ret = sceSaveDataMount2(&mount2, &mountResult);
+			}
 			if (ret < SCE_OK)
 			{
 				std::cout << "Failed to mount save data" << std::endl;
@@ -154,17 +161,50 @@ namespace SaveData
 			SceSaveDataMountPoint* mountPoint = &mountResult.mountPoint;
 
 			// Write
-			char path[64];
+			char path[sizeof(SceSaveDataMountPoint) + MAX_SAVE_NAME_LENGTH];
 			snprintf(path, sizeof(path), "%s/%s", mountPoint->data, name);
 
-			std::ofstream output(path, std::ios::binary);
-			output.write((char*)save.data, save.length);
-			output.close();
+			// straight kernel calls, a stream object would allocate its buffers on every save
+			const int output = sceKernelOpen(path, SCE_KERNEL_O_WRONLY | SCE_KERNEL_O_CREAT | SCE_KERNEL_O_TRUNC, SCE_KERNEL_S_IRWU);
+			bool hasWritten = output >= SCE_OK;
+			hasWritten = hasWritten && WriteAll(output, reinterpret_cast<const byte*>(&header), sizeof(header));
+			hasWritten = hasWritten && WriteAll(output, stored.data, stored.length);
+			if (output >= SCE_OK && sceKernelClose(output) < SCE_OK) {
+				hasWritten = false;
+			}
 
-			if (!output.good()) {
+			if (!hasWritten) {
 				std::cout << "There was a problem while saving" << std::endl;
 				hasSaved = false;
 			}
+			else {
+				// the SDK's backup copies the whole directory anyway, so every save is a full snapshot here
+				m_SnapshotWrites.fetch_add(1u, std::memory_order_relaxed);
+				m_BytesWritten.fetch_add(sizeof(header) + stored.length, std::memory_order_relaxed);
+			}
+
+			// Slot metadata for the directory search at startup
+			SaveSlotInfo info;
+			if (!m_Slots.Get(name, info)) {
+				CopySaveSlotName(info, name);
+			}
+			info.payloadLength = save.length;
+			info.checksum = header.payloadCrc;
+			info.version = header.version;
+			info.modifiedTime = static_cast<int64_t>(time(nullptr));
+
+			if (hasSaved) {
+				SceSaveDataParam param;
+				memset(&param, 0x00, sizeof(param));
+				snprintf(param.title, sizeof(param.title), "%s", name);
+				snprintf(param.detail, sizeof(param.detail), SAVE_SLOT_DETAIL_FORMAT, static_cast<unsigned long long>(info.payloadLength), static_cast<unsigned>(info.version));
+				param.userParam = info.checksum;
+				ret = sceSaveDataSetParam(mountPoint, SCE_SAVE_DATA_PARAM_TYPE_ALL, &param, sizeof(param));
+				if (ret < SCE_OK)
+				{
+					EPRINT("sceSaveDataSetParam : 0x%08x\n", ret);
+				}
+			}
 
 			// Unmount + Backup
 			ret = sceSaveDataUmountWithBackup(mountPoint);
@@ -173,28 +213,174 @@ namespace SaveData
 				EPRINT("sceSaveDataUmount : 0x%08x\n", ret);
 			}
 
+			if (hasSaved) {
+				info.hasBackup = info.hasBackup || ret >= SCE_OK;
+				m_Slots.Set(slot, info);
+			}
+
 			return hasSaved;
 		}
 
+		/*
+		* Queues the provided data to be stored by the background I/O worker and returns right away.
+		* The payload is copied, so the caller may reuse its buffer immediately. The callback is invoked
+		* from Update() on the calling (game) thread once the write finished.
+		*/
+		SaveHandle SaveAsync(const SaveFile& save, const char* name, SaveCallback callback = nullptr, void* userData = nullptr) {
+			PROFILE_SCOPE("SaveSystem::SaveAsync");
+			return m_IOQueue.Submit(save, name, callback, userData);
+		}
+
+		/*
+		* Lock-free poll of an async save request
+		*/
+		SaveStatus GetSaveStatus(SaveHandle handle) const {
+			return m_IOQueue.GetStatus(handle);
+		}
+
+		/*
+		* Async saves of the same slot are written at most once per interval, newer snapshots replace queued ones
+		*/
+		void SetMinSaveInterval(Duration interval) {
+			m_IOQueue.SetMinWriteInterval(interval);
+		}
+
+		/*
+		* Requested vs. physically written saves since startup
+		*/
+		SaveStats GetSaveStats() const {
+			SaveStats stats = m_IOQueue.GetStats();
+			stats.snapshotWrites = m_SnapshotWrites.load(std::memory_order_relaxed);
+			stats.bytesWritten = m_BytesWritten.load(std::memory_order_relaxed);
+			m_SaveCompressor.AddStats(stats);
+			m_LoadCompressor.AddStats(stats);
+			return stats;
+		}
+
+		/*
+		* Saves are LZ4 compressed when it pays off (on by default), which also keeps them within the save data
+		* block quota for longer. Loading handles both
+		*/
+		void SetCompressionEnabled(bool enabled) {
+			m_SaveCompressor.SetEnabled(enabled);
+			m_LoadCompressor.SetEnabled(enabled);
+		}
+
+		/*
+		* Number of save slots, answered from the in-memory index
+		*/
+		uint32_t GetSaveSlotCount() const {
+			return m_Slots.GetCount();
+		}
+
+		/*
+		* Metadata of the `index`th slot (index < GetSaveSlotCount()), answered from the in-memory index
+		*/
+		bool GetSaveSlot(uint32_t index, SaveSlotInfo& info) const {
+			return m_Slots.GetAt(index, info);
+		}
+
+		/*
+		* Metadata of the slot with the name, false if there's no such slot
+		*/
+		bool FindSaveSlot(const char* name, SaveSlotInfo& info) const {
+			return m_Slots.Get(name, info);
+		}
+
+		/*
+		* Dispatches the completion callbacks of finished async saves. Call once per frame on the game thread.
+		*/
+		void Update() {
+			m_IOQueue.DispatchCompletions();
+		}
+
 		/*
 		* Load the save that was previously stored under the provided name
 		*
 		* - Return the buffer and length of the binary data we loaded (the "game" needs to parse it later)
 		* - If we cannot load a save-game, check if there's a backup of it and restore it and return the backupped save-data instead
 		* - If no save-data or backup exists, return an invalid SaveFile (a defaulted one)
+		* - The container is validated (magic, version, checksums), a mismatch is treated like broken save data
+		* - The returned file and its data are owned by the save system and stay valid until the next Load, don't
+		*   delete them
 		*/
 		SaveFile* Load(const char* name) {
+			SaveFile* file = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+				// the previous header goes away, this one stays in the arena until the next Load
+				m_Arena.Reset();
+				file = m_Arena.Create<SaveFile>();
+			}
+			LoadInto(name, *file);
+			return file;
+		}
+
+		/*
+		* Same as Load, but returns a view of the payload instead of a SaveFile header. The save data
+		* can't stay mounted, so the view points into the system's read buffer and stays valid until the next load.
+		*/
+		SaveView LoadView(const char* name) {
+			SaveFile file;
+			LoadInto(name, file);
+			return SaveView::Borrow(file.data, file.length);
+		}
+
+
+		// @note - lukas.vogl - You can alter the API and introduce new methods when you need them (Update, ...). 
+		// You are free to choose if saving data is sync or async - both is supported on all platforms and it's up 
+		// to you to decide what and why you see one more fitting than the other
+
+	private:
+		SceUserServiceUserId m_UserId;
+		SaveIOQueue<SaveSystem> m_IOQueue;
+		// metadata of every slot, written under the file mutex
+		SaveSlotIndex m_Slots;
+		// the SaveFile returned by Load, guarded by the file mutex
+		SaveArena m_Arena;
+		// backs the SaveFile returned by Load
+		std::vector<byte> m_LoadBuffer;
+		// decompressed payload
+		std::vector<byte> m_DecodeBuffer;
+		// serializes Save calls, held while the save compressor waits for its jobs
+		std::mutex m_SaveMutex;
+		// used by Save outside of the file mutex, its blocks run as jobs
+		SaveCompressor m_SaveCompressor { BlockExecution::JOBS };
+		// used by Load under the file mutex, so it never waits for jobs
+		SaveCompressor m_LoadCompressor { BlockExecution::CALLING_THREAD };
+
+		std::atomic<uint64_t> m_SnapshotWrites { 0u };
+		std::atomic<uint64_t> m_BytesWritten { 0u };
+
+		/*
+		* Mounts the save data, reads and validates the container, falls back to the backup once if it's broken
+		*/
+		bool LoadInto(const char* name, SaveFile& file) {
+			PROFILE_SCOPE("SaveSystem::Load");
+
+			// the save data directory can't be mounted twice, so wait for the I/O worker to finish its write
+			std::lock_guard<std::mutex> lock(m_IOQueue.GetFileMutex());
+
+			// unknown slots are answered from the index, without mounting anything
+			const uint32_t slot = m_Slots.Find(name);
+			if (slot == INVALID_SAVE_SLOT) {
+				std::cout << "There is no save slot " << name << std::endl;
+				return false;
+			}
+
+			SceSaveDataDirName dirName;
+			MakeSlotDirName(slot, dirName);
+
+			bool restoredBackup = false;
+
 		Start:
 			int32_t ret = SCE_OK;
 
-			SaveGame saveGame;
-			SaveFile* file = new SaveFile();
-
 			// Mount
 			SceSaveDataMount2 mount2;
 			setupSceSaveDataMount2(m_UserId,
 				SCE_SAVE_DATA_MOUNT_MODE_RDONLY,
-				&m_DirName,
+				&dirName,
 				&mount2);
 			SceSaveDataMountResult mountResult;
 			memset(&mountResult, 0x00, sizeof(mountResult));
@@ -206,76 +392,208 @@ namespace SaveData
 				// Attempt to restore backup
 				if (ret == SCE_SAVE_DATA_ERROR_BROKEN) {
 					std::cout << "Save data is corrupted" << std::endl;
-					std::cout << "Attempting to load backup" << std::endl;
 
-					SceSaveDataCheckBackupData check;
-					memset(&check, 0x00, sizeof(SceSaveDataCheckBackupData));
-					check.userId = m_UserId;
-					check.dirName = &m_DirName;
-					ret = sceSaveDataCheckBackupData(&check);
-
-					if (ret < SCE_OK) {
-						std::cout << "No backup exists" << std::endl;
-						return file;
-					}
-					else {
-						SceSaveDataRestoreBackupData restore;
-						memset(&restore, 0x00, sizeof(SceSaveDataRestoreBackupData));
-						restore.userId = m_UserId;
-						restore.dirName = &m_DirName;
-						ret = sceSaveDataRestoreBackupData(&restore);
-						std::cout << "Restoring backup" << std::endl;
+					if (!restoredBackup && RestoreBackup(dirName)) {
+						restoredBackup = true;
 						goto Start;
 					}
 				}
-				else {
-					return file;
-				}
+				return false;
 			}
 
 			SceSaveDataMountPoint* mountPoint = &mountResult.mountPoint;
 
-			// Read
-			char path[64];
+			// Read + validate in one pass over the read buffer
+			char path[sizeof(SceSaveDataMountPoint) + MAX_SAVE_NAME_LENGTH];
 			snprintf(path, sizeof(path), "%s/%s", mountPoint->data, name);
 
-			std::ifstream input(path, std::ios::binary);
+			SaveContainerError error = SaveContainerError::TRUNCATED;
+			SaveContainerHeader header;
+			const int input = sceKernelOpen(path, SCE_KERNEL_O_RDONLY, 0);
 
-			if (!input) {
+			if (input < SCE_OK) {
 				std::cout << "Could not open save file" << std::endl;
-				goto End;
 			}
+			else {
+				// the read buffer keeps its capacity, so loading a save of the same size doesn't allocate
+				const off_t size = sceKernelLseek(input, 0, SCE_KERNEL_SEEK_END);
+				bool hasRead = size >= 0 && sceKernelLseek(input, 0, SCE_KERNEL_SEEK_SET) == 0;
+				if (hasRead) {
+					m_LoadBuffer.resize(static_cast<size_t>(size));
+					hasRead = ReadAll(input, m_LoadBuffer.data(), m_LoadBuffer.size());
+				}
+				sceKernelClose(input);
 
-			input.read((char*)&saveGame, sizeof(SaveGame));
-			input.close();
-
-			if (!input.good()) {
-				std::cout << "Error occured at reading time" << std::endl;
-				goto End;
+				if (!hasRead) {
+					std::cout << "Error occured at reading time" << std::endl;
+				}
+				else {
+					error = ValidateSaveContainer(m_LoadBuffer.data(), m_LoadBuffer.size(), header, file);
+					if (error != SaveContainerError::NONE) {
+						std::cout << "Save file is invalid: " << ToString(error) << std::endl;
+					}
+					else if (header.codec != SaveCodec::NONE) {
+						if (m_LoadCompressor.Decode(header, file, m_DecodeBuffer)) {
+							file.data = m_DecodeBuffer.data();
+							file.length = m_DecodeBuffer.size();
+						}
+						else {
+							std::cout << "Save file could not be decompressed" << std::endl;
+							error = SaveContainerError::PAYLOAD_CORRUPTED;
+						}
+					}
+				}
 			}
 
-			file->data = reinterpret_cast<byte*>(&saveGame);
-			file->length = sizeof(saveGame);
-
 			// Unmount
-		End:
 			ret = sceSaveDataUmount(mountPoint);
 			if (ret < SCE_OK)
 			{
 				EPRINT("sceSaveDataUmount : 0x%08x\n", ret);
 			}
 
-			return file;
+			// the file system is fine but the content isn't, the backup is our only chance
+			if (error != SaveContainerError::NONE) {
+				file.data = nullptr;
+				file.length = 0u;
+
+				if (!restoredBackup && RestoreBackup(dirName)) {
+					restoredBackup = true;
+					goto Start;
+				}
+			}
+
+			// the restored directory brought the params of the older generation along, the index has to match
+			if (error == SaveContainerError::NONE && restoredBackup) {
+				SaveSlotInfo info;
+				m_Slots.Get(name, info);
+				info.payloadLength = file.length;
+				info.checksum = header.payloadCrc;
+				info.version = header.version;
+				m_Slots.Set(slot, info);
+			}
+
+			return error == SaveContainerError::NONE;
 		}
 
+		static void MakeSlotDirName(uint32_t slot, SceSaveDataDirName& dirName) {
+			memset(&dirName, 0x00, sizeof(dirName));
+			snprintf(dirName.data, sizeof(dirName.data), SAVE_SLOT_DIRECTORY_FORMAT, slot);
+		}
 
-		// @note - lukas.vogl - You can alter the API and introduce new methods when you need them (Update, ...). 
-		// You are free to choose if saving data is sync or async - both is supported on all platforms and it's up 
-		// to you to decide what and why you see one more fitting than the other
+		/*
+		* Initialize - one search over all slot directories, their params hold the metadata
+		*/
+		void BuildSlotIndex() {
+			SceSaveDataDirName pattern;
+			memset(&pattern, 0x00, sizeof(pattern));
+			strlcpy(pattern.data, SAVE_SLOT_DIRECTORY_PATTERN, sizeof(pattern.data));
+
+			SceSaveDataDirNameSearchCond cond;
+			memset(&cond, 0x00, sizeof(cond));
+			cond.userId = m_UserId;
+			cond.dirName = &pattern;
+			cond.key = SCE_SAVE_DATA_SORT_KEY_DIRNAME;
+			cond.order = SCE_SAVE_DATA_SORT_ORDER_ASCENT;
+
+			SceSaveDataDirName dirNames[MAX_SAVE_SLOTS];
+			SceSaveDataParam params[MAX_SAVE_SLOTS];
+			SceSaveDataDirNameSearchResult result;
+			memset(&result, 0x00, sizeof(result));
+			result.dirNames = dirNames;
+			result.dirNamesNum = MAX_SAVE_SLOTS;
+			result.params = params;
+
+			const int32_t ret = sceSaveDataDirNameSearch(&cond, &result);
+			if (ret < SCE_OK) {
+				EPRINT("sceSaveDataDirNameSearch : 0x%08x\n", ret);
+				return;
+			}
 
-	private:
-		SceUserServiceUserId m_UserId;
-		SceSaveDataDirName m_DirName;
+			for (uint32_t i = 0u; i < result.setNum; ++i) {
+				// directories without a title weren't written as a slot
+				unsigned slot = 0u;
+				if (sscanf(dirNames[i].data, SAVE_SLOT_DIRECTORY_FORMAT, &slot) != 1 || slot >= MAX_SAVE_SLOTS || params[i].title[0] == '\0') {
+					continue;
+				}
+
+				SaveSlotInfo info;
+				CopySaveSlotName(info, params[i].title);
+				info.checksum = params[i].userParam;
+				info.modifiedTime = static_cast<int64_t>(params[i].mtime);
+
+				unsigned long long payloadLength = 0u;
+				unsigned version = 0u;
+				if (sscanf(params[i].detail, SAVE_SLOT_DETAIL_FORMAT, &payloadLength, &version) == 2) {
+					info.payloadLength = payloadLength;
+					info.version = static_cast<uint16_t>(version);
+				}
+
+				SceSaveDataCheckBackupData check;
+				memset(&check, 0x00, sizeof(check));
+				check.userId = m_UserId;
+				check.dirName = &dirNames[i];
+				info.hasBackup = sceSaveDataCheckBackupData(&check) >= SCE_OK;
+
+				m_Slots.Set(slot, info);
+			}
+		}
+
+		static bool WriteAll(int file, const byte* data, size_t length) {
+			while (length > 0u) {
+				const ssize_t written = sceKernelWrite(file, data, length);
+				if (written <= 0) {
+					return false;
+				}
+				data += written;
+				length -= static_cast<size_t>(written);
+			}
+			return true;
+		}
+
+		static bool ReadAll(int file, byte* data, size_t length) {
+			while (length > 0u) {
+				const ssize_t read = sceKernelRead(file, data, length);
+				if (read <= 0) {
+					return false;
+				}
+				data += read;
+				length -= static_cast<size_t>(read);
+			}
+			return true;
+		}
+
+		/*
+		* Replaces the broken save data directory with the backup the SDK took on the last successful save
+		*/
+		bool RestoreBackup(const SceSaveDataDirName& dirName) {
+			std::cout << "Attempting to load backup" << std::endl;
+
+			SceSaveDataCheckBackupData check;
+			memset(&check, 0x00, sizeof(SceSaveDataCheckBackupData));
+			check.userId = m_UserId;
+			check.dirName = &dirName;
+			int32_t ret = sceSaveDataCheckBackupData(&check);
+
+			if (ret < SCE_OK) {
+				std::cout << "No backup exists" << std::endl;
+				return false;
+			}
+
+			SceSaveDataRestoreBackupData restore;
+			memset(&restore, 0x00, sizeof(SceSaveDataRestoreBackupData));
+			restore.userId = m_UserId;
+			restore.dirName = &dirName;
+			ret = sceSaveDataRestoreBackupData(&restore);
+
+			if (ret < SCE_OK) {
+				std::cout << "Failed to restore backup" << std::endl;
+				return false;
+			}
+
+			std::cout << "Restoring backup" << std::endl;
+			return true;
+		}
 
 		int clean(const SceUserServiceUserId userId, const char* dirNameTemplate, const size_t num)
 		{
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+typedef uint8_t byte;
+
+namespace SaveData
+{
+	// @note - lukas.vogl - The data our "game" wants to store and read (will be altered, saved and loaded by using controller input)
+	struct SaveGame
+	{
+		uint32_t score = 0u;
+	};
+
+	// @note - lukas.vogl - This is a simple representation of a SaveFile that can be saved and loaded
+	struct SaveFile
+	{
+		byte* data = nullptr;
+		size_t length = 0u;
+
+		bool IsValid() const { return data != nullptr && length != 0u; }
+	};
+}
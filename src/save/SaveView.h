@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#if !PLATFORM_ORBIS
+	#include "MappedFile.h"
+#endif
+
+#include "SaveTypes.h"
+
+namespace SaveData
+{
+	/*
+	 * Read-only view of a loaded save payload, returned by SaveSystem::LoadView.
+	 *
+	 * On PC the view owns a read-only mapping of the save file and points right into it: nothing is copied or
+	 * allocated, pages are faulted in on demand and the file is unmapped when the view goes away. On PS4 the
+	 * save data mount can't be held open, so the view borrows the save system's read buffer instead (valid until
+	 * the next load).
+	 */
+	class SaveView
+	{
+	public:
+		SaveView() = default;
+		SaveView(const SaveView&) = delete;
+		SaveView& operator=(const SaveView&) = delete;
+
+		SaveView(SaveView&& other) {
+			*this = std::move(other);
+		}
+
+		SaveView& operator=(SaveView&& other) {
+			if (this != &other) {
+#if !PLATFORM_ORBIS
+				m_Mapping = std::move(other.m_Mapping);
+#endif
+				m_Data = other.m_Data;
+				m_Length = other.m_Length;
+				other.m_Data = nullptr;
+				other.m_Length = 0u;
+			}
+			return *this;
+		}
+
+		/*
+		 * View into memory that is owned by somebody else
+		 */
+		static SaveView Borrow(const byte* data, size_t length) {
+			SaveView view;
+			view.m_Data = data;
+			view.m_Length = length;
+			return view;
+		}
+
+#if !PLATFORM_ORBIS
+		/*
+		 * Takes over the mapping, the payload has to point into it
+		 */
+		static SaveView Map(MappedFile&& mapping, const SaveFile& payload) {
+			SaveView view;
+			view.m_Mapping = std::move(mapping);
+			view.m_Data = payload.data;
+			view.m_Length = payload.length;
+			return view;
+		}
+#endif
+
+		bool IsValid() const { return m_Data != nullptr && m_Length != 0u; }
+		const byte* GetData() const { return m_Data; }
+		size_t GetLength() const { return m_Length; }
+
+		/*
+		 * Interprets the payload as T, returns nullptr when the payload is too small to hold one
+		 */
+		template <typename T>
+		const T* As() const {
+			return IsValid() && m_Length >= sizeof(T) ? reinterpret_cast<const T*>(m_Data) : nullptr;
+		}
+
+	private:
+#if !PLATFORM_ORBIS
+		MappedFile m_Mapping;
+#endif
+		const byte* m_Data = nullptr;
+		size_t m_Length = 0u;
+	};
+}
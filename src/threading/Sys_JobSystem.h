@@ -0,0 +1,527 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "Sys_Threading.h"
+#include "../core/Clock.h"
+
+/*
+ * Work-stealing job system built on top of the Sys_ threading API.
+ *
+ * A fixed pool of workers (one per core, the thread calling Sys_InitJobSystem counts as one of them) each own
+ * a Chase-Lev deque. Workers push and pop at the bottom of their own deque and steal from the top of the
+ * others when they run dry. Threads that are not part of the pool (e.g. the tick scheduler) submit through a
+ * small locked injection queue instead.
+ *
+ * Jobs are handed out from a fixed ring of MAX_JOBS slots. A slot is only reused once its job finished, creating
+ * a job while the next slot is still busy waits until it frees up. Every created job therefore has to be run, and
+ * a handle stays valid until its job finished and MAX_JOBS newer jobs were created.
+ *
+ * Waiting (Sys_WaitForJob, Sys_CreateJob on a busy slot) helps out on pool workers only: they run whatever job is
+ * queued meanwhile, any subsystem's, so a worker must not hold a lock that a job may take while it waits. Threads
+ * outside of the pool (scheduler, save I/O, ...) may hold locks and run at any priority, they never pick up other
+ * jobs while waiting and just yield until the job finished. They only run queued jobs when they explicitly lend
+ * themselves to the pool with Sys_ExecuteJob. Without a running job system, Sys_RunJob executes the job right away.
+ */
+
+typedef void (*jobFunction_t)(void*);
+
+struct job_t;
+typedef job_t* jobHandle_t;
+constexpr jobHandle_t INVALID_JOB_HANDLE = nullptr;
+
+struct jobSystemStats_t {
+	uint32_t workerCount = 0u;
+	uint64_t executedJobs = 0u;
+	uint64_t stealAttempts = 0u;
+	uint64_t steals = 0u;
+	float elapsedSeconds = 0.0f;
+	float jobsPerSecond = 0.0f;
+	// successful steals relative to executed jobs
+	float stealRate = 0.0f;
+};
+
+namespace JobSystem
+{
+	constexpr uint32_t MAX_JOBS = 4096u;
+	constexpr uint32_t MAX_WORKERS = 32u;
+	constexpr uint32_t MAX_DEPENDENTS = 4u;
+	constexpr uint32_t DEQUE_CAPACITY = 1024u;
+	constexpr uint32_t IDLE_SPINS = 64u;
+	constexpr size_t CACHE_LINE_SIZE = 64u;
+}
+
+struct job_t {
+	jobFunction_t function = nullptr;
+	void* params = nullptr;
+	job_t* parent = nullptr;
+	// this job + all of its unfinished children, the job is finished once this reaches zero
+	std::atomic<int32_t> unfinishedJobs { 0 };
+	// jobs that have to finish before this one may run (+1 until Sys_RunJob was called)
+	std::atomic<int32_t> pendingDependencies { 0 };
+	std::atomic<uint32_t> dependentCount { 0u };
+	job_t* dependents[JobSystem::MAX_DEPENDENTS] = {};
+};
+
+namespace JobSystem
+{
+	/*
+	 * Bounded Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models").
+	 * Push/Pop may only be called by the owning worker, Steal by everybody else.
+	 */
+	class WorkStealingDeque
+	{
+	public:
+		bool Push(job_t* job)
+		{
+			const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+			const int64_t top = m_Top.load(std::memory_order_acquire);
+			if (bottom - top >= static_cast<int64_t>(DEQUE_CAPACITY)) {
+				return false;
+			}
+
+			m_Jobs[bottom & (DEQUE_CAPACITY - 1u)].store(job, std::memory_order_relaxed);
+			m_Bottom.store(bottom + 1, std::memory_order_release);
+			return true;
+		}
+
+		job_t* Pop()
+		{
+			const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+			m_Bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_Top.load(std::memory_order_relaxed);
+
+			if (top > bottom) {
+				// deque was empty
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			job_t* job = m_Jobs[bottom & (DEQUE_CAPACITY - 1u)].load(std::memory_order_relaxed);
+			if (top != bottom) {
+				return job;
+			}
+
+			// last job in the deque, race against the thieves for it
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				job = nullptr;
+			}
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return job;
+		}
+
+		job_t* Steal()
+		{
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom) {
+				return nullptr;
+			}
+
+			job_t* job = m_Jobs[top & (DEQUE_CAPACITY - 1u)].load(std::memory_order_relaxed);
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return job;
+		}
+
+	private:
+		alignas(CACHE_LINE_SIZE) std::atomic<int64_t> m_Top { 0 };
+		alignas(CACHE_LINE_SIZE) std::atomic<int64_t> m_Bottom { 0 };
+		std::atomic<job_t*> m_Jobs[DEQUE_CAPACITY];
+	};
+
+	struct alignas(CACHE_LINE_SIZE) Worker
+	{
+		WorkStealingDeque deque;
+		threadHandle_t thread = INVALID_THREAD_HANDLE;
+		uint32_t index = 0u;
+		uint32_t random = 0u;
+
+		std::atomic<uint64_t> executedJobs { 0u };
+		std::atomic<uint64_t> stealAttempts { 0u };
+		std::atomic<uint64_t> steals { 0u };
+	};
+
+	job_t jobPool[MAX_JOBS];
+	std::atomic<uint32_t> nextJob { 0u };
+
+	Worker workers[MAX_WORKERS];
+	uint32_t workerCount = 0u;
+	std::atomic<bool> isRunning { false };
+
+	// submissions from threads outside of the pool, first in first out so a thread that keeps submitting can't
+	// starve its older jobs. A fixed ring, no job is queued twice, so it can't hold more than the pool
+	std::mutex injectedMutex;
+	job_t* injectedJobs[MAX_JOBS];
+	uint32_t injectedHead = 0u;
+	uint32_t injectedCount = 0u;
+
+	// idle workers sleep here until new work gets queued
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<int32_t> queuedJobs { 0 };
+	std::atomic<int32_t> sleepingWorkers { 0 };
+
+	Clock uptimeClock;
+
+	thread_local Worker* currentWorker = nullptr;
+
+	void WakeWorkers()
+	{
+		if (sleepingWorkers.load() > 0) {
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			sleepCondition.notify_one();
+		}
+	}
+
+	void Execute(job_t* job);
+
+	void Enqueue(job_t* job)
+	{
+		if (workerCount == 0u) {
+			// no pool to hand it to (job system not running), nobody else would ever pick it up
+			Execute(job);
+			return;
+		}
+
+		queuedJobs.fetch_add(1);
+
+		if (currentWorker == nullptr || !currentWorker->deque.Push(job)) {
+			if (currentWorker != nullptr) {
+				// our own deque is full, just run it right away
+				queuedJobs.fetch_sub(1);
+				Execute(job);
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(injectedMutex);
+			if (injectedCount == MAX_JOBS) {
+				// can't happen while every queued job holds a pool slot, but don't overwrite the oldest one
+				lock.unlock();
+				queuedJobs.fetch_sub(1);
+				Execute(job);
+				return;
+			}
+			injectedJobs[(injectedHead + injectedCount) & (MAX_JOBS - 1u)] = job;
+			++injectedCount;
+		}
+
+		WakeWorkers();
+	}
+
+	void Finish(job_t* job)
+	{
+		// the slot may be reused as soon as the job counts as finished, read everything we still need up front
+		job_t* parent = job->parent;
+		job_t* dependents[MAX_DEPENDENTS];
+		const uint32_t dependentCount = job->dependentCount.load(std::memory_order_acquire);
+		for (uint32_t i = 0u; i < dependentCount; ++i) {
+			dependents[i] = job->dependents[i];
+		}
+
+		if (job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+			return;
+		}
+
+		if (parent != nullptr) {
+			Finish(parent);
+		}
+
+		for (uint32_t i = 0u; i < dependentCount; ++i) {
+			if (dependents[i]->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				Enqueue(dependents[i]);
+			}
+		}
+	}
+
+	void Execute(job_t* job)
+	{
+		job->function(job->params);
+		Finish(job);
+
+		if (currentWorker != nullptr) {
+			currentWorker->executedJobs.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	job_t* TakeInjected()
+	{
+		std::lock_guard<std::mutex> lock(injectedMutex);
+		if (injectedCount == 0u) {
+			return nullptr;
+		}
+
+		job_t* job = injectedJobs[injectedHead];
+		injectedHead = (injectedHead + 1u) & (MAX_JOBS - 1u);
+		--injectedCount;
+		return job;
+	}
+
+	job_t* TrySteal(Worker& worker)
+	{
+		if (workerCount < 2u) {
+			return nullptr;
+		}
+
+		// xorshift to pick a random victim, so the workers don't all gang up on the same deque
+		worker.random ^= worker.random << 13;
+		worker.random ^= worker.random >> 17;
+		worker.random ^= worker.random << 5;
+
+		const uint32_t start = worker.random % workerCount;
+		for (uint32_t i = 0u; i < workerCount; ++i) {
+			Worker& victim = workers[(start + i) % workerCount];
+			if (&victim == &worker) {
+				continue;
+			}
+
+			worker.stealAttempts.fetch_add(1, std::memory_order_relaxed);
+			job_t* job = victim.deque.Steal();
+			if (job != nullptr) {
+				worker.steals.fetch_add(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	job_t* GetJob()
+	{
+		job_t* job = nullptr;
+
+		if (currentWorker != nullptr) {
+			job = currentWorker->deque.Pop();
+		}
+		if (job == nullptr) {
+			job = TakeInjected();
+		}
+		if (job == nullptr && currentWorker != nullptr) {
+			job = TrySteal(*currentWorker);
+		}
+		if (job != nullptr) {
+			queuedJobs.fetch_sub(1);
+		}
+		return job;
+	}
+
+	/*
+	 * One round of waiting: a pool worker executes a queued job, a thread outside of the pool only yields
+	 */
+	void HelpOut()
+	{
+		job_t* job = currentWorker != nullptr ? GetJob() : nullptr;
+		if (job != nullptr) {
+			Execute(job);
+		}
+		else {
+			Sys_Yield();
+		}
+	}
+
+	void WorkerMain(void* params)
+	{
+		currentWorker = static_cast<Worker*>(params);
+
+		uint32_t idleSpins = 0u;
+		while (isRunning.load(std::memory_order_acquire)) {
+			job_t* job = GetJob();
+			if (job != nullptr) {
+				Execute(job);
+				idleSpins = 0u;
+				continue;
+			}
+
+			if (++idleSpins < IDLE_SPINS) {
+				Sys_Yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleepingWorkers.fetch_add(1);
+			sleepCondition.wait(lock, [] { return queuedJobs.load() > 0 || !isRunning.load(); });
+			sleepingWorkers.fetch_sub(1);
+			idleSpins = 0u;
+		}
+	}
+}
+
+/*
+ * Starts the worker pool. A worker count of 0 creates one worker per core, the calling thread is
+ * registered as worker 0 and helps out whenever it waits for a job
+ */
+void Sys_InitJobSystem(uint32_t workerCount = 0u) {
+	using namespace JobSystem;
+
+	if (workerCount == 0u) {
+		workerCount = Sys_GetCoreCount();
+	}
+	if (workerCount > MAX_WORKERS) {
+		workerCount = MAX_WORKERS;
+	}
+
+	JobSystem::workerCount = workerCount;
+	isRunning.store(true);
+	uptimeClock.Start();
+
+	for (uint32_t i = 0u; i < workerCount; ++i) {
+		workers[i].index = i;
+		workers[i].random = 0x9E3779B9u * (i + 1u);
+	}
+
+	currentWorker = &workers[0];
+	for (uint32_t i = 1u; i < workerCount; ++i) {
+		threadCreateParam_t params;
+		params.function = WorkerMain;
+		params.params = &workers[i];
+		params.name = "JobWorker";
+		workers[i].thread = Sys_CreateThread(params);
+	}
+}
+
+/*
+ * Stops and joins all workers, jobs that are still queued are dropped
+ */
+void Sys_ShutdownJobSystem() {
+	using namespace JobSystem;
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		isRunning.store(false);
+		sleepCondition.notify_all();
+	}
+
+	for (uint32_t i = 1u; i < workerCount; ++i) {
+		Sys_WaitForThread(workers[i].thread);
+		Sys_DestroyThread(workers[i].thread);
+	}
+
+	currentWorker = nullptr;
+	workerCount = 0u;
+}
+
+/*
+ * Creates a job that is not yet scheduled. When a parent is provided, the parent only counts as finished
+ * once this job finished as well. The job has to be run eventually, its slot isn't reused before it finished:
+ * with MAX_JOBS jobs outstanding this waits (see HelpOut) until the oldest one is done
+ */
+jobHandle_t Sys_CreateJob(jobFunction_t function, void* params, jobHandle_t parent = INVALID_JOB_HANDLE) {
+	using namespace JobSystem;
+
+	job_t* job = &jobPool[nextJob.fetch_add(1, std::memory_order_relaxed) & (MAX_JOBS - 1u)];
+	while (job->unfinishedJobs.load(std::memory_order_acquire) != 0) {
+		HelpOut();
+	}
+
+	job->function = function;
+	job->params = params;
+	job->parent = parent;
+	job->unfinishedJobs.store(1, std::memory_order_relaxed);
+	job->pendingDependencies.store(1, std::memory_order_relaxed);
+	job->dependentCount.store(0u, std::memory_order_relaxed);
+
+	if (parent != INVALID_JOB_HANDLE) {
+		parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+/*
+ * Makes the job wait for the provided dependency to finish before it gets executed.
+ * Has to be called before either of the two jobs is run. Returns false when the dependency has no room left
+ */
+bool Sys_AddJobDependency(jobHandle_t job, jobHandle_t dependency) {
+	const uint32_t slot = dependency->dependentCount.load(std::memory_order_relaxed);
+	if (slot >= JobSystem::MAX_DEPENDENTS) {
+		return false;
+	}
+
+	job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+	dependency->dependents[slot] = job;
+	dependency->dependentCount.store(slot + 1u, std::memory_order_release);
+	return true;
+}
+
+/*
+ * Schedules the job, it starts as soon as all of its dependencies finished
+ */
+void Sys_RunJob(jobHandle_t job) {
+	if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		JobSystem::Enqueue(job);
+	}
+}
+
+/*
+ * Returns true when the job and all of its children finished
+ */
+bool Sys_IsJobFinished(jobHandle_t job) {
+	return job->unfinishedJobs.load(std::memory_order_acquire) == 0;
+}
+
+/*
+ * Waits for the job in question (and its children) to finish. A pool worker executes other queued jobs meanwhile,
+ * any thread outside of the pool just yields (see the notes at the top)
+ */
+void Sys_WaitForJob(jobHandle_t job) {
+	while (!Sys_IsJobFinished(job)) {
+		JobSystem::HelpOut();
+	}
+}
+
+/*
+ * Executes one queued job on the calling thread. When there is none it sleeps like an idle worker, for at most
+ * `timeoutMicroseconds`, and runs the job that woke it up. Returns false when nothing was executed.
+ * Lends threads without work of their own (e.g. the main thread while a scheduler drives the game) to the pool.
+ * Runs any queued job, so the caller must not hold locks that jobs may take
+ */
+bool Sys_ExecuteJob(uint32_t timeoutMicroseconds) {
+	using namespace JobSystem;
+
+	job_t* job = GetJob();
+	if (job == nullptr) {
+		{
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleepingWorkers.fetch_add(1);
+			sleepCondition.wait_for(lock, std::chrono::microseconds(timeoutMicroseconds), [] { return queuedJobs.load() > 0 || !isRunning.load(); });
+			sleepingWorkers.fetch_sub(1);
+		}
+		job = GetJob();
+	}
+
+	if (job == nullptr) {
+		return false;
+	}
+	Execute(job);
+	return true;
+}
+
+/*
+ * Returns the accumulated throughput and stealing counters since Sys_InitJobSystem
+ */
+jobSystemStats_t Sys_GetJobSystemStats() {
+	using namespace JobSystem;
+
+	jobSystemStats_t stats;
+	stats.workerCount = workerCount;
+	for (uint32_t i = 0u; i < workerCount; ++i) {
+		stats.executedJobs += workers[i].executedJobs.load(std::memory_order_relaxed);
+		stats.stealAttempts += workers[i].stealAttempts.load(std::memory_order_relaxed);
+		stats.steals += workers[i].steals.load(std::memory_order_relaxed);
+	}
+
+	stats.elapsedSeconds = uptimeClock.ToSecond();
+	if (stats.elapsedSeconds > 0.0f) {
+		stats.jobsPerSecond = static_cast<float>(stats.executedJobs) / stats.elapsedSeconds;
+	}
+	if (stats.executedJobs > 0u) {
+		stats.stealRate = static_cast<float>(stats.steals) / static_cast<float>(stats.executedJobs);
+	}
+	return stats;
+}
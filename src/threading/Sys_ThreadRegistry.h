@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Bookkeeping of the threads created through Sys_CreateThread, shared by all platforms.
+ *
+ * Threads live in a fixed array of slots. A handle is the slot index plus the slot's generation at the time the
+ * thread was created: the generation is odd while the slot is in use and bumped on every claim and release, so a
+ * lookup is one index and one atomic compare, and a handle of a destroyed thread never matches the slot's next
+ * owner. Slots are claimed with a CAS, creating and destroying threads from several threads at once needs no lock.
+ *
+ * Every thread knows its own handle through a thread_local. Threads that weren't created by Sys_CreateThread
+ * (the main thread, threads of third party libraries) get a unique handle on first request, those handles don't
+ * own a slot and can't be waited for.
+ */
+namespace ThreadRegistry
+{
+	constexpr uint32_t MAX_THREADS = 64u;
+	constexpr uint32_t MAX_THREAD_NAME_LENGTH = 32u;
+	// handle = generation << INDEX_BITS | slot index
+	constexpr uint32_t INDEX_BITS = 8u;
+	constexpr uintptr_t INDEX_MASK = (static_cast<uintptr_t>(1u) << INDEX_BITS) - 1u;
+	// marks handles of threads that don't own a slot
+	constexpr uintptr_t ADOPTED_FLAG = static_cast<uintptr_t>(1u) << (sizeof(uintptr_t) * 8u - 2u);
+	constexpr uintptr_t INVALID_HANDLE = ~static_cast<uintptr_t>(0u);
+	static_assert(MAX_THREADS <= INDEX_MASK + 1u, "slot indices have to fit into the handle");
+
+	// truncates to MAX_THREAD_NAME_LENGTH - 1 characters
+	inline void CopyName(char (&destination)[MAX_THREAD_NAME_LENGTH], const char* name) {
+		uint32_t length = 0u;
+		for (; name != nullptr && name[length] != '\0' && length < MAX_THREAD_NAME_LENGTH - 1u; ++length) {
+			destination[length] = name[length];
+		}
+		destination[length] = '\0';
+	}
+
+	template <typename NativeThread>
+	struct Slot
+	{
+		// odd while the slot is in use
+		std::atomic<uint32_t> generation { 0u };
+		NativeThread native {};
+		void (*function)(void*) = nullptr;
+		void* params = nullptr;
+		char name[MAX_THREAD_NAME_LENGTH] = {};
+	};
+
+	template <typename NativeThread>
+	class Registry
+	{
+	public:
+		/*
+		 * Claims a free slot, returns INVALID_HANDLE when all MAX_THREADS slots are in use
+		 */
+		uintptr_t Claim(const char* name, void (*function)(void*), void* params) {
+			for (uint32_t index = 0u; index < MAX_THREADS; ++index) {
+				Slot<NativeThread>& slot = m_Slots[index];
+				uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+				if ((generation & 1u) != 0u || !slot.generation.compare_exchange_strong(generation, generation + 1u, std::memory_order_acquire)) {
+					continue;
+				}
+
+				slot.function = function;
+				slot.params = params;
+				CopyName(slot.name, name);
+				return (static_cast<uintptr_t>(generation + 1u) << INDEX_BITS) | index;
+			}
+			return INVALID_HANDLE;
+		}
+
+		/*
+		 * The slot of a live thread, nullptr for stale, adopted or invalid handles
+		 */
+		Slot<NativeThread>* Find(uintptr_t handle) {
+			if (handle == INVALID_HANDLE || (handle & ADOPTED_FLAG) != 0u) {
+				return nullptr;
+			}
+
+			Slot<NativeThread>& slot = m_Slots[(handle & INDEX_MASK) % MAX_THREADS];
+			const uint32_t generation = static_cast<uint32_t>(handle >> INDEX_BITS);
+			return slot.generation.load(std::memory_order_acquire) == generation && (generation & 1u) != 0u ? &slot : nullptr;
+		}
+
+		void Release(uintptr_t handle) {
+			Slot<NativeThread>* slot = Find(handle);
+			if (slot == nullptr) {
+				return;
+			}
+
+			slot->function = nullptr;
+			slot->params = nullptr;
+			uint32_t generation = static_cast<uint32_t>(handle >> INDEX_BITS);
+			slot->generation.compare_exchange_strong(generation, generation + 1u, std::memory_order_release);
+		}
+
+	private:
+		Slot<NativeThread> m_Slots[MAX_THREADS];
+	};
+
+	std::atomic<uintptr_t> nextAdoptedHandle { 0u };
+
+	// handle and name of the calling thread
+	thread_local uintptr_t currentThread = INVALID_HANDLE;
+	thread_local char currentThreadName[MAX_THREAD_NAME_LENGTH] = {};
+
+	/*
+	 * Handle of the calling thread, threads that weren't created by Sys_CreateThread get one on first request
+	 */
+	inline uintptr_t GetCurrentThread() {
+		if (currentThread == INVALID_HANDLE) {
+			currentThread = ADOPTED_FLAG | nextAdoptedHandle.fetch_add(1u, std::memory_order_relaxed);
+		}
+		return currentThread;
+	}
+}
@@ -4,6 +4,8 @@
 	#include "Sys_ThreadingPS4.h"
 #elif PLATFORM_WINDOWS
 	#include "Sys_ThreadingWin.h"
+#elif PLATFORM_LINUX
+	#include "Sys_ThreadingLinux.h"
 #else
 	#pragma error "Unsupported platform"
 #endif
\ No newline at end of file
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Sys_ThreadingTypes.h"
+
+ThreadRegistry::Registry<pthread_t> threadRegistry;
+
+/*
+ * Adapts our thread_t signature to the one pthread_create expects, the argument is the new thread's handle
+ */
+void* Sys_ThreadStartup(void* handle) {
+	const threadHandle_t self = reinterpret_cast<threadHandle_t>(handle);
+	const ThreadRegistry::Slot<pthread_t>* slot = threadRegistry.Find(self);
+	if (slot == nullptr) {
+		return nullptr;
+	}
+
+	ThreadRegistry::currentThread = self;
+	ThreadRegistry::CopyName(ThreadRegistry::currentThreadName, slot->name);
+	slot->function(slot->params);
+	return nullptr;
+}
+
+/*
+ * Sets the name of the provided pthread (Linux limits names to 15 characters + terminator)
+ */
+void Sys_SetPthreadName(pthread_t thread, const char* name) {
+	char shortName[16];
+	strncpy(shortName, name, sizeof(shortName) - 1);
+	shortName[sizeof(shortName) - 1] = '\0';
+	pthread_setname_np(thread, shortName);
+}
+
+/*
+ * Translates stack size, affinity and priority into pthread attributes
+ */
+void Sys_ApplyThreadAttributes(pthread_attr_t& attributes, const threadCreateParam_t& params) {
+	if (params.stackSize > 0u) {
+		const size_t stackSize = params.stackSize > PTHREAD_STACK_MIN ? params.stackSize : PTHREAD_STACK_MIN;
+		pthread_attr_setstacksize(&attributes, stackSize);
+	}
+
+	if (params.affinityMask != 0u) {
+		cpu_set_t cores;
+		CPU_ZERO(&cores);
+		for (uint32_t core = 0u; core < 64u && core < CPU_SETSIZE; ++core) {
+			if ((params.affinityMask & (static_cast<uint64_t>(1u) << core)) != 0u) {
+				CPU_SET(core, &cores);
+			}
+		}
+		pthread_attr_setaffinity_np(&attributes, sizeof(cores), &cores);
+	}
+
+	if (params.priority != threadPriority_t::NORMAL) {
+		int policy = SCHED_OTHER;
+		sched_param scheduling;
+		memset(&scheduling, 0, sizeof(scheduling));
+
+		switch (params.priority) {
+		case threadPriority_t::LOW:
+			policy = SCHED_BATCH;
+			break;
+		case threadPriority_t::HIGH:
+			policy = SCHED_FIFO;
+			scheduling.sched_priority = sched_get_priority_min(SCHED_FIFO);
+			break;
+		case threadPriority_t::TIME_CRITICAL:
+			policy = SCHED_FIFO;
+			scheduling.sched_priority = sched_get_priority_max(SCHED_FIFO);
+			break;
+		default:
+			break;
+		}
+
+		pthread_attr_setinheritsched(&attributes, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attributes, policy);
+		pthread_attr_setschedparam(&attributes, &scheduling);
+	}
+}
+
+/*
+ * Creates a thread on the platform based on the provided parameters
+ */
+threadHandle_t Sys_CreateThread(threadCreateParam_t& params) {
+	const threadHandle_t handle = threadRegistry.Claim(params.name, params.function, params.params);
+	ThreadRegistry::Slot<pthread_t>* slot = threadRegistry.Find(handle);
+	if (slot == nullptr) {
+		return INVALID_THREAD_HANDLE;
+	}
+
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	Sys_ApplyThreadAttributes(attributes, params);
+
+	int result = pthread_create(&slot->native, &attributes, Sys_ThreadStartup, reinterpret_cast<void*>(handle));
+	if (result == EPERM) {
+		// real-time scheduling needs CAP_SYS_NICE, run with the creator's scheduling instead
+		pthread_attr_setinheritsched(&attributes, PTHREAD_INHERIT_SCHED);
+		result = pthread_create(&slot->native, &attributes, Sys_ThreadStartup, reinterpret_cast<void*>(handle));
+	}
+	pthread_attr_destroy(&attributes);
+
+	if (result != 0) {
+		threadRegistry.Release(handle);
+		return INVALID_THREAD_HANDLE;
+	}
+	Sys_SetPthreadName(slot->native, slot->name);
+	return handle;
+}
+
+/*
+ * Get the ID / handle of the thread this function was called from
+ */
+threadHandle_t Sys_GetCurrentThreadID() {
+	return ThreadRegistry::GetCurrentThread();
+}
+
+/*
+ * Returns true when the thread this function was called on, has the same ID as the provided one
+ */
+bool Sys_IsCallingThread(threadHandle_t threadHandle) {
+	return threadHandle == ThreadRegistry::GetCurrentThread();
+}
+
+/*
+ * Sets the name of the provided thread
+ */
+void Sys_SetThreadName(threadHandle_t threadHandle, const char* name) {
+	if (Sys_IsCallingThread(threadHandle)) {
+		ThreadRegistry::CopyName(ThreadRegistry::currentThreadName, name);
+	}
+
+	if (ThreadRegistry::Slot<pthread_t>* slot = threadRegistry.Find(threadHandle)) {
+		ThreadRegistry::CopyName(slot->name, name);
+		Sys_SetPthreadName(slot->native, name);
+	}
+	else if (Sys_IsCallingThread(threadHandle)) {
+		Sys_SetPthreadName(pthread_self(), name);
+	}
+}
+
+/*
+ * Returns the name of the provided thread, empty for unknown threads
+ */
+const char* Sys_GetThreadName(threadHandle_t threadHandle) {
+	if (Sys_IsCallingThread(threadHandle)) {
+		return ThreadRegistry::currentThreadName;
+	}
+
+	const ThreadRegistry::Slot<pthread_t>* slot = threadRegistry.Find(threadHandle);
+	return slot != nullptr ? slot->name : "";
+}
+
+/*
+ * Waits for the thread in question to finish execution
+ */
+void Sys_WaitForThread(threadHandle_t threadHandle) {
+	if (ThreadRegistry::Slot<pthread_t>* slot = threadRegistry.Find(threadHandle)) {
+		pthread_join(slot->native, nullptr);
+	}
+}
+
+/*
+ * Destroys the thread in question, the handle becomes invalid (wait for the thread first)
+ */
+void Sys_DestroyThread(threadHandle_t threadHandle) {
+	threadRegistry.Release(threadHandle);
+}
+
+/*
+ * Returns the number of hardware threads available to the process
+ */
+uint32_t Sys_GetCoreCount() {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? static_cast<uint32_t>(count) : 1u;
+}
+
+/*
+ * Gives up the remainder of the calling thread's time slice
+ */
+void Sys_Yield() {
+	sched_yield();
+}
+
+/*
+ * Puts the calling thread to sleep for at least the provided amount of microseconds
+ */
+void Sys_Sleep(uint32_t microseconds) {
+	timespec duration;
+	duration.tv_sec = microseconds / 1000000u;
+	duration.tv_nsec = static_cast<long>(microseconds % 1000000u) * 1000;
+	while (nanosleep(&duration, &duration) != 0) {}
+}
@@ -1,72 +1,158 @@
 #pragma once
 
 #include <cstdint>
-#include <map>
+#include <cstring>
 
 #include <kernel.h>
 
-typedef void (*thread_t)(void*);
+#include "Sys_ThreadingTypes.h"
 
-typedef uintptr_t threadHandle_t;
-constexpr uintptr_t INVALID_THREAD_HANDLE = ~static_cast<uintptr_t>(0u);
+ThreadRegistry::Registry<ScePthread> threadRegistry;
 
-std::map<threadHandle_t, ScePthread*> threads;
+/*
+ * Adapts our thread_t signature to the one scePthreadCreate expects, the argument is the new thread's handle
+ */
+void* Sys_ThreadStartup(void* handle) {
+	const threadHandle_t self = reinterpret_cast<threadHandle_t>(handle);
+	const ThreadRegistry::Slot<ScePthread>* slot = threadRegistry.Find(self);
+	if (slot == nullptr) {
+		return nullptr;
+	}
 
-struct threadCreateParam_t {
-	threadCreateParam_t()
-		: function(nullptr)
-		, params(NULL)
-		, name("")
-	{}
+	ThreadRegistry::currentThread = self;
+	ThreadRegistry::CopyName(ThreadRegistry::currentThreadName, slot->name);
+	slot->function(slot->params);
+	return nullptr;
+}
 
-	thread_t function;
-	void* params;
-	const char* name;
-};
+/*
+ * Maps our priority classes onto the game's range of SCE_KERNEL_PRIO_FIFO_HIGHEST (most urgent) to
+ * SCE_KERNEL_PRIO_FIFO_LOWEST
+ */
+int Sys_ToScePriority(threadPriority_t priority) {
+	switch (priority) {
+	case threadPriority_t::LOW:
+		return SCE_KERNEL_PRIO_FIFO_LOWEST;
+	case threadPriority_t::HIGH:
+		return (SCE_KERNEL_PRIO_FIFO_HIGHEST + SCE_KERNEL_PRIO_FIFO_DEFAULT) / 2;
+	case threadPriority_t::TIME_CRITICAL:
+		return SCE_KERNEL_PRIO_FIFO_HIGHEST;
+	default:
+		return SCE_KERNEL_PRIO_FIFO_DEFAULT;
+	}
+}
 
 /*
  * Creates a thread on the platform based on the provided parameters
  */
 threadHandle_t Sys_CreateThread(threadCreateParam_t& params) {
-	ScePthread* thread = new ScePthread();
-	threadHandle_t id = scePthreadCreate(thread, NULL, reinterpret_cast<void* (*)(void*)>(params.function), params.params, params.name);
-	threads[id] = thread;
-	return id;
+	const threadHandle_t handle = threadRegistry.Claim(params.name, params.function, params.params);
+	ThreadRegistry::Slot<ScePthread>* slot = threadRegistry.Find(handle);
+	if (slot == nullptr) {
+		return INVALID_THREAD_HANDLE;
+	}
+
+	ScePthreadAttr attributes;
+	scePthreadAttrInit(&attributes);
+	if (params.stackSize > 0u) {
+		scePthreadAttrSetstacksize(&attributes, params.stackSize);
+	}
+	if (params.affinityMask != 0u) {
+		scePthreadAttrSetaffinity(&attributes, static_cast<SceKernelCpumask>(params.affinityMask));
+	}
+	SceKernelSchedParam scheduling;
+	scheduling.sched_priority = Sys_ToScePriority(params.priority);
+	scePthreadAttrSetinheritsched(&attributes, SCE_PTHREAD_EXPLICIT_SCHED);
+	scePthreadAttrSetschedparam(&attributes, &scheduling);
+
+	// the name is handed to the kernel with the thread, Razor shows it right away
+	const int result = scePthreadCreate(&slot->native, &attributes, Sys_ThreadStartup, reinterpret_cast<void*>(handle), slot->name);
+	scePthreadAttrDestroy(&attributes);
+
+	if (result < 0) {
+		threadRegistry.Release(handle);
+		return INVALID_THREAD_HANDLE;
+	}
+	return handle;
 }
 
 /*
  * Get the ID / handle of the thread this function was called from
  */
 threadHandle_t Sys_GetCurrentThreadID() {
-	return scePthreadGetthreadid();
+	return ThreadRegistry::GetCurrentThread();
 }
 
 /*
  * Returns true when the thread this function was called on, has the same ID as the provided one
  */
 bool Sys_IsCallingThread(threadHandle_t threadHandle) {
-	return threadHandle == scePthreadGetthreadid();
+	return threadHandle == ThreadRegistry::GetCurrentThread();
 }
 
 /*
  * Sets the name of the provided thread
  */
 void Sys_SetThreadName(threadHandle_t threadHandle, const char* name) {
-	scePthreadRename(*threads[threadHandle], name);
+	if (Sys_IsCallingThread(threadHandle)) {
+		ThreadRegistry::CopyName(ThreadRegistry::currentThreadName, name);
+	}
+
+	if (ThreadRegistry::Slot<ScePthread>* slot = threadRegistry.Find(threadHandle)) {
+		ThreadRegistry::CopyName(slot->name, name);
+		scePthreadRename(slot->native, name);
+	}
+	else if (Sys_IsCallingThread(threadHandle)) {
+		scePthreadRename(scePthreadSelf(), name);
+	}
+}
+
+/*
+ * Returns the name of the provided thread, empty for unknown threads
+ */
+const char* Sys_GetThreadName(threadHandle_t threadHandle) {
+	if (Sys_IsCallingThread(threadHandle)) {
+		return ThreadRegistry::currentThreadName;
+	}
+
+	const ThreadRegistry::Slot<ScePthread>* slot = threadRegistry.Find(threadHandle);
+	return slot != nullptr ? slot->name : "";
 }
 
 /*
  * Waits for the thread in question to finish execution
  */
 void Sys_WaitForThread(threadHandle_t threadHandle) {
-	scePthreadJoin(*threads[threadHandle], nullptr);
+	if (ThreadRegistry::Slot<ScePthread>* slot = threadRegistry.Find(threadHandle)) {
+		scePthreadJoin(slot->native, nullptr);
+	}
 }
 
 /*
- * Destroys the thread in question
+ * Destroys the thread in question, the handle becomes invalid (wait for the thread first)
  */
 void Sys_DestroyThread(threadHandle_t threadHandle) {
-	int result = scePthreadCancel(*threads[threadHandle]);
-	threads[threadHandle]->~ScePthread();
-	delete threads[threadHandle];
+	threadRegistry.Release(threadHandle);
+}
+
+/*
+ * Returns the number of hardware threads available to the process (games get six of the eight Jaguar cores)
+ */
+uint32_t Sys_GetCoreCount() {
+	return 6u;
+}
+
+/*
+ * Gives up the remainder of the calling thread's time slice
+ */
+void Sys_Yield() {
+	scePthreadYield();
+}
+
+
+/*
+ * Puts the calling thread to sleep for at least the provided amount of microseconds
+ */
+void Sys_Sleep(uint32_t microseconds) {
+	sceKernelUsleep(microseconds);
 }
\ No newline at end of file
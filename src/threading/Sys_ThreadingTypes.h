@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Sys_ThreadRegistry.h"
+
+typedef void (*thread_t)(void*);
+
+typedef uintptr_t threadHandle_t;
+constexpr uintptr_t INVALID_THREAD_HANDLE = ThreadRegistry::INVALID_HANDLE;
+
+/*
+ * Scheduling class of a thread. Raising it above NORMAL may need privileges (Linux: CAP_SYS_NICE), threads
+ * fall back to NORMAL when the platform refuses
+ */
+enum class threadPriority_t : uint8_t {
+	LOW,			// background work that may be starved, e.g. save I/O
+	NORMAL,
+	HIGH,			// latency sensitive and mostly sleeping, e.g. input polling
+	TIME_CRITICAL,
+};
+
+struct threadCreateParam_t {
+	threadCreateParam_t()
+		: function(nullptr)
+		, params(NULL)
+		, name("")
+		, affinityMask(0u)
+		, priority(threadPriority_t::NORMAL)
+		, stackSize(0u)
+	{}
+
+	thread_t function;
+	void* params;
+	const char* name;
+	// cores the thread may run on (bit i = core i), 0 leaves the choice to the OS
+	uint64_t affinityMask;
+	threadPriority_t priority;
+	// in bytes, 0 uses the platform's default
+	uint32_t stackSize;
+};
+
+/*
+ * Affinity mask of a single core, cores beyond the ones available wrap around
+ */
+inline uint64_t Sys_CoreMask(uint32_t core, uint32_t coreCount) {
+	return static_cast<uint64_t>(1u) << ((coreCount > 0u ? core % coreCount : 0u) % 64u);
+}
@@ -1,75 +1,185 @@
 #pragma once
 
 #include <cstdint>
+#include <chrono>
 #include <thread>
-#include <string>
-#include <map>
 
-typedef void (*thread_t)(void*);
+#include <windows.h>
+#include <timeapi.h>
+#include <process.h>
 
-typedef uintptr_t threadHandle_t;
-constexpr uintptr_t INVALID_THREAD_HANDLE = ~static_cast<uintptr_t>(0u);
+#include "Sys_ThreadingTypes.h"
 
-std::map<threadHandle_t, std::string> names;
-std::map<threadHandle_t, std::thread*> threads;
+ThreadRegistry::Registry<HANDLE> threadRegistry;
 
-struct threadCreateParam_t {
-	threadCreateParam_t()
-		: function(nullptr)
-		, params(NULL)
-		, name("") {}
+typedef HRESULT (WINAPI* setThreadDescription_t)(HANDLE, PCWSTR);
 
-	thread_t function;
-	void* params;
-	const char* name;
-};
+/*
+ * Entry point of every thread, publishes the handle to the thread itself before running its function
+ */
+unsigned __stdcall Sys_ThreadStartup(void* handle) {
+	const threadHandle_t self = reinterpret_cast<threadHandle_t>(handle);
+	const ThreadRegistry::Slot<HANDLE>* slot = threadRegistry.Find(self);
+	if (slot == nullptr) {
+		return 0u;
+	}
+
+	ThreadRegistry::currentThread = self;
+	ThreadRegistry::CopyName(ThreadRegistry::currentThreadName, slot->name);
+	slot->function(slot->params);
+	return 0u;
+}
+
+/*
+ * Hands the name to the OS so debuggers and profilers show it
+ */
+void Sys_SetWindowsThreadName(HANDLE thread, const char* name) {
+	// SetThreadDescription only exists since Windows 10 1607, look it up instead of linking against it
+	static const setThreadDescription_t setThreadDescription = reinterpret_cast<setThreadDescription_t>(
+		reinterpret_cast<void*>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription")));
+	if (setThreadDescription == nullptr) {
+		return;
+	}
+
+	wchar_t wideName[ThreadRegistry::MAX_THREAD_NAME_LENGTH];
+	if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wideName, ThreadRegistry::MAX_THREAD_NAME_LENGTH) > 0) {
+		setThreadDescription(thread, wideName);
+	}
+}
+
+int Sys_ToWindowsPriority(threadPriority_t priority) {
+	switch (priority) {
+	case threadPriority_t::LOW:
+		return THREAD_PRIORITY_BELOW_NORMAL;
+	case threadPriority_t::HIGH:
+		return THREAD_PRIORITY_HIGHEST;
+	case threadPriority_t::TIME_CRITICAL:
+		return THREAD_PRIORITY_TIME_CRITICAL;
+	default:
+		return THREAD_PRIORITY_NORMAL;
+	}
+}
 
 /*
  * Creates a thread on the platform based on the provided parameters
  */
  uintptr_t Sys_CreateThread(threadCreateParam_t& params) {
-	std::thread* thread = new std::thread(params.function, params.params);
-	threadHandle_t id = *static_cast<unsigned int*>(static_cast<void*>(&thread->get_id()));
-	names[id] = params.name;
-	threads[id] = thread;
-	return id;
+	const threadHandle_t handle = threadRegistry.Claim(params.name, params.function, params.params);
+	ThreadRegistry::Slot<HANDLE>* slot = threadRegistry.Find(handle);
+	if (slot == nullptr) {
+		return INVALID_THREAD_HANDLE;
+	}
+
+	// created suspended, so affinity, priority and name are in place before the thread runs its first instruction
+	const uintptr_t thread = _beginthreadex(NULL, params.stackSize, Sys_ThreadStartup, reinterpret_cast<void*>(handle), CREATE_SUSPENDED, NULL);
+	if (thread == 0u) {
+		threadRegistry.Release(handle);
+		return INVALID_THREAD_HANDLE;
+	}
+
+	slot->native = reinterpret_cast<HANDLE>(thread);
+	if (params.affinityMask != 0u) {
+		SetThreadAffinityMask(slot->native, static_cast<DWORD_PTR>(params.affinityMask));
+	}
+	SetThreadPriority(slot->native, Sys_ToWindowsPriority(params.priority));
+	Sys_SetWindowsThreadName(slot->native, slot->name);
+
+	ResumeThread(slot->native);
+	return handle;
  }
 
  /*
  * Get the ID / handle of the thread this function was called from
  */
  threadHandle_t Sys_GetCurrentThreadID() {
-	 threadHandle_t id = *static_cast<unsigned int*>(static_cast<void*>(&std::this_thread::get_id()));
-	 return id;
+	 return ThreadRegistry::GetCurrentThread();
  }
 
  /*
  * Returns true when the thread this function was called on, has the same ID as the provided one
  */
  bool Sys_IsCallingThread(threadHandle_t threadHandle) {
-	 return threads[threadHandle]->get_id() == std::this_thread::get_id();
+	 return threadHandle == ThreadRegistry::GetCurrentThread();
  }
 
  /*
  * Sets the name of the provided thread
  */
  void Sys_SetThreadName(threadHandle_t threadHandle, const char* name) {
-	 names[threadHandle] = name;
+	 if (Sys_IsCallingThread(threadHandle)) {
+		 ThreadRegistry::CopyName(ThreadRegistry::currentThreadName, name);
+	 }
+
+	 if (ThreadRegistry::Slot<HANDLE>* slot = threadRegistry.Find(threadHandle)) {
+		 ThreadRegistry::CopyName(slot->name, name);
+		 Sys_SetWindowsThreadName(slot->native, slot->name);
+	 }
+	 else if (Sys_IsCallingThread(threadHandle)) {
+		 Sys_SetWindowsThreadName(GetCurrentThread(), ThreadRegistry::currentThreadName);
+	 }
+ }
+
+ /*
+ * Returns the name of the provided thread, empty for unknown threads
+ */
+ const char* Sys_GetThreadName(threadHandle_t threadHandle) {
+	 if (Sys_IsCallingThread(threadHandle)) {
+		 return ThreadRegistry::currentThreadName;
+	 }
+
+	 const ThreadRegistry::Slot<HANDLE>* slot = threadRegistry.Find(threadHandle);
+	 return slot != nullptr ? slot->name : "";
  }
 
  /*
  * Waits for the thread in question to finish execution
  */
  void Sys_WaitForThread(threadHandle_t threadHandle) {
-	 threads[threadHandle]->join();
+	 if (ThreadRegistry::Slot<HANDLE>* slot = threadRegistry.Find(threadHandle)) {
+		 WaitForSingleObject(slot->native, INFINITE);
+	 }
  }
 
  /*
- * Destroys the thread in question
+ * Destroys the thread in question, the handle becomes invalid (wait for the thread first)
  */
  void Sys_DestroyThread(threadHandle_t threadHandle) {
-	 threads[threadHandle]->~thread();
-	 delete threads[threadHandle];
+	 ThreadRegistry::Slot<HANDLE>* slot = threadRegistry.Find(threadHandle);
+	 if (slot == nullptr) {
+		 return;
+	 }
+
+	 CloseHandle(slot->native);
+	 slot->native = NULL;
+	 threadRegistry.Release(threadHandle);
+ }
+
+
+
+
+ /*
+ * Returns the number of hardware threads available to the process
+ */
+ uint32_t Sys_GetCoreCount() {
+	 unsigned int count = std::thread::hardware_concurrency();
+	 return count > 0 ? count : 1u;
+ }
+
+ /*
+ * Gives up the remainder of the calling thread's time slice
+ */
+ void Sys_Yield() {
+	 std::this_thread::yield();
  }
 
 
+ /*
+ * Puts the calling thread to sleep for at least the provided amount of microseconds
+ */
+ void Sys_Sleep(uint32_t microseconds) {
+	 // the default scheduler tick is 15.6ms, ask for 1ms once so short sleeps are usable at all
+	 static const MMRESULT timerResolution = timeBeginPeriod(1);
+	 (void)timerResolution;
+
+	 std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+ }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "core/Clock.h"
+#include "core/Crc32c.h"
+#include "save/SaveContainer.h"
+
+#include "TestUtils.h"
+
+/*
+ * Checks that the dispatched, the hardware and the table CRC32C agree, then measures how fast a save container
+ * is validated (ValidateSaveContainer, one checksum pass over the payload) with the dispatched path against the
+ * table implementation, for 1, 16 and 64 MiB saves.
+ */
+
+constexpr size_t PAYLOAD_SIZES_MB[] = { 1u, 16u, 64u };
+// bytes checksummed per payload size, so small payloads are repeated often enough to time
+constexpr size_t BYTES_PER_MEASUREMENT = 256u * 1024u * 1024u;
+
+uint32_t randomState = 0x12345678u;
+
+uint32_t NextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+uint32_t ComputeSoftware(const byte* data, size_t length) {
+	return ~Crc32c::UpdateSoftware(~0u, data, length);
+}
+
+/*
+ * Every length up to a few cache lines, at every alignment, plus a continued checksum across two calls
+ */
+void CheckAgreement() {
+	const char* check = "123456789";
+	TEST_CHECK(Crc32c::Compute(check, 9u) == 0xE3069283u);
+	TEST_CHECK(ComputeSoftware(reinterpret_cast<const byte*>(check), 9u) == 0xE3069283u);
+
+	std::vector<byte> buffer(1024u);
+	for (byte& value : buffer) {
+		value = static_cast<byte>(NextRandom());
+	}
+
+	uint32_t mismatches = 0u;
+	for (size_t offset = 0u; offset < 8u; ++offset) {
+		for (size_t length = 0u; length + offset <= 520u; ++length) {
+			const byte* data = buffer.data() + offset;
+			const uint32_t expected = ComputeSoftware(data, length);
+			mismatches += Crc32c::Compute(data, length) != expected ? 1u : 0u;
+#if CRC32C_HARDWARE
+			if (Crc32c::HasHardwareSupport()) {
+				mismatches += ~Crc32c::UpdateHardware(~0u, data, length) != expected ? 1u : 0u;
+			}
+#endif
+			const size_t split = length / 3u;
+			mismatches += Crc32c::Update(Crc32c::Compute(data, split), data + split, length - split) != expected ? 1u : 0u;
+		}
+	}
+	TEST_CHECK(mismatches == 0u);
+}
+
+/*
+ * Validation throughput in GiB/s
+ */
+template <typename Validate>
+double Measure(size_t payloadSize, Validate validate) {
+	const size_t iterations = BYTES_PER_MEASUREMENT / payloadSize;
+	const TimePoint start = Clock::Now();
+	for (size_t i = 0u; i < iterations; ++i) {
+		validate();
+	}
+	const double seconds = (Clock::Now() - start).ToSecondsF();
+	return static_cast<double>(iterations * payloadSize) / (1024.0 * 1024.0 * 1024.0) / seconds;
+}
+
+int main() {
+	using namespace SaveData;
+
+	Clock::Init();
+	printf("SSE4.2 crc32: %s\n", Crc32c::HasHardwareSupport() ? "available, dispatched at runtime" : "not available, table fallback");
+
+	CheckAgreement();
+
+	for (size_t sizeMb : PAYLOAD_SIZES_MB) {
+		std::vector<byte> payload(sizeMb * 1024u * 1024u);
+		for (byte& value : payload) {
+			value = static_cast<byte>(NextRandom());
+		}
+
+		SaveFile save;
+		save.data = payload.data();
+		save.length = payload.size();
+		const SaveContainerHeader header = MakeSaveContainerHeader(save);
+
+		std::vector<byte> container(sizeof(header) + payload.size());
+		memcpy(container.data(), &header, sizeof(header));
+		memcpy(container.data() + sizeof(header), payload.data(), payload.size());
+
+		bool isValid = true;
+		const double dispatched = Measure(payload.size(), [&] {
+			SaveContainerHeader validated;
+			SaveFile stored;
+			isValid = isValid && ValidateSaveContainer(container.data(), container.size(), validated, stored) == SaveContainerError::NONE;
+		});
+		const double software = Measure(payload.size(), [&] {
+			isValid = isValid && ComputeSoftware(container.data() + sizeof(header), payload.size()) == header.payloadCrc;
+		});
+		TEST_CHECK(isValid);
+
+		printf("%3zu MiB save: ValidateSaveContainer %6.2f GiB/s, table CRC %6.2f GiB/s (%.1fx)\n", sizeMb, dispatched, software,
+			dispatched / software);
+	}
+
+	return Test::Result("Crc32cBench");
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "input/InputEventQueue.h"
+#include "threading/Sys_Threading.h"
+
+#include "TestUtils.h"
+
+/*
+ * Stress test of the hand-off between the input thread and the game thread (Input::ButtonEventQueue).
+ *
+ * The producer publishes TRANSITION_COUNT polls as fast as it can, every poll toggles one pseudo-random button of
+ * pads 0-2. Pad 3 carries the poll index instead of buttons, so the consumer knows exactly which polls a frame
+ * covers. The consumer drains frames concurrently, now and then sleeping so the ring runs full and edges get
+ * merged, and replays the same sequence: every frame has to report exactly the presses and releases of its polls,
+ * and how often each button was pressed. A lost, duplicated or misplaced edge fails the test, and so does a
+ * double tap that a merge collapsed into one press.
+ */
+
+constexpr uint32_t TRANSITION_COUNT = 2000000u;
+constexpr uint32_t SEQUENCE_PAD = Input::MAX_GAMEPADS - 1u;
+// the consumer sleeps every this many frames, long enough for the producer to overflow the ring
+constexpr uint32_t STALL_INTERVAL = 256u;
+constexpr uint32_t STALL_MICROSECONDS = 2000u;
+
+/*
+ * The button every poll toggles, producer and consumer run their own copy
+ */
+class TransitionSequence {
+public:
+	void Next(uint32_t& pad, int& button) {
+		m_State ^= m_State << 13;
+		m_State ^= m_State >> 17;
+		m_State ^= m_State << 5;
+		pad = m_State % SEQUENCE_PAD;
+		button = 1 << ((m_State >> 8) % Input::GAMEPAD_BUTTON_COUNT);
+	}
+
+private:
+	uint32_t m_State = 0x2545F491u;
+};
+
+struct SharedState
+{
+	Input::ButtonEventQueue queue;
+	// the consumer saw the last poll, the producer stops publishing
+	std::atomic<bool> isDrained { false };
+};
+
+SharedState shared;
+
+void ProducerMain(void*) {
+	int states[Input::MAX_GAMEPADS] = {};
+	TransitionSequence sequence;
+
+	for (uint32_t poll = 1u; poll <= TRANSITION_COUNT; ++poll) {
+		uint32_t pad = 0u;
+		int button = 0;
+		sequence.Next(pad, button);
+		states[pad] ^= button;
+		states[SEQUENCE_PAD] = static_cast<int>(poll);
+		shared.queue.Publish(states, Clock::Now());
+	}
+
+	// like the input thread, keep polling: edges that found the ring full go out with a later poll
+	while (!shared.isDrained.load(std::memory_order_acquire)) {
+		shared.queue.Publish(states, Clock::Now());
+		Sys_Yield();
+	}
+}
+
+int main() {
+	Clock::Init();
+
+	threadCreateParam_t params;
+	params.function = ProducerMain;
+	params.name = "Producer";
+	const threadHandle_t producer = Sys_CreateThread(params);
+	TEST_CHECK(producer != INVALID_THREAD_HANDLE);
+
+	TransitionSequence sequence;
+	int expectedStates[SEQUENCE_PAD] = {};
+	uint32_t consumedPolls = 0u;
+	uint64_t frames = 0u;
+	uint64_t checkedEdges = 0u;
+	uint32_t wrongFrames = 0u;
+	// buttons pressed more than once within a frame
+	uint64_t multiplePresses = 0u;
+
+	while (consumedPolls < TRANSITION_COUNT && producer != INVALID_THREAD_HANDLE) {
+		shared.queue.BeginFrame();
+		++frames;
+
+		const uint32_t polls = static_cast<uint32_t>(shared.queue.GetStates(SEQUENCE_PAD));
+		if (!TEST_CHECK(polls >= consumedPolls && polls <= TRANSITION_COUNT)) {
+			break;
+		}
+
+		// presses / releases the polls of this frame have to produce, several toggles of a button give both
+		int expectedDowns[SEQUENCE_PAD] = {};
+		int expectedUps[SEQUENCE_PAD] = {};
+		uint32_t expectedPressCounts[SEQUENCE_PAD][Input::GAMEPAD_BUTTON_COUNT] = {};
+		for (; consumedPolls < polls; ++consumedPolls) {
+			uint32_t pad = 0u;
+			int button = 0;
+			sequence.Next(pad, button);
+			if ((expectedStates[pad] & button) != 0) {
+				expectedUps[pad] |= button;
+			}
+			else {
+				expectedDowns[pad] |= button;
+				++expectedPressCounts[pad][Input::LowestBitIndex(static_cast<uint32_t>(button))];
+			}
+			expectedStates[pad] ^= button;
+			++checkedEdges;
+		}
+
+		bool isFrameCorrect = true;
+		for (uint32_t pad = 0u; pad < SEQUENCE_PAD; ++pad) {
+			const Input::InputFrame frame = shared.queue.GetFrame(pad);
+			isFrameCorrect = isFrameCorrect && frame.pressed == expectedDowns[pad] && frame.released == expectedUps[pad]
+				&& shared.queue.GetStates(pad) == expectedStates[pad];
+			for (uint32_t button = 0u; button < Input::GAMEPAD_BUTTON_COUNT; ++button) {
+				const uint32_t expected = expectedPressCounts[pad][button];
+				isFrameCorrect = isFrameCorrect && frame.pressCounts[button] == (expected < UINT8_MAX ? expected : UINT8_MAX);
+				multiplePresses += expected > 1u ? 1u : 0u;
+			}
+		}
+		if (!isFrameCorrect && wrongFrames++ < 10u) {
+			printf("frame %llu (polls up to %u) doesn't match the published edges\n", static_cast<unsigned long long>(frames), polls);
+		}
+
+		if (frames % STALL_INTERVAL == 0u) {
+			Sys_Sleep(STALL_MICROSECONDS);
+		}
+	}
+
+	shared.isDrained.store(true, std::memory_order_release);
+	Sys_WaitForThread(producer);
+	Sys_DestroyThread(producer);
+
+	printf("%llu transitions in %llu frames, %u polls found the ring full, %llu buttons pressed more than once in a frame\n",
+		static_cast<unsigned long long>(checkedEdges), static_cast<unsigned long long>(frames), shared.queue.GetOverflowCount(),
+		static_cast<unsigned long long>(multiplePresses));
+
+	TEST_CHECK(wrongFrames == 0u);
+	TEST_CHECK(consumedPolls == TRANSITION_COUNT);
+	// the stalls have to exercise the merging of edges that didn't fit
+	TEST_CHECK(shared.queue.GetOverflowCount() > 0u);
+	TEST_CHECK(multiplePresses > 0u);
+	return Test::Result("InputEventQueueTest");
+}
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "input/InputEventQueue.h"
+#include "input/InputLatency.h"
+
+#include "TestUtils.h"
+
+/*
+ * Input latency reporting (Input::LatencyHistogram and the poll-to-frame measurement of ButtonEventQueue).
+ *
+ * The histogram is fed distributions with known percentiles: it has to be exact in the linear range and stay
+ * within its documented 12.5% bucket error above it. Then a press, its release and the action it triggers are
+ * published with poll timestamps in the past: the frame that delivers them has to record each of them once, with
+ * at least the age of its poll, whether or not anything queries them.
+ */
+
+// relative error of a log-linear bucket with 8 sub-buckets per power of two
+constexpr float BUCKET_ERROR = 0.125f;
+
+bool IsNear(float value, float expected, float relativeError) {
+	return std::fabs(value - expected) <= expected * relativeError;
+}
+
+void CheckLinearRange() {
+	Input::LatencyHistogram histogram;
+	for (int64_t microseconds = 0; microseconds < 10; ++microseconds) {
+		histogram.Record(Duration::FromMicroseconds(microseconds));
+	}
+
+	const Input::InputLatencyStats stats = histogram.GetStats();
+	TEST_CHECK(stats.samples == 10u);
+	TEST_CHECK(stats.p50Ms == 0.004f);
+	TEST_CHECK(stats.p90Ms == 0.008f);
+	TEST_CHECK(stats.maxMs == 0.009f);
+	TEST_CHECK(IsNear(stats.meanMs, 0.0045f, 0.001f));
+}
+
+void CheckUniformDistribution() {
+	// 1us .. 20ms in 1us steps, the percentiles are 10ms, 18ms and 19.8ms
+	Input::LatencyHistogram histogram;
+	constexpr int64_t SAMPLES = 20000;
+	for (int64_t microseconds = 1; microseconds <= SAMPLES; ++microseconds) {
+		histogram.Record(Duration::FromMicroseconds(microseconds));
+	}
+
+	const Input::InputLatencyStats stats = histogram.GetStats();
+	TEST_CHECK(stats.samples == static_cast<uint32_t>(SAMPLES));
+	TEST_CHECK(IsNear(stats.p50Ms, 10.0f, BUCKET_ERROR));
+	TEST_CHECK(IsNear(stats.p90Ms, 18.0f, BUCKET_ERROR));
+	TEST_CHECK(IsNear(stats.p99Ms, 19.8f, BUCKET_ERROR));
+	TEST_CHECK(stats.p99Ms <= stats.maxMs);
+	TEST_CHECK(IsNear(stats.maxMs, 20.0f, 0.0001f));
+	TEST_CHECK(IsNear(stats.meanMs, 10.0f, 0.001f));
+
+	histogram.Reset();
+	TEST_CHECK(histogram.GetStats().samples == 0u);
+	TEST_CHECK(histogram.GetStats().p99Ms == 0.0f);
+}
+
+void CheckTail() {
+	// 99% of the samples at 4ms, 1% at 50ms: p50 and p90 must not see the tail, p99 sits right on its edge
+	Input::LatencyHistogram histogram;
+	for (uint32_t i = 0u; i < 990u; ++i) {
+		histogram.Record(Duration::FromMilliseconds(4));
+	}
+	for (uint32_t i = 0u; i < 10u; ++i) {
+		histogram.Record(Duration::FromMilliseconds(50));
+	}
+
+	const Input::InputLatencyStats stats = histogram.GetStats();
+	TEST_CHECK(IsNear(stats.p50Ms, 4.0f, BUCKET_ERROR));
+	TEST_CHECK(IsNear(stats.p90Ms, 4.0f, BUCKET_ERROR));
+	TEST_CHECK(IsNear(stats.p99Ms, 4.0f, BUCKET_ERROR));
+	TEST_CHECK(stats.maxMs == 50.0f);
+
+	// negative latencies (clock skew between threads) count as zero
+	histogram.Reset();
+	histogram.Record(Duration::FromMicroseconds(-5));
+	TEST_CHECK(histogram.GetStats().maxMs == 0.0f);
+}
+
+void CheckPollToFrame() {
+	constexpr int64_t POLL_AGE_MS = 3;
+	const int button = Input::ButtonBit(Input::GamepadButtons::FACE_BUTTON_DOWN);
+	const TimePoint polled = Clock::Now() - Duration::FromMilliseconds(POLL_AGE_MS);
+
+	Input::ButtonEventQueue queue;
+	const Input::ActionBinding bindings[] = { Input::ChordBinding("Jump", 0u, button) };
+	queue.GetActionMap().SetBindings(bindings);
+	int states[Input::MAX_GAMEPADS] = {};
+	states[1] = button;
+	queue.Publish(states, polled);
+	states[1] = 0;
+	queue.Publish(states, polled + Duration::FromMilliseconds(1));
+	queue.BeginFrame();
+
+	TEST_CHECK(queue.GetDownTime(1u, button) == polled);
+	TEST_CHECK(queue.GetUpTime(1u, button) == polled + Duration::FromMilliseconds(1));
+	TEST_CHECK(queue.GetFrame(1u).actionsTriggered == Input::ActionBit(0u));
+
+	// press, release and action start, measured by the frame; queries don't add anything
+	queue.ConsumeDowns(1u, button);
+	queue.ConsumeUps(1u, button);
+	const Input::InputLatencyStats stats = queue.GetLatencyStats();
+	TEST_CHECK(stats.samples == 3u);
+	TEST_CHECK(stats.maxMs >= static_cast<float>(POLL_AGE_MS));
+	TEST_CHECK(stats.p50Ms >= static_cast<float>(POLL_AGE_MS) * (1.0f - BUCKET_ERROR));
+
+	// the next frame delivers nothing new
+	queue.BeginFrame();
+	TEST_CHECK(queue.GetLatencyStats().samples == 3u);
+
+	queue.ResetLatencyStats();
+	TEST_CHECK(queue.GetLatencyStats().samples == 0u);
+}
+
+int main() {
+	Clock::Init();
+
+	CheckLinearRange();
+	CheckUniformDistribution();
+	CheckTail();
+	CheckPollToFrame();
+
+	return Test::Result("InputLatencyTest");
+}
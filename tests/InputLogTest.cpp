@@ -0,0 +1,141 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "input/AnalogInput.h"
+#include "input/InputEventQueue.h"
+#include "input/InputLog.h"
+
+#include "TestUtils.h"
+
+/*
+ * Record / replay round trip of the input log (Input::InputRecorder, Input::InputReplayer).
+ *
+ * POLL_COUNT polls of pseudo-random buttons and axes on all pads are recorded, with runs of unchanged polls in
+ * between so the tick deltas get exercised. The log is then replayed at MAXIMUM speed with one poll per frame:
+ * every frame has to show the recorded buttons of every pad, and the processed axes have to match an
+ * AnalogInput that was fed the same polls quantized the way the log stores them.
+ */
+
+constexpr const char* LOG_PATH = "InputLogTest.log";
+constexpr uint32_t POLL_COUNT = 5000u;
+constexpr uint32_t POLL_RATE = 1000u;
+
+uint32_t randomState = 0x2545F491u;
+
+uint32_t NextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+float RandomAxis(bool isSigned) {
+	const float value = static_cast<float>(NextRandom() % 20001u) / 10000.0f - 1.0f;
+	return isSigned ? value : (value + 1.0f) * 0.5f;
+}
+
+struct Poll
+{
+	int states[Input::MAX_GAMEPADS] = {};
+	Input::AnalogSample analog;
+};
+
+/*
+ * Mostly small changes: a pad keeps its values for a while, then one of buttons or axes changes
+ */
+void NextPoll(Poll& poll) {
+	if (NextRandom() % 4u == 0u) {
+		return;
+	}
+
+	const uint32_t pad = NextRandom() % Input::MAX_GAMEPADS;
+	if (NextRandom() % 2u == 0u) {
+		poll.states[pad] = static_cast<int>(NextRandom() & ((1u << Input::GAMEPAD_BUTTON_COUNT) - 1u));
+	}
+	else {
+		const uint32_t stick = pad * 2u + NextRandom() % 2u;
+		poll.analog.stickX[stick] = RandomAxis(true);
+		poll.analog.stickY[stick] = RandomAxis(true);
+		poll.analog.triggers[stick] = RandomAxis(false);
+	}
+}
+
+Input::AnalogSample Quantized(const Poll& poll) {
+	Input::AnalogSample sample;
+	for (uint32_t pad = 0u; pad < Input::MAX_GAMEPADS; ++pad) {
+		int buttons = 0;
+		Input::FromLogPad(Input::ToLogPad(poll.states[pad], poll.analog, pad), pad, buttons, sample);
+	}
+	return sample;
+}
+
+int main() {
+	Clock::Init();
+
+	Poll poll;
+	Poll recorded[POLL_COUNT];
+	Input::InputRecorder recorder;
+	TEST_CHECK(recorder.Start(LOG_PATH, POLL_RATE));
+	for (uint32_t i = 0u; i < POLL_COUNT; ++i) {
+		NextPoll(poll);
+		recorded[i] = poll;
+		recorder.Record(poll.states, poll.analog);
+	}
+	recorder.Stop();
+
+	Input::InputReplayer replayer;
+	TEST_CHECK(replayer.Start(LOG_PATH, Input::ReplaySpeed::MAXIMUM, POLL_RATE));
+	TEST_CHECK(replayer.GetPollRate() == POLL_RATE);
+
+	Input::ButtonEventQueue events;
+	Input::AnalogInput analog;
+	analog.SetPollRate(POLL_RATE);
+	Input::AnalogInput expectedAnalog;
+	expectedAnalog.SetPollRate(POLL_RATE);
+
+	uint32_t buttonMismatches = 0u;
+	uint32_t axisMismatches = 0u;
+	const TimePoint start = Clock::Now();
+	for (uint32_t i = 0u; i < POLL_COUNT; ++i) {
+		replayer.ReplayFrame(events, analog);
+		events.BeginFrame();
+		analog.BeginFrame();
+
+		expectedAnalog.Publish(Quantized(recorded[i]), start + Duration::FromMilliseconds(i));
+		expectedAnalog.BeginFrame();
+
+		for (uint32_t pad = 0u; pad < Input::MAX_GAMEPADS; ++pad) {
+			buttonMismatches += events.GetStates(pad) != recorded[i].states[pad] ? 1u : 0u;
+			for (uint32_t axis = 0u; axis < Input::GAMEPAD_AXIS_COUNT; ++axis) {
+				const Input::GamepadAxis gamepadAxis = static_cast<Input::GamepadAxis>(axis);
+				axisMismatches += analog.GetAxis(pad, gamepadAxis) != expectedAnalog.GetAxis(pad, gamepadAxis) ? 1u : 0u;
+			}
+		}
+	}
+	TEST_CHECK(buttonMismatches == 0u);
+	TEST_CHECK(axisMismatches == 0u);
+	TEST_CHECK(replayer.IsFinished());
+
+	// the quantization keeps the axes within half a step of 1/32767
+	int buttons = 0;
+	Input::AnalogSample sample;
+	sample.stickX[0] = 0.123456f;
+	sample.triggers[1] = 1.5f;
+	Input::AnalogSample restored;
+	Input::FromLogPad(Input::ToLogPad(0, sample, 0u), 0u, buttons, restored);
+	TEST_CHECK(restored.stickX[0] - sample.stickX[0] < 1.0f / 32767.0f && sample.stickX[0] - restored.stickX[0] < 1.0f / 32767.0f);
+	TEST_CHECK(restored.triggers[1] == 1.0f);
+
+	// a log of the old single pad format is rejected rather than misread
+	FILE* file = fopen(LOG_PATH, "wb");
+	Input::InputLogHeader header;
+	header.version = 1u;
+	header.pollRate = POLL_RATE;
+	fwrite(&header, sizeof(header), 1u, file);
+	fclose(file);
+	TEST_CHECK(!replayer.Start(LOG_PATH, Input::ReplaySpeed::MAXIMUM, POLL_RATE));
+
+	remove(LOG_PATH);
+	return Test::Result("InputLogTest");
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "threading/Sys_JobSystem.h"
+
+#include "TestUtils.h"
+
+/*
+ * Keeps far more than MAX_JOBS jobs outstanding, from a pool worker (the main thread) and from a thread outside
+ * of the pool at the same time, so pool slots and the injection ring wrap while their jobs may still be queued.
+ * Every job has to run exactly once, a reused slot would run a job twice and lose another one. The thread outside
+ * of the pool waits for busy slots and its jobs, it must never run a job itself meanwhile.
+ *
+ * After the shutdown, a job has to run right away on the submitting thread instead of waiting for a pool forever.
+ */
+
+constexpr uint32_t JOBS_PER_SUBMITTER = JobSystem::MAX_JOBS * 4u;
+constexpr uint32_t SUBMITTER_COUNT = 2u;
+constexpr uint32_t CHILDREN_PER_PARENT = 8u;
+
+std::atomic<uint8_t> runCounts[SUBMITTER_COUNT * JOBS_PER_SUBMITTER];
+std::atomic<uint32_t> jobsOutsideOfPool { 0u };
+thread_local bool isOutsideOfPool = false;
+
+void CountJob(void* params) {
+	runCounts[reinterpret_cast<uintptr_t>(params)].fetch_add(1u, std::memory_order_relaxed);
+	if (isOutsideOfPool) {
+		jobsOutsideOfPool.fetch_add(1u, std::memory_order_relaxed);
+	}
+}
+
+void SetFlag(void* params) {
+	*static_cast<bool*>(params) = true;
+}
+
+/*
+ * Submits its jobs in groups, every group is a parent with children, the parent is only waited on at the very end
+ */
+void Submit(uint32_t submitter) {
+	const uintptr_t first = submitter * JOBS_PER_SUBMITTER;
+	jobHandle_t lastParent = INVALID_JOB_HANDLE;
+
+	for (uintptr_t index = first; index < first + JOBS_PER_SUBMITTER; index += CHILDREN_PER_PARENT + 1u) {
+		jobHandle_t parent = Sys_CreateJob(CountJob, reinterpret_cast<void*>(index));
+		for (uintptr_t child = 1u; child <= CHILDREN_PER_PARENT && index + child < first + JOBS_PER_SUBMITTER; ++child) {
+			Sys_RunJob(Sys_CreateJob(CountJob, reinterpret_cast<void*>(index + child), parent));
+		}
+		Sys_RunJob(parent);
+		lastParent = parent;
+	}
+
+	Sys_WaitForJob(lastParent);
+}
+
+void SubmitterMain(void*) {
+	isOutsideOfPool = true;
+	Submit(1u);
+}
+
+int main() {
+	Clock::Init();
+	// more workers than cores on small machines too, the point is the contention on the pool
+	Sys_InitJobSystem(4u);
+
+	threadCreateParam_t params;
+	params.function = SubmitterMain;
+	params.name = "Submitter";
+	const threadHandle_t submitter = Sys_CreateThread(params);
+	TEST_CHECK(submitter != INVALID_THREAD_HANDLE);
+
+	Submit(0u);
+	Sys_WaitForThread(submitter);
+	Sys_DestroyThread(submitter);
+
+	// the last groups of either submitter may still be running on other workers
+	for (uint32_t i = 0u; i < JobSystem::MAX_JOBS; ++i) {
+		Sys_WaitForJob(&JobSystem::jobPool[i]);
+	}
+
+	uint32_t missing = 0u;
+	uint32_t repeated = 0u;
+	for (const std::atomic<uint8_t>& runCount : runCounts) {
+		missing += runCount.load() == 0u ? 1u : 0u;
+		repeated += runCount.load() > 1u ? 1u : 0u;
+	}
+
+	const jobSystemStats_t stats = Sys_GetJobSystemStats();
+	printf("%u jobs on %u workers, %u never ran, %u ran more than once\n", SUBMITTER_COUNT * JOBS_PER_SUBMITTER,
+		stats.workerCount, missing, repeated);
+	Sys_ShutdownJobSystem();
+
+	bool hasRun = false;
+	jobHandle_t job = Sys_CreateJob(SetFlag, &hasRun);
+	Sys_RunJob(job);
+	TEST_CHECK(hasRun && Sys_IsJobFinished(job));
+
+	TEST_CHECK(missing == 0u);
+	TEST_CHECK(repeated == 0u);
+	TEST_CHECK(jobsOutsideOfPool.load() == 0u);
+	return Test::Result("JobSystemTest");
+}
@@ -0,0 +1,83 @@
+// the tests build with RELEASE, which would compile the profiler out
+#define PROFILER_ENABLED 1
+
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "core/Profiler.h"
+
+#include "TestUtils.h"
+
+/*
+ * Cost of one PROFILE_SCOPE zone, split into its parts: the two timestamp reads (rdtsc, the rdtscp alternative
+ * for comparison) and the recording into the thread's ring. Every measurement runs ITERATIONS times in a loop
+ * and is reported per iteration, the loop overhead is measured separately and subtracted.
+ */
+
+constexpr uint32_t ITERATIONS = 20000000u;
+// best of this many runs, the first ones also warm up the ring and the caches
+constexpr uint32_t RUNS = 5u;
+
+volatile uint64_t sink = 0u;
+
+template <typename Body>
+double MeasureNanoseconds(Body body) {
+	double best = 0.0;
+	for (uint32_t run = 0u; run < RUNS; ++run) {
+		const TimePoint start = Clock::Now();
+		for (uint32_t i = 0u; i < ITERATIONS; ++i) {
+			body(i);
+		}
+		const double nanoseconds = static_cast<double>((Clock::Now() - start).ToNanoseconds()) / ITERATIONS;
+		best = run == 0u || nanoseconds < best ? nanoseconds : best;
+	}
+	return best;
+}
+
+int main() {
+	Clock::Init();
+	Profiler::Init();
+
+	const double loop = MeasureNanoseconds([](uint32_t i) {
+		sink = i;
+	});
+	const double zone = MeasureNanoseconds([](uint32_t i) {
+		PROFILE_SCOPE("ProfilerBench");
+		sink = i;
+	});
+	const double rdtsc = MeasureNanoseconds([](uint32_t i) {
+		const uint64_t begin = Profiler::QueryTicks();
+		sink = i;
+		sink = Profiler::QueryTicks() - begin;
+	});
+	const double record = MeasureNanoseconds([](uint32_t i) {
+		Profiler::Record("ProfilerBench", i, i + 1u);
+		sink = i;
+	});
+#if PROFILER_USE_TSC
+	const double rdtscp = MeasureNanoseconds([](uint32_t i) {
+		unsigned int processor = 0u;
+		const uint64_t begin = __rdtscp(&processor);
+		sink = i;
+		sink = __rdtscp(&processor) - begin;
+	});
+#endif
+
+	// the zones still in the ring arrive in the statistics, minus the slot the writer may be overwriting
+	Profiler::EndFrame();
+	ProfileZoneStats stats[Profiler::MAX_ZONE_NAMES];
+	const uint32_t count = Profiler::GetZoneStats(stats, Profiler::MAX_ZONE_NAMES);
+	TEST_CHECK(count == 1u);
+	TEST_CHECK(count == 1u && stats[0].calls + 1u >= Profiler::ZONES_PER_THREAD);
+
+	printf("loop overhead               %6.2f ns\n", loop);
+	printf("PROFILE_SCOPE zone          %6.2f ns\n", zone - loop);
+	printf("  timestamp pair            %6.2f ns\n", rdtsc - loop);
+	printf("  recording into the ring   %6.2f ns\n", record - loop);
+#if PROFILER_USE_TSC
+	printf("rdtscp pair, for comparison %6.2f ns\n", rdtscp - loop);
+#endif
+
+	return Test::Result("ProfilerBench");
+}
@@ -0,0 +1,199 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <dirent.h>
+
+#include "core/Clock.h"
+#include "core/Profiler.h"
+#include "save/SaveSystemAPI.h"
+
+#include "TestUtils.h"
+
+/*
+ * Crashes a save at every commit step (SaveData::commitFaultHook) and checks what a restarted game loads: the
+ * old generation or, if Save reported success, the new one, never anything else. Afterwards a normal save has
+ * to go through again. Every case runs with a small full snapshot, a large snapshot and a large journal delta.
+ */
+
+constexpr const char* SAVE_DIRECTORY = "SaveCommitTest.saves";
+constexpr const char* SAVE_NAME = "slot.dat";
+constexpr size_t SMALL_PAYLOAD = 64u;
+// several journal chunks
+constexpr size_t LARGE_PAYLOAD = SaveData::SAVE_CHUNK_SIZE * 16u;
+
+const SaveData::CommitStep STEPS[] = {
+	SaveData::CommitStep::OPEN_TEMP,
+	SaveData::CommitStep::WRITE_TEMP,
+	SaveData::CommitStep::FLUSH_TEMP,
+	SaveData::CommitStep::CLOSE_TEMP,
+	SaveData::CommitStep::ROTATE_BACKUP,
+	SaveData::CommitStep::RENAME_TEMP,
+	SaveData::CommitStep::FLUSH_DIRECTORY,
+	SaveData::CommitStep::APPEND_JOURNAL,
+	SaveData::CommitStep::FLUSH_JOURNAL,
+};
+constexpr uint32_t STEP_COUNT = sizeof(STEPS) / sizeof(STEPS[0]);
+
+enum class Variant
+{
+	SMALL_SNAPSHOT,
+	LARGE_SNAPSHOT,
+	LARGE_DELTA,
+};
+
+const char* ToString(Variant variant) {
+	switch (variant) {
+		case Variant::SMALL_SNAPSHOT: return "small snapshot";
+		case Variant::LARGE_SNAPSHOT: return "large snapshot";
+		case Variant::LARGE_DELTA: return "large delta";
+	}
+	return "";
+}
+
+// the step to fail at, only its first occurrence fails
+SaveData::CommitStep faultStep = SaveData::CommitStep::OPEN_TEMP;
+bool hasFaulted = false;
+
+bool FailAtStep(SaveData::CommitStep step) {
+	if (hasFaulted || step != faultStep) {
+		return false;
+	}
+	hasFaulted = true;
+	return true;
+}
+
+void RemoveSaveFile(const char* fileName, void*) {
+	char path[SaveData::MAX_SAVE_PATH_LENGTH];
+	const int length = snprintf(path, sizeof(path), "%s/%s", SAVE_DIRECTORY, fileName);
+	if (length > 0 && length < static_cast<int>(sizeof(path))) {
+		remove(path);
+	}
+}
+
+uint32_t CountOpenFiles() {
+	uint32_t count = 0u;
+	DIR* listing = opendir("/proc/self/fd");
+	while (listing != nullptr && readdir(listing) != nullptr) {
+		++count;
+	}
+	if (listing != nullptr) {
+		closedir(listing);
+	}
+	return count;
+}
+
+/*
+ * Generation `generation` of the payload, a delta generation only changes two chunks of the previous one
+ */
+std::vector<byte> MakePayload(Variant variant, uint32_t generation) {
+	std::vector<byte> payload(variant == Variant::SMALL_SNAPSHOT ? SMALL_PAYLOAD : LARGE_PAYLOAD);
+	for (size_t i = 0u; i < payload.size(); ++i) {
+		payload[i] = static_cast<byte>(i * 131u + (variant == Variant::LARGE_DELTA ? 0u : generation * 7u));
+	}
+	if (variant == Variant::LARGE_DELTA) {
+		payload[SaveData::SAVE_CHUNK_SIZE * 3u] = static_cast<byte>(generation);
+		payload[SaveData::SAVE_CHUNK_SIZE * 9u + 5u] = static_cast<byte>(generation * 3u);
+	}
+	return payload;
+}
+
+bool Save(SaveData::SaveSystem& system, std::vector<byte>& payload) {
+	SaveData::SaveFile save;
+	save.data = payload.data();
+	save.length = payload.size();
+	return system.Save(save, SAVE_NAME);
+}
+
+/*
+ * Loads the slot like a restarted game would
+ */
+std::vector<byte> LoadRestarted() {
+	SaveData::SaveSystem system;
+	system.Initialize(SAVE_DIRECTORY);
+	const SaveData::SaveFile* save = system.Load(SAVE_NAME);
+	std::vector<byte> payload;
+	if (save != nullptr && save->IsValid()) {
+		payload.assign(save->data, save->data + save->length);
+	}
+	system.Shutdown();
+	return payload;
+}
+
+/*
+ * Returns whether the fault was hit, the small and large snapshots never touch the journal steps and a delta
+ * only the journal steps
+ */
+bool RunCase(Variant variant, SaveData::CommitStep step) {
+	SaveData::ListSaveDirectory(SAVE_DIRECTORY, RemoveSaveFile, nullptr);
+
+	std::vector<byte> oldPayload = MakePayload(variant, 1u);
+	std::vector<byte> newPayload = MakePayload(variant, 2u);
+	std::vector<byte> recoveredPayload = MakePayload(variant, 3u);
+
+	bool isSaved = false;
+	{
+		SaveData::SaveSystem system;
+		system.Initialize(SAVE_DIRECTORY);
+		TEST_CHECK(Save(system, oldPayload));
+		if (variant == Variant::LARGE_DELTA) {
+			// the journal only takes deltas on top of a snapshot it started itself
+			TEST_CHECK(Save(system, oldPayload));
+		}
+
+		faultStep = step;
+		hasFaulted = false;
+		SaveData::commitFaultHook = FailAtStep;
+		isSaved = Save(system, newPayload);
+		SaveData::commitFaultHook = nullptr;
+		system.Shutdown();
+	}
+
+	const std::vector<byte> loaded = LoadRestarted();
+	const bool isOld = loaded == oldPayload;
+	const bool isNew = loaded == newPayload;
+	if (!TEST_CHECK(isNew || (isOld && !isSaved))) {
+		printf("  %s, fault at step %d (%s): loaded %zu bytes, %s\n", ToString(variant), static_cast<int>(step),
+			hasFaulted ? "hit" : "not reached", loaded.size(), isOld ? "old generation after a successful save" : "neither generation");
+	}
+
+	// the next save after the crash has to go through
+	{
+		SaveData::SaveSystem system;
+		system.Initialize(SAVE_DIRECTORY);
+		TEST_CHECK(Save(system, recoveredPayload));
+		system.Shutdown();
+	}
+	TEST_CHECK(LoadRestarted() == recoveredPayload);
+	return hasFaulted;
+}
+
+int main() {
+	Clock::Init();
+	Profiler::Init();
+
+	const uint32_t openFiles = CountOpenFiles();
+	uint32_t faultedCases = 0u;
+
+	const Variant variants[] = { Variant::SMALL_SNAPSHOT, Variant::LARGE_SNAPSHOT, Variant::LARGE_DELTA };
+	for (SaveData::CommitStep step : STEPS) {
+		bool isStepCovered = false;
+		for (Variant variant : variants) {
+			const bool hasFaulted = RunCase(variant, step);
+			faultedCases += hasFaulted ? 1u : 0u;
+			isStepCovered = isStepCovered || hasFaulted;
+		}
+		if (!TEST_CHECK(isStepCovered)) {
+			printf("  no save reached step %d\n", static_cast<int>(step));
+		}
+	}
+
+	SaveData::ListSaveDirectory(SAVE_DIRECTORY, RemoveSaveFile, nullptr);
+	remove(SAVE_DIRECTORY);
+
+	printf("%u cases, %u hit their fault\n", STEP_COUNT * 3u, faultedCases);
+	// an aborted commit must not leak its file handles
+	TEST_CHECK(CountOpenFiles() == openFiles);
+	return Test::Result("SaveCommitTest");
+}
@@ -0,0 +1,150 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "core/Clock.h"
+#include "core/Profiler.h"
+#include "core/TickScheduler.h"
+#include "save/SaveSystemAPI.h"
+#include "threading/Sys_JobSystem.h"
+
+#include "TestUtils.h"
+
+/*
+ * Saves a payload of several compression blocks over and over while the tick scheduler injects ticks that load
+ * the same slot, like the game's simulation does. The job system has a single worker (the main thread), so a
+ * save that waited for its compression jobs while holding the file mutex, or a save I/O thread that ran an
+ * injected tick, deadlocks. A watchdog fails the test instead of hanging, and every tick has to run on the worker.
+ */
+
+constexpr const char* SAVE_DIRECTORY = "SaveCompressionTest.saves";
+constexpr const char* SAVE_NAME = "slot.dat";
+constexpr size_t PAYLOAD_SIZE = 1024u * 1024u;
+constexpr uint32_t SAVE_COUNT = 20u;
+constexpr uint32_t LOAD_RATE = 1000u;
+constexpr uint32_t SAVE_RATE = 100u;
+constexpr uint32_t TIMEOUT_SECONDS = 60u;
+
+struct Run
+{
+	SaveData::SaveSystem system;
+	TickScheduler scheduler;
+	std::vector<byte> payload = std::vector<byte>(PAYLOAD_SIZE);
+	threadHandle_t workerThread = INVALID_THREAD_HANDLE;
+	std::atomic<uint32_t> ticksOffWorker { 0u };
+	uint32_t submittedSaves = 0u;
+	uint32_t writtenSaves = 0u;
+	uint32_t failedSaves = 0u;
+	uint32_t loads = 0u;
+	std::atomic<bool> isFinished { false };
+};
+
+Run run;
+
+void CheckThread() {
+	if (Sys_GetCurrentThreadID() != run.workerThread) {
+		run.ticksOffWorker.fetch_add(1u);
+	}
+}
+
+void LoadTick(const TickInfo&, void*) {
+	CheckThread();
+	const SaveData::SaveView view = run.system.LoadView(SAVE_NAME);
+	run.loads += view.IsValid() ? 1u : 0u;
+}
+
+void OnSaved(SaveData::SaveHandle, SaveData::SaveStatus status, void*) {
+	run.writtenSaves += status == SaveData::SaveStatus::SUCCEEDED ? 1u : 0u;
+	run.failedSaves += status == SaveData::SaveStatus::FAILED ? 1u : 0u;
+}
+
+/*
+ * Every byte changes, so each save is a compressed full snapshot rather than a journal delta
+ */
+SaveData::SaveFile NextPayload() {
+	++run.submittedSaves;
+	for (size_t i = 0u; i < PAYLOAD_SIZE; ++i) {
+		run.payload[i] = static_cast<byte>(i / 16u + run.submittedSaves);
+	}
+	SaveData::SaveFile save;
+	save.data = run.payload.data();
+	save.length = PAYLOAD_SIZE;
+	return save;
+}
+
+void SaveTick(const TickInfo&, void*) {
+	CheckThread();
+	run.system.Update();
+	if (run.writtenSaves + run.failedSaves >= SAVE_COUNT) {
+		run.scheduler.Stop();
+		return;
+	}
+	run.system.SaveAsync(NextPayload(), SAVE_NAME, OnSaved, nullptr);
+}
+
+void WatchdogMain(void*) {
+	for (uint32_t i = 0u; i < TIMEOUT_SECONDS * 10u; ++i) {
+		if (run.isFinished.load()) {
+			return;
+		}
+		Sys_Sleep(100000u);
+	}
+	printf("no progress after %u seconds: %u of %u saves written, %u loads\n", TIMEOUT_SECONDS, run.writtenSaves, SAVE_COUNT, run.loads);
+	fflush(stdout);
+	std::_Exit(1);
+}
+
+int main() {
+	Clock::Init();
+	Profiler::Init();
+	// the main thread is the only worker, nothing else can run the compression jobs or the ticks
+	Sys_InitJobSystem(1u);
+	run.workerThread = Sys_GetCurrentThreadID();
+
+	threadCreateParam_t params;
+	params.function = WatchdogMain;
+	params.name = "Watchdog";
+	const threadHandle_t watchdog = Sys_CreateThread(params);
+	TEST_CHECK(watchdog != INVALID_THREAD_HANDLE);
+
+	TEST_CHECK(run.system.Initialize(SAVE_DIRECTORY));
+	// synchronously on the worker, so the first loads find a save
+	TEST_CHECK(run.system.Save(NextPayload(), SAVE_NAME));
+
+	TickSubsystemDesc load;
+	load.name = "Load";
+	load.function = LoadTick;
+	load.mode = TickMode::FIXED_RATE;
+	load.ticksPerSecond = LOAD_RATE;
+	TEST_CHECK(run.scheduler.Register(load) != TickScheduler::INVALID_SUBSYSTEM);
+
+	TickSubsystemDesc save;
+	save.name = "Save";
+	save.function = SaveTick;
+	save.mode = TickMode::FIXED_RATE;
+	save.ticksPerSecond = SAVE_RATE;
+	TEST_CHECK(run.scheduler.Register(save) != TickScheduler::INVALID_SUBSYSTEM);
+
+	run.scheduler.Run(threadPriority_t::NORMAL);
+	run.system.Shutdown();
+
+	run.isFinished.store(true);
+	Sys_WaitForThread(watchdog);
+	Sys_DestroyThread(watchdog);
+
+	const SaveData::SaveStats stats = run.system.GetSaveStats();
+	printf("%u saves written, %llu compressed, %u loads\n", run.writtenSaves, static_cast<unsigned long long>(stats.compressedSaves), run.loads);
+
+	TEST_CHECK(run.writtenSaves >= SAVE_COUNT && run.failedSaves == 0u);
+	TEST_CHECK(stats.compressedSaves > 0u && stats.compressionInputBytes >= PAYLOAD_SIZE);
+	TEST_CHECK(run.loads > 0u);
+	TEST_CHECK(run.ticksOffWorker.load() == 0u);
+
+	const SaveData::SaveView view = run.system.LoadView(SAVE_NAME);
+	TEST_CHECK(view.IsValid() && view.GetLength() == PAYLOAD_SIZE);
+
+	Sys_ShutdownJobSystem();
+	return Test::Result("SaveCompressionTest");
+}
@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "save/SaveIOQueue.h"
+
+#include "TestUtils.h"
+
+/*
+ * Floods the I/O queue with coalesced saves of one slot while the worker is busy with slow writes, so the
+ * worker finishes handles far older than the STATUS_SLOTS most recent ones. The recent handles have to keep
+ * reporting their status, and every request has to complete exactly once: written or superseded.
+ *
+ * Then more saves than the completion ring holds are submitted without dispatching, Stop has to deliver all of
+ * their callbacks.
+ */
+
+constexpr uint32_t SUBMIT_COUNT = 10000u;
+constexpr uint32_t SLOW_WRITE_MICROSECONDS = 20000u;
+// several hundred submits pile up behind every write
+constexpr uint32_t SUBMIT_INTERVAL_MICROSECONDS = 5u;
+
+class TestSaveSystem {
+public:
+	bool Save(const SaveData::SaveFile&, const char*) {
+		Sys_Sleep(writeMicroseconds);
+		return true;
+	}
+
+	uint32_t writeMicroseconds = SLOW_WRITE_MICROSECONDS;
+};
+
+uint32_t completions[SUBMIT_COUNT] = {};
+uint32_t writtenSaves = 0u;
+uint32_t supersededSaves = 0u;
+
+void OnSaved(SaveData::SaveHandle, SaveData::SaveStatus status, void* userData) {
+	TEST_CHECK(status == SaveData::SaveStatus::SUCCEEDED || status == SaveData::SaveStatus::SUPERSEDED);
+	++completions[reinterpret_cast<uintptr_t>(userData)];
+	writtenSaves += status == SaveData::SaveStatus::SUCCEEDED ? 1u : 0u;
+	supersededSaves += status == SaveData::SaveStatus::SUPERSEDED ? 1u : 0u;
+}
+
+uint32_t undispatchedSaves = 0u;
+
+void OnUndispatchedSaved(SaveData::SaveHandle, SaveData::SaveStatus status, void*) {
+	TEST_CHECK(status == SaveData::SaveStatus::SUCCEEDED);
+	++undispatchedSaves;
+}
+
+int main() {
+	using namespace SaveData;
+	typedef SaveIOQueue<TestSaveSystem> Queue;
+
+	Clock::Init();
+
+	TestSaveSystem system;
+	Queue queue(&system);
+	queue.Start();
+
+	byte payload[64] = {};
+	SaveFile save;
+	save.data = payload;
+	save.length = sizeof(payload);
+
+	SaveHandle handles[SUBMIT_COUNT] = {};
+	uint32_t unknownStatuses = 0u;
+
+	for (uint32_t i = 0u; i < SUBMIT_COUNT; ++i) {
+		payload[0] = static_cast<byte>(i);
+		handles[i] = queue.Submit(save, "slot", OnSaved, reinterpret_cast<void*>(static_cast<uintptr_t>(i)));
+		TEST_CHECK(handles[i] != INVALID_SAVE_HANDLE);
+
+		// the newest STATUS_SLOTS handles own their slots, none of them may have been overwritten by the worker
+		const uint32_t oldest = i + 1u >= Queue::STATUS_SLOTS ? i + 1u - Queue::STATUS_SLOTS : 0u;
+		for (uint32_t j = oldest; j <= i; ++j) {
+			unknownStatuses += queue.GetStatus(handles[j]) == SaveStatus::UNKNOWN ? 1u : 0u;
+		}
+		queue.DispatchCompletions();
+		Sys_Sleep(SUBMIT_INTERVAL_MICROSECONDS);
+	}
+
+	while (queue.GetStatus(handles[SUBMIT_COUNT - 1u]) != SaveStatus::SUCCEEDED) {
+		queue.DispatchCompletions();
+		Sys_Sleep(1000u);
+	}
+	queue.DispatchCompletions();
+
+	const SaveStats stats = queue.GetStats();
+	printf("%llu saves requested, %llu written, %u superseded, %u recent statuses read as unknown\n",
+		static_cast<unsigned long long>(stats.requestedSaves), static_cast<unsigned long long>(stats.physicalWrites), supersededSaves,
+		unknownStatuses);
+
+	uint32_t wrongCompletions = 0u;
+	for (uint32_t i = 0u; i < SUBMIT_COUNT; ++i) {
+		wrongCompletions += completions[i] != 1u ? 1u : 0u;
+	}
+	TEST_CHECK(wrongCompletions == 0u);
+	TEST_CHECK(unknownStatuses == 0u);
+	TEST_CHECK(queue.GetStatus(handles[SUBMIT_COUNT - 1u]) == SaveStatus::SUCCEEDED);
+	TEST_CHECK(queue.GetStatus(handles[SUBMIT_COUNT - 2u]) == SaveStatus::SUPERSEDED);
+	// one callback per write, the replaced requests only report that they were superseded
+	TEST_CHECK(writtenSaves == stats.physicalWrites && supersededSaves == stats.coalescedSaves);
+	// otherwise the worker never finished a handle whose slot was taken over
+	TEST_CHECK(stats.physicalWrites > 1u && stats.physicalWrites < SUBMIT_COUNT);
+
+	// distinct slots don't coalesce, every save is one write and one completion that nobody dispatches
+	// more than the completion ring holds: it fills up, one request is stuck in the worker and the rest stay queued
+	const uint32_t undispatchedCount = Queue::MAX_COMPLETIONS + Queue::MAX_PENDING_SAVES;
+	system.writeMicroseconds = 0u;
+	for (uint32_t i = 0u; i < undispatchedCount; ++i) {
+		char name[MAX_SAVE_NAME_LENGTH];
+		snprintf(name, sizeof(name), "slot%u", i);
+		// MAX_PENDING_SAVES slots are queued already, wait for the worker to take one
+		while (queue.Submit(save, name, OnUndispatchedSaved, nullptr) == INVALID_SAVE_HANDLE) {
+			Sys_Sleep(1000u);
+		}
+	}
+	queue.Stop();
+	TEST_CHECK(undispatchedSaves == undispatchedCount);
+
+	return Test::Result("SaveIOQueueTest");
+}
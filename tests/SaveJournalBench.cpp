@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "core/Clock.h"
+#include "core/Profiler.h"
+#include "save/SaveSystemAPI.h"
+
+#include "TestUtils.h"
+
+/*
+ * Full snapshot vs. journaled delta saves of 1, 10 and 100 MiB payloads where a few chunks change per save.
+ *
+ * Full: every save goes through a fresh SaveSystem, which has no journal for the slot yet and writes the whole
+ * snapshot (the behaviour before the journal). Delta: one SaveSystem keeps saving, appending the changed chunks
+ * and compacting into a new snapshot whenever the journal grows past half the payload. Only the Save calls are
+ * timed, compression is off so both paths write the same bytes. Usage: SaveJournalBench [saves per size]
+ */
+
+constexpr const char* SAVE_DIRECTORY = "SaveJournalBench.saves";
+constexpr const char* SAVE_NAME = "bench.dat";
+constexpr size_t PAYLOAD_SIZES_MB[] = { 1u, 10u, 100u };
+constexpr uint32_t DEFAULT_SAVES = 10u;
+// chunks a typical save changes
+constexpr uint32_t CHANGED_CHUNKS = 4u;
+
+uint32_t randomState = 0x9E3779B9u;
+
+uint32_t NextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+void RemoveSaveFile(const char* fileName, void*) {
+	char path[SaveData::MAX_SAVE_PATH_LENGTH];
+	const int length = snprintf(path, sizeof(path), "%s/%s", SAVE_DIRECTORY, fileName);
+	if (length > 0 && length < static_cast<int>(sizeof(path))) {
+		remove(path);
+	}
+}
+
+void ChangeChunks(std::vector<byte>& payload) {
+	const size_t chunkCount = payload.size() / SaveData::SAVE_CHUNK_SIZE;
+	for (uint32_t i = 0u; i < CHANGED_CHUNKS; ++i) {
+		const size_t chunk = NextRandom() % chunkCount;
+		payload[chunk * SaveData::SAVE_CHUNK_SIZE + NextRandom() % SaveData::SAVE_CHUNK_SIZE] ^= 0x5Au;
+	}
+}
+
+struct Result
+{
+	Duration saveTime;
+	uint64_t bytesWritten = 0u;
+	uint64_t snapshotWrites = 0u;
+	uint64_t deltaWrites = 0u;
+};
+
+bool Save(SaveData::SaveSystem& system, std::vector<byte>& payload, Result& result) {
+	SaveData::SaveFile save;
+	save.data = payload.data();
+	save.length = payload.size();
+
+	const SaveData::SaveStats before = system.GetSaveStats();
+	const TimePoint start = Clock::Now();
+	const bool isSaved = system.Save(save, SAVE_NAME);
+	result.saveTime += Clock::Now() - start;
+
+	const SaveData::SaveStats after = system.GetSaveStats();
+	result.bytesWritten += after.bytesWritten - before.bytesWritten;
+	result.snapshotWrites += after.snapshotWrites - before.snapshotWrites;
+	result.deltaWrites += after.deltaWrites - before.deltaWrites;
+	return isSaved;
+}
+
+Result RunFull(std::vector<byte>& payload, uint32_t saves) {
+	Result result;
+	for (uint32_t i = 0u; i < saves; ++i) {
+		ChangeChunks(payload);
+		SaveData::SaveSystem system;
+		system.Initialize(SAVE_DIRECTORY);
+		system.SetCompressionEnabled(false);
+		TEST_CHECK(Save(system, payload, result));
+		system.Shutdown();
+	}
+	return result;
+}
+
+Result RunDelta(std::vector<byte>& payload, uint32_t saves) {
+	SaveData::SaveSystem system;
+	system.Initialize(SAVE_DIRECTORY);
+	system.SetCompressionEnabled(false);
+
+	// the base snapshot the journal starts from isn't part of the measurement
+	Result base;
+	TEST_CHECK(Save(system, payload, base));
+
+	Result result;
+	for (uint32_t i = 0u; i < saves; ++i) {
+		ChangeChunks(payload);
+		TEST_CHECK(Save(system, payload, result));
+	}
+
+	// the journal has to reassemble exactly the last state
+	const SaveData::SaveFile* loaded = system.Load(SAVE_NAME);
+	TEST_CHECK(loaded != nullptr && loaded->length == payload.size() && std::equal(payload.begin(), payload.end(), loaded->data));
+	system.Shutdown();
+	return result;
+}
+
+void Print(const char* name, const Result& result, uint32_t saves) {
+	printf("  %-5s %8.2f ms/save %10.1f KiB/save  (%llu snapshots, %llu deltas)\n", name, result.saveTime.ToMillisecondsF() / saves,
+		static_cast<double>(result.bytesWritten) / saves / 1024.0, static_cast<unsigned long long>(result.snapshotWrites),
+		static_cast<unsigned long long>(result.deltaWrites));
+}
+
+int main(int argc, char** argv) {
+	Clock::Init();
+	Profiler::Init();
+
+	const uint32_t saves = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : DEFAULT_SAVES;
+	if (saves == 0u) {
+		printf("usage: %s [saves per size]\n", argv[0]);
+		return 1;
+	}
+
+	for (size_t sizeMb : PAYLOAD_SIZES_MB) {
+		std::vector<byte> payload(sizeMb * 1024u * 1024u);
+		for (byte& value : payload) {
+			value = static_cast<byte>(NextRandom());
+		}
+
+		SaveData::ListSaveDirectory(SAVE_DIRECTORY, RemoveSaveFile, nullptr);
+		const Result full = RunFull(payload, saves);
+		SaveData::ListSaveDirectory(SAVE_DIRECTORY, RemoveSaveFile, nullptr);
+		const Result delta = RunDelta(payload, saves);
+
+		printf("%zu MiB payload, %u saves changing %u chunks each:\n", sizeMb, saves, CHANGED_CHUNKS);
+		Print("full", full, saves);
+		Print("delta", delta, saves);
+		printf("  delta writes %.1fx fewer bytes, saves %.1fx faster\n",
+			static_cast<double>(full.bytesWritten) / static_cast<double>(delta.bytesWritten),
+			static_cast<double>(full.saveTime.ToNanoseconds()) / static_cast<double>(delta.saveTime.ToNanoseconds()));
+	}
+
+	SaveData::ListSaveDirectory(SAVE_DIRECTORY, RemoveSaveFile, nullptr);
+	remove(SAVE_DIRECTORY);
+	return Test::Result("SaveJournalBench");
+}
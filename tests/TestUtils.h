@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdio>
+
+/*
+ * Minimal checks for the tests in this directory. A failing TEST_CHECK prints the expression and where it failed
+ * and the test keeps going, so one run reports every failure. main returns Test::Result.
+ */
+namespace Test
+{
+	int failures = 0;
+
+	inline bool Check(bool condition, const char* expression, const char* file, int line) {
+		if (!condition) {
+			++failures;
+			printf("%s:%d: check failed: %s\n", file, line, expression);
+		}
+		return condition;
+	}
+
+	/*
+	 * Prints the verdict, 0 when every check passed (the process exit code)
+	 */
+	inline int Result(const char* name) {
+		printf("%s: %s (%d failed checks)\n", name, failures == 0 ? "passed" : "FAILED", failures);
+		return failures == 0 ? 0 : 1;
+	}
+}
+
+#define TEST_CHECK(condition) Test::Check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,110 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "core/Clock.h"
+#include "core/TickScheduler.h"
+#include "threading/Sys_JobSystem.h"
+
+#include "TestUtils.h"
+
+/*
+ * TickScheduler with a 1 kHz poll on the scheduler thread (runOnSchedulerThread) and a 100 Hz fixed step on the
+ * job system workers, once at normal and once at real-time priority.
+ *
+ * The poll has to run on the scheduler thread every time and the step never, the latency percentiles have to be
+ * ordered, and at real-time priority the scheduler may only spin for a small share of its waiting time
+ * (MAX_REALTIME_SPIN_MICROSECONDS before every 1 ms deadline).
+ */
+
+constexpr uint32_t POLL_RATE = 1000u;
+constexpr uint32_t STEP_RATE = 100u;
+constexpr uint64_t STEP_COUNT = 100u;
+// generous, the cap allows 2% at 1 kHz
+constexpr float MAX_REALTIME_SPIN_RATIO = 0.1f;
+
+struct Run
+{
+	TickScheduler scheduler;
+	std::atomic<threadHandle_t> schedulerThread { INVALID_THREAD_HANDLE };
+	std::atomic<uint32_t> pollsOffThread { 0u };
+	std::atomic<uint32_t> stepsOnThread { 0u };
+	uint64_t steps = 0u;
+};
+
+void PollTick(const TickInfo&, void* userData) {
+	Run& run = *static_cast<Run*>(userData);
+	threadHandle_t expected = INVALID_THREAD_HANDLE;
+	const threadHandle_t current = Sys_GetCurrentThreadID();
+	if (!run.schedulerThread.compare_exchange_strong(expected, current) && expected != current) {
+		run.pollsOffThread.fetch_add(1u);
+	}
+}
+
+void StepTick(const TickInfo&, void* userData) {
+	Run& run = *static_cast<Run*>(userData);
+	if (Sys_GetCurrentThreadID() == run.schedulerThread.load()) {
+		run.stepsOnThread.fetch_add(1u);
+	}
+	if (++run.steps == STEP_COUNT) {
+		run.scheduler.Stop();
+	}
+}
+
+void CheckRun(threadPriority_t priority) {
+	Run run;
+
+	TickSubsystemDesc poll;
+	poll.name = "Poll";
+	poll.function = PollTick;
+	poll.userData = &run;
+	poll.mode = TickMode::FIXED_RATE;
+	poll.ticksPerSecond = POLL_RATE;
+	poll.priority = 1u;
+	poll.runOnSchedulerThread = true;
+	TEST_CHECK(run.scheduler.Register(poll) != TickScheduler::INVALID_SUBSYSTEM);
+
+	TickSubsystemDesc step;
+	step.name = "Step";
+	step.function = StepTick;
+	step.userData = &run;
+	step.mode = TickMode::FIXED_STEP;
+	step.ticksPerSecond = STEP_RATE;
+	TEST_CHECK(run.scheduler.Register(step) != TickScheduler::INVALID_SUBSYSTEM);
+
+	run.scheduler.Run(priority);
+
+	TEST_CHECK(run.schedulerThread.load() != INVALID_THREAD_HANDLE && run.schedulerThread.load() != Sys_GetCurrentThreadID());
+	TEST_CHECK(run.pollsOffThread.load() == 0u);
+	TEST_CHECK(run.stepsOnThread.load() == 0u);
+	TEST_CHECK(run.steps == STEP_COUNT);
+
+	TickSubsystemStats stats[TickScheduler::MAX_SUBSYSTEMS];
+	TEST_CHECK(run.scheduler.GetStats(stats, TickScheduler::MAX_SUBSYSTEMS) == 2u);
+	for (uint32_t i = 0u; i < 2u; ++i) {
+		TEST_CHECK(stats[i].ticks > 0u);
+		TEST_CHECK(stats[i].p50LatencyMs <= stats[i].p99LatencyMs && stats[i].p99LatencyMs <= stats[i].maxLatencyMs);
+		printf("  %-4s %5llu ticks, latency p50 %.3fms p99 %.3fms max %.3fms\n", stats[i].name, static_cast<unsigned long long>(stats[i].ticks),
+			stats[i].p50LatencyMs, stats[i].p99LatencyMs, stats[i].maxLatencyMs);
+	}
+
+	const TickSchedulerStats schedulerStats = run.scheduler.GetSchedulerStats();
+	TEST_CHECK(schedulerStats.spinRatio >= 0.0f && schedulerStats.spinRatio <= 1.0f);
+	if (priority != threadPriority_t::NORMAL) {
+		TEST_CHECK(schedulerStats.spinRatio < MAX_REALTIME_SPIN_RATIO);
+	}
+	printf("  sleep overshoot %.3fms, spin ratio %.3f\n", schedulerStats.sleepOvershootMs, schedulerStats.spinRatio);
+}
+
+int main() {
+	Clock::Init();
+	Sys_InitJobSystem(2u);
+
+	printf("normal priority:\n");
+	CheckRun(threadPriority_t::NORMAL);
+	printf("real-time priority:\n");
+	CheckRun(threadPriority_t::HIGH);
+
+	Sys_ShutdownJobSystem();
+	return Test::Result("TickSchedulerTest");
+}